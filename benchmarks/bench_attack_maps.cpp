@@ -0,0 +1,70 @@
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <weechess/attack_maps.h>
+
+#include "positions.h"
+
+using namespace weechess;
+
+namespace {
+
+    // Blockers taken from the positions a step into each kind of game, so lookups land on the same parts of the
+    // tables that a search does
+    std::vector<BitBoard> blockers()
+    {
+        std::vector<BitBoard> result;
+        for (auto fen : { benchmarks::positions::opening, benchmarks::positions::middlegame,
+                 benchmarks::positions::endgame, benchmarks::positions::promotions }) {
+            for (const auto& child : benchmarks::positions::children_of(fen))
+                result.push_back(child.board.shared_occupancy());
+        }
+
+        return result;
+    }
+
+    template <typename Lookup>
+    void slider_lookups(benchmark::State& state, attack_maps::SliderBackend backend, Lookup lookup)
+    {
+        auto initial_backend = attack_maps::slider_backend();
+        if (!attack_maps::set_slider_backend(backend)) {
+            state.SkipWithError("The slider backend isn't supported on this CPU");
+            return;
+        }
+
+        auto occupancies = blockers();
+        for (auto _ : state) {
+            for (const auto& occupancy : occupancies) {
+                for (uint8_t i = 0; i < 64; i++)
+                    benchmark::DoNotOptimize(lookup(Location(i), occupancy));
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(occupancies.size()) * 64);
+        attack_maps::set_slider_backend(initial_backend);
+    }
+
+    void rook_attacks(benchmark::State& state, attack_maps::SliderBackend backend)
+    {
+        slider_lookups(state, backend, attack_maps::generate_rook_attacks);
+    }
+
+    void bishop_attacks(benchmark::State& state, attack_maps::SliderBackend backend)
+    {
+        slider_lookups(state, backend, attack_maps::generate_bishop_attacks);
+    }
+
+    void queen_attacks(benchmark::State& state, attack_maps::SliderBackend backend)
+    {
+        slider_lookups(state, backend, attack_maps::generate_queen_attacks);
+    }
+
+}
+
+BENCHMARK_CAPTURE(rook_attacks, magic, attack_maps::SliderBackend::Magic);
+BENCHMARK_CAPTURE(rook_attacks, pext, attack_maps::SliderBackend::Pext);
+BENCHMARK_CAPTURE(bishop_attacks, magic, attack_maps::SliderBackend::Magic);
+BENCHMARK_CAPTURE(bishop_attacks, pext, attack_maps::SliderBackend::Pext);
+BENCHMARK_CAPTURE(queen_attacks, magic, attack_maps::SliderBackend::Magic);
+BENCHMARK_CAPTURE(queen_attacks, pext, attack_maps::SliderBackend::Pext);
@@ -0,0 +1,59 @@
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <weechess/book.h>
+#include <weechess/zobrist.h>
+
+#include "positions.h"
+
+using namespace weechess;
+
+namespace {
+
+    // The replies to the first move, most of which are in the book
+    std::vector<GameSnapshot> book_positions()
+    {
+        std::vector<GameSnapshot> result;
+        for (const auto& child : benchmarks::positions::children_of(benchmarks::positions::opening)) {
+            GameState game_state(child);
+            for (const auto& legal_move : game_state.move_set().legal_moves())
+                result.push_back(legal_move.snapshot());
+        }
+
+        return result;
+    }
+
+    void book_lookup_hash(benchmark::State& state)
+    {
+        std::vector<zobrist::Hash> hashes;
+        for (const auto& snapshot : book_positions())
+            hashes.push_back(snapshot.zobrist_hash());
+
+        const auto& book = Book::default_instance;
+        for (auto _ : state) {
+            for (auto hash : hashes)
+                benchmark::DoNotOptimize(book.lookup(hash));
+        }
+
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(hashes.size()));
+    }
+
+    // Including hashing the position and decoding its moves
+    void book_lookup_position(benchmark::State& state)
+    {
+        auto snapshots = book_positions();
+
+        const auto& book = Book::default_instance;
+        for (auto _ : state) {
+            for (const auto& snapshot : snapshots)
+                benchmark::DoNotOptimize(book.lookup(snapshot));
+        }
+
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(snapshots.size()));
+    }
+
+}
+
+BENCHMARK(book_lookup_hash);
+BENCHMARK(book_lookup_position);
@@ -0,0 +1,45 @@
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <weechess/evaluator.h>
+
+#include "positions.h"
+
+using namespace weechess;
+
+namespace {
+
+    void evaluate(benchmark::State& state, std::string_view fen)
+    {
+        auto snapshots = benchmarks::positions::children_of(fen);
+        Evaluator evaluator;
+
+        for (auto _ : state) {
+            for (const auto& snapshot : snapshots)
+                benchmark::DoNotOptimize(evaluator.evaluate(snapshot));
+        }
+
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(snapshots.size()));
+    }
+
+    // The batched form that the tuner uses
+    void evaluate_batch(benchmark::State& state, std::string_view fen)
+    {
+        auto snapshots = benchmarks::positions::children_of(fen);
+        std::vector<Evaluation> evaluations(snapshots.size());
+        Evaluator evaluator;
+
+        for (auto _ : state) {
+            evaluator.evaluate(snapshots, evaluations);
+            benchmark::DoNotOptimize(evaluations.data());
+            benchmark::ClobberMemory();
+        }
+
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(snapshots.size()));
+    }
+
+}
+
+WEECHESS_BENCHMARK_POSITIONS(evaluate);
+WEECHESS_BENCHMARK_POSITIONS(evaluate_batch);
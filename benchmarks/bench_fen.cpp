@@ -0,0 +1,43 @@
+#include <benchmark/benchmark.h>
+
+#include <weechess/fen.h>
+
+#include "positions.h"
+
+using namespace weechess;
+
+namespace {
+
+    void from_fen(benchmark::State& state, std::string_view fen)
+    {
+        for (auto _ : state)
+            benchmark::DoNotOptimize(fen::from_fen(fen));
+
+        state.SetItemsProcessed(state.iterations());
+        state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(fen.size()));
+    }
+
+    void to_fen(benchmark::State& state, std::string_view fen)
+    {
+        auto snapshot = benchmarks::positions::snapshot_of(fen);
+        for (auto _ : state)
+            benchmark::DoNotOptimize(fen::to_fen(snapshot));
+
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void write_fen(benchmark::State& state, std::string_view fen)
+    {
+        auto snapshot = benchmarks::positions::snapshot_of(fen);
+        fen::Buffer buffer;
+        for (auto _ : state)
+            benchmark::DoNotOptimize(fen::write_fen(snapshot, buffer));
+
+        state.SetItemsProcessed(state.iterations());
+    }
+
+}
+
+WEECHESS_BENCHMARK_POSITIONS(from_fen);
+WEECHESS_BENCHMARK_POSITIONS(to_fen);
+WEECHESS_BENCHMARK_POSITIONS(write_fen);
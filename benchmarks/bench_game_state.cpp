@@ -0,0 +1,27 @@
+#include <benchmark/benchmark.h>
+
+#include <weechess/game_state.h>
+#include <weechess/move_generator.h>
+
+#include "positions.h"
+
+using namespace weechess;
+
+namespace {
+
+    void by_performing_move(benchmark::State& state, std::string_view fen)
+    {
+        auto snapshot = benchmarks::positions::snapshot_of(fen);
+        auto legal_moves = MoveGenerator().execute(snapshot).legal_moves;
+
+        for (auto _ : state) {
+            for (const auto& legal_move : legal_moves)
+                benchmark::DoNotOptimize(snapshot.by_performing_move(legal_move.move()));
+        }
+
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(legal_moves.size()));
+    }
+
+}
+
+WEECHESS_BENCHMARK_POSITIONS(by_performing_move);
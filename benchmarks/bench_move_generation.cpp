@@ -0,0 +1,28 @@
+#include <benchmark/benchmark.h>
+
+#include <weechess/move_generator.h>
+
+#include "positions.h"
+
+using namespace weechess;
+
+namespace {
+
+    void move_generator_execute(benchmark::State& state, std::string_view fen)
+    {
+        auto snapshot = benchmarks::positions::snapshot_of(fen);
+        MoveGenerator generator;
+
+        size_t moves = 0;
+        for (auto _ : state) {
+            auto result = generator.execute(snapshot);
+            moves += result.legal_moves.size();
+            benchmark::DoNotOptimize(result);
+        }
+
+        state.SetItemsProcessed(static_cast<int64_t>(moves));
+    }
+
+}
+
+WEECHESS_BENCHMARK_POSITIONS(move_generator_execute);
@@ -0,0 +1,33 @@
+#include <algorithm>
+
+#include <benchmark/benchmark.h>
+
+#include <weechess/move_generator.h>
+#include <weechess/move_sorter.h>
+
+#include "positions.h"
+
+using namespace weechess;
+
+namespace {
+
+    // Sorting a fresh copy of the moves each time, the same way the search orders them
+    void move_sorter_ordering(benchmark::State& state, std::string_view fen)
+    {
+        auto legal_moves = MoveGenerator().execute(benchmarks::positions::snapshot_of(fen)).legal_moves;
+
+        for (auto _ : state) {
+            state.PauseTiming();
+            auto moves = legal_moves;
+            state.ResumeTiming();
+
+            std::sort(moves.begin(), moves.end(), MoveSorter::default_instance);
+            benchmark::DoNotOptimize(moves.data());
+        }
+
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(legal_moves.size()));
+    }
+
+}
+
+WEECHESS_BENCHMARK_POSITIONS(move_sorter_ordering);
@@ -0,0 +1,66 @@
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <weechess/move_generator.h>
+#include <weechess/transposition_table.h>
+
+#include "positions.h"
+
+using namespace weechess;
+
+namespace {
+
+    // Positions two moves into each kind of game, along with a move to store for each
+    std::vector<LegalMove> entries()
+    {
+        std::vector<LegalMove> result;
+        for (auto fen : { benchmarks::positions::opening, benchmarks::positions::middlegame,
+                 benchmarks::positions::endgame, benchmarks::positions::promotions }) {
+            for (const auto& child : benchmarks::positions::children_of(fen)) {
+                auto legal_moves = MoveGenerator().execute(child).legal_moves;
+                result.insert(result.end(), legal_moves.begin(), legal_moves.end());
+            }
+        }
+
+        return result;
+    }
+
+    void transposition_table_store(benchmark::State& state)
+    {
+        auto moves = entries();
+        TranspositionTable table;
+
+        for (auto _ : state) {
+            for (const auto& move : moves)
+                table.insert(move.snapshot(), TranspositionEntry::Type::Exact, move.move(), 4, Evaluation { 25 }, 2);
+
+            benchmark::ClobberMemory();
+        }
+
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(moves.size()));
+    }
+
+    void transposition_table_probe(benchmark::State& state)
+    {
+        auto moves = entries();
+        TranspositionTable table;
+
+        // Every other position is stored, so half of the probes miss
+        for (size_t i = 0; i < moves.size(); i += 2) {
+            const auto& move = moves[i];
+            table.insert(move.snapshot(), TranspositionEntry::Type::Exact, move.move(), 4, Evaluation { 25 }, 2);
+        }
+
+        for (auto _ : state) {
+            for (const auto& move : moves)
+                benchmark::DoNotOptimize(table.find(move.snapshot(), 2));
+        }
+
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(moves.size()));
+    }
+
+}
+
+BENCHMARK(transposition_table_store);
+BENCHMARK(transposition_table_probe);
@@ -0,0 +1,26 @@
+#include <benchmark/benchmark.h>
+
+#include <weechess/zobrist.h>
+
+#include "positions.h"
+
+using namespace weechess;
+
+namespace {
+
+    void zobrist_hash(benchmark::State& state, std::string_view fen)
+    {
+        auto snapshots = benchmarks::positions::children_of(fen);
+        const auto& hasher = zobrist::Hasher::default_instance;
+
+        for (auto _ : state) {
+            for (const auto& snapshot : snapshots)
+                benchmark::DoNotOptimize(hasher.hash(snapshot));
+        }
+
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(snapshots.size()));
+    }
+
+}
+
+WEECHESS_BENCHMARK_POSITIONS(zobrist_hash);
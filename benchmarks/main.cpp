@@ -0,0 +1,18 @@
+#include <benchmark/benchmark.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+int main(int argc, char* argv[])
+{
+    // The library logs through spdlog, but nothing it logs is worth the time while benchmarking
+    auto lib_logger = spdlog::stderr_color_mt("weechess");
+    lib_logger->set_level(spdlog::level::warn);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
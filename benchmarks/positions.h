@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+#include <weechess/fen.h>
+#include <weechess/game_state.h>
+
+// Positions shared by the benchmarks, one for each kind of position the engine spends its time in. Most
+// benchmarks are registered once per position, so a change that only helps (or hurts) one kind shows up
+namespace weechess::benchmarks::positions {
+
+constexpr std::string_view opening = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+constexpr std::string_view middlegame = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+constexpr std::string_view endgame = "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1";
+constexpr std::string_view in_check = "rnbqk1nr/pppp1ppp/8/4p3/1b1PP3/8/PPP2PPP/RNBQKBNR w KQkq - 1 3";
+constexpr std::string_view promotions = "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1";
+
+inline GameSnapshot snapshot_of(std::string_view fen) { return fen::from_fen(fen).value(); }
+
+// The positions one move on from the given one, to give benchmarks a varied batch to work through
+inline std::vector<GameSnapshot> children_of(std::string_view fen)
+{
+    GameState game_state(snapshot_of(fen));
+
+    std::vector<GameSnapshot> children;
+    for (const auto& legal_move : game_state.move_set().legal_moves())
+        children.push_back(legal_move.snapshot());
+
+    return children;
+}
+
+}
+
+// Registers a benchmark once for each kind of position, passing it the position's FEN
+#define WEECHESS_BENCHMARK_POSITIONS(func)                                                                             \
+    BENCHMARK_CAPTURE(func, opening, weechess::benchmarks::positions::opening);                                        \
+    BENCHMARK_CAPTURE(func, middlegame, weechess::benchmarks::positions::middlegame);                                  \
+    BENCHMARK_CAPTURE(func, endgame, weechess::benchmarks::positions::endgame);                                        \
+    BENCHMARK_CAPTURE(func, in_check, weechess::benchmarks::positions::in_check);                                      \
+    BENCHMARK_CAPTURE(func, promotions, weechess::benchmarks::positions::promotions)
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include <weechess/evaluator.h>
+#include <weechess/move.h>
+#include <weechess/transposition_table.h>
+#include <weechess/zobrist.h>
+
+namespace weechess {
+
+class MappedFile;
+struct GameSnapshot;
+
+/*
+Search results that outlive the engine, kept in a file so that analysing the same positions again
+starts from where the last run left off. Only the deepest result for each position is kept, and
+once there are more positions than fit, the shallowest are dropped first.
+
+Most results sit in a table at the start of the file, sorted by hash, which is memory mapped and
+searched in place. Opening a cache only reads what's after it. Newer results are kept in memory
+and appended to the file as they're flushed, each with a checksum, so a run that dies part way
+through a write loses at most the results it was writing. Once there are enough of them, they're
+merged into a new table, which is written to a new file and moved over the old one. A cache file
+should only be written by one engine at a time.
+*/
+class AnalysisCache {
+public:
+    using Value = TranspositionEntry;
+
+    static constexpr size_t default_size_in_bytes = 64 * 1024 * 1024;
+
+    AnalysisCache(const AnalysisCache&) = delete;
+    AnalysisCache(AnalysisCache&&) = delete;
+    AnalysisCache& operator=(const AnalysisCache&) = delete;
+    AnalysisCache& operator=(AnalysisCache&&) = delete;
+
+    // Opens the cache, creating the file if there isn't one. Fails if the file can't be created, or
+    // isn't a cache written by an engine with the same zobrist hashes. The size bounds the file
+    static std::unique_ptr<AnalysisCache> open(
+        const std::filesystem::path&, size_t size_in_bytes = default_size_in_bytes);
+
+    // The same conventions as the transposition table: mate scores are stored relative to the
+    // position, so the ply of the position needs to be provided
+    void insert(const GameSnapshot&, Value::Type, const Move&, size_t depth, Evaluation, size_t ply);
+    std::optional<Value> find(const GameSnapshot&, size_t ply) const;
+
+    // Writes out the results inserted since the last flush
+    bool flush();
+
+    // Merges every result into a new table
+    bool compact();
+
+    size_t size() const;
+    size_t capacity() const;
+
+private:
+    struct Slot {
+        int16_t score;
+        CompactMove move;
+        uint8_t depth;
+        Value::Type type;
+    };
+
+    // A result as it's stored in the file. The checksum covers the rest of the record, so that a
+    // record that was only partly written before a crash is never read back
+    struct Record {
+        zobrist::Hash hash;
+        uint64_t data;
+        uint64_t checksum;
+
+        static Record from(zobrist::Hash, const Slot&);
+        std::optional<Slot> slot() const;
+    };
+
+    AnalysisCache(std::filesystem::path, size_t capacity);
+
+    // These expect the mutex to be held, other than when loading
+    bool load();
+    bool map_table();
+    std::optional<Slot> find_slot(zobrist::Hash) const;
+    std::optional<Slot> find_in_table(zobrist::Hash) const;
+    size_t memory_capacity() const;
+    void evict_shallowest();
+    bool append_records(const std::vector<zobrist::Hash>&) const;
+    bool compact_file();
+
+    std::filesystem::path m_path;
+    size_t m_capacity;
+
+    std::shared_ptr<const MappedFile> m_file {};
+    std::span<const Record> m_table {};
+
+    // Results since the table was written, which take precedence over it
+    mutable std::mutex m_mutex;
+    std::unordered_map<zobrist::Hash, Slot> m_slots;
+    std::vector<zobrist::Hash> m_unwritten;
+    size_t m_records_after_table { 0 };
+};
+
+}
@@ -6,6 +6,20 @@
 
 namespace weechess::attack_maps {
 
+// How rook and bishop attacks are looked up. Pext is only used on CPUs with a fast BMI2
+// implementation, and is chosen automatically at startup when available.
+enum class SliderBackend {
+    Magic,
+    Pext,
+};
+
+SliderBackend slider_backend();
+bool is_slider_backend_supported(SliderBackend);
+
+// Switches slider lookups to the given backend, returning false if the CPU doesn't support it.
+// This isn't synchronized, so it shouldn't be called while anything else may be generating attacks.
+bool set_slider_backend(SliderBackend);
+
 BitBoard generate_rook_attacks(Location location, BitBoard blockers);
 BitBoard generate_bishop_attacks(Location location, BitBoard blockers);
 BitBoard generate_queen_attacks(Location location, BitBoard blockers);
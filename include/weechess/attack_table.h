@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+
+#include <weechess/bit_board.h>
+#include <weechess/color_map.h>
+#include <weechess/location.h>
+
+namespace weechess {
+
+class Board;
+
+// The squares attacked by every piece on a board, indexed by the square the
+// piece stands on. Deriving the table for a child position only regenerates
+// the pieces that moved and the sliders whose rays pass through a changed
+// square, rather than every piece on the board.
+class AttackTable {
+public:
+    AttackTable() = default;
+    explicit AttackTable(const Board&);
+
+    // The table for `board`, given that it differs from the position this
+    // table was built for only on the `changed` squares
+    AttackTable updated(const Board& board, BitBoard changed) const;
+
+    BitBoard attacks_from(Location location) const;
+    BitBoard attacks(Color color) const;
+    BitBoard pawn_attacks(Color color) const;
+
+private:
+    void accumulate(const Board&);
+
+    std::array<BitBoard, 64> m_square_attacks {};
+    ColorMap<BitBoard> m_color_attacks {};
+    ColorMap<BitBoard> m_pawn_attacks {};
+};
+
+}
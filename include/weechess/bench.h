@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include <weechess/move.h>
+
+namespace weechess::bench {
+
+// Searches a fixed set of positions to a fixed depth, from scratch each time and without a book, so that
+// the total number of nodes searched only changes when the search or the evaluation does. That makes
+// the node count a fingerprint of the engine's behaviour, and the node rate a measure of its speed
+
+constexpr size_t default_depth = 5;
+constexpr size_t transposition_table_size_in_bytes = 16 * 1024 * 1024;
+
+// Openings, middlegames, endgames and tactics, along with a few positions without any legal moves
+std::span<const std::string_view> positions();
+
+struct PositionResult {
+    size_t nodes_searched { 0 };
+    std::chrono::milliseconds elapsed_time { 0 };
+
+    // Nothing when there are no legal moves
+    std::optional<Move> best_move {};
+};
+
+struct Result {
+    size_t nodes_searched { 0 };
+    std::chrono::milliseconds elapsed_time { 0 };
+
+    size_t nodes_per_second() const;
+};
+
+// Called after each position has been searched, with its index in `positions()`
+using Reporter = std::function<void(size_t index, const PositionResult&)>;
+
+Result run(size_t depth = default_depth, const Reporter& reporter = {});
+
+}
@@ -7,6 +7,7 @@
 #include <string>
 #include <string_view>
 
+#include <weechess/attack_table.h>
 #include <weechess/bit_board.h>
 #include <weechess/color_map.h>
 #include <weechess/location.h>
@@ -55,8 +56,9 @@ struct Rank {
 struct File {
     uint8_t index;
 
+    // std::tolower isn't constexpr, and file masks are used to build the attack tables at compile time
     constexpr File(char named_file)
-        : index(7 - (std::tolower(named_file) - 'a'))
+        : index(7 - ((named_file | 0x20) - 'a'))
     {
     }
 
@@ -82,31 +84,42 @@ class Board {
 public:
     static constexpr size_t cell_count = 64;
 
+    // The position is stored as one bitboard per piece type and one per color, with
+    // everything else (combined occupancy, the piece on a square, attacks) derived
+    // from these on demand. Boards are copied for every move, so keep this small.
     struct Buffer {
-        std::array<BitBoard, 14> m_occupancy;
+        std::array<BitBoard, 6> m_types {};
+        ColorMap<BitBoard> m_colors {};
 
         Buffer() = default;
 
-        const std::array<BitBoard, 14>& data() const { return m_occupancy; }
+        BitBoard occupancy_for(Piece piece) const;
+        BitBoard occupancy_for(Piece::Type type) const;
+        Piece piece_at(Location location) const;
 
-        BitBoard& occupancy_for(Piece piece);
-        const BitBoard& occupancy_for(Piece piece) const;
+        void set_piece(Piece piece, Location location);
+        void remove_piece(Piece piece, Location location);
     };
 
     Board();
     Board(Buffer);
 
+    // A board derived from `previous`, differing from it only on the `changed` squares
+    Board(Buffer, const Board& previous, BitBoard changed);
+
     Piece piece_at(Location location) const;
     Color color_at(Location location) const;
 
     const Buffer& piece_buffer() const;
-    const BitBoard& occupancy_for(Piece piece) const;
-    const BitBoard& shared_occupancy() const;
+    BitBoard occupancy_for(Piece piece) const;
+    BitBoard shared_occupancy() const;
     const ColorMap<BitBoard>& color_occupancy() const;
     BitBoard attacks(Color color) const;
     BitBoard pawn_attacks(Color color) const;
     BitBoard non_occupancy() const;
 
+    bool is_attacked(Location location, Color attacker) const;
+
     std::array<Piece, 64> to_array() const;
 
     class Builder {
@@ -124,10 +137,14 @@ public:
 
 private:
     Buffer m_piece_buffer {};
-    BitBoard m_shared_occupancy {};
-    ColorMap<BitBoard> m_color_occupancy {};
-    ColorMap<BitBoard> m_color_attacks {};
-    ColorMap<BitBoard> m_pawn_attacks {};
+
+#ifdef WEECHESS_INCREMENTAL_ATTACKS
+    AttackTable m_attack_table {};
+#endif
 };
 
+#ifndef WEECHESS_INCREMENTAL_ATTACKS
+static_assert(sizeof(Board) == 64);
+#endif
+
 }
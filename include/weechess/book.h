@@ -1,5 +1,9 @@
 #pragma once
 
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <random>
 #include <span>
 #include <vector>
 
@@ -9,29 +13,83 @@
 
 namespace weechess {
 
+class MappedFile;
+
 class Book {
 public:
+    // Entries and moves are laid out exactly as they're stored in book files, so that a
+    // mapped file can be searched in place
     struct Entry {
         zobrist::Hash hash;
-        size_t offset;
-        size_t count;
+        uint32_t offset;
+        uint32_t count;
+    };
+
+    // How often a move was played from a position and how those games ended. The average Elo is
+    // of the players who made the move, and is zero when none of them were rated
+    struct MoveEntry {
+        CompactMove move;
+        uint16_t average_elo;
+        uint32_t count;
+        uint32_t white_wins;
+        uint32_t draws;
+        uint32_t black_wins;
+
+        // A pessimistic estimate of the score for the player making the move, between 0 and 1: the
+        // lower end of the 95% confidence interval around the score it made. Moves from only a
+        // few games rank below moves that scored as well over many
+        double score(Color) const;
+
+        bool operator==(const MoveEntry&) const = default;
     };
 
     struct Data {
         std::span<const Entry> entries;
-        std::span<const Move> moves;
+        std::span<const MoveEntry> moves;
+    };
+
+    enum class Policy {
+        // Moves are picked in proportion to how often they were played
+        Weighted,
+        // The move with the best score is always picked
+        BestScore,
     };
 
+    struct Selection {
+        Policy policy { Policy::Weighted };
+
+        // Moves played fewer times than this are never picked
+        uint32_t min_count { 1 };
+    };
+
+    // Bumped whenever the layout of book files changes
+    static constexpr uint32_t file_version = 2;
+
     Book();
     Book(Data data);
 
-    std::span<const Move> lookup(const GameSnapshot&) const;
-    std::span<const Move> lookup(const zobrist::Hash&) const;
+    // Opens a book file written by `save`. The file is mapped rather than read, so opening is
+    // cheap no matter the size of the book. Fails if the file isn't a book, was written for
+    // a different version of the format or was keyed with different zobrist hashes
+    static std::optional<Book> open(const std::filesystem::path&);
+    bool save(const std::filesystem::path&) const;
+
+    // Book moves are stored in their compact form, so looking up a position
+    // decodes them against it. Looking up a hash returns them as they're stored
+    std::vector<Move> lookup(const GameSnapshot&) const;
+    std::span<const MoveEntry> lookup(const zobrist::Hash&) const;
+
+    std::optional<Move> select(const GameSnapshot&, const Selection&, std::default_random_engine&) const;
+
+    const Data& data() const;
 
     static const Book default_instance;
 
 private:
     Data m_data;
+
+    // Keeps the mapping alive for as long as any copy of a book opened from a file is around
+    std::shared_ptr<const MappedFile> m_file {};
 };
 
 inline bool operator<(const Book::Entry& lhs, const Book::Entry& rhs) { return lhs.hash < rhs.hash; }
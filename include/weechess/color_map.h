@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+
 #include <weechess/piece.h>
 
 namespace weechess {
@@ -7,46 +9,31 @@ namespace weechess {
 template <typename T> class ColorMap {
 public:
     constexpr ColorMap()
-        : m_white_value()
-        , m_black_value()
+        : m_values()
     {
     }
 
     constexpr ColorMap(T shared_value)
-        : m_white_value(shared_value)
-        , m_black_value(shared_value)
+        : m_values { shared_value, shared_value }
     {
     }
 
     constexpr ColorMap(T white_value, T black_value)
-        : m_white_value(white_value)
-        , m_black_value(black_value)
+        : m_values { white_value, black_value }
     {
     }
 
-    constexpr ColorMap<T> flipped() const { return ColorMap<T>(m_black_value, m_white_value); }
+    constexpr ColorMap<T> flipped() const { return ColorMap<T>(m_values[1], m_values[0]); }
 
-    constexpr T& operator[](Color color)
-    {
-        if (color == Color::White) {
-            return m_white_value;
-        } else {
-            return m_black_value;
-        }
-    }
-
-    constexpr const T& operator[](Color color) const
-    {
-        if (color == Color::White) {
-            return m_white_value;
-        } else {
-            return m_black_value;
-        }
-    }
+    // Looked up by index rather than by comparing the color, so that there's no branch
+    // at runtime, and a color known at compile time folds away to a fixed offset
+    constexpr T& operator[](Color color) { return m_values[index(color)]; }
+    constexpr const T& operator[](Color color) const { return m_values[index(color)]; }
 
 private:
-    T m_white_value;
-    T m_black_value;
+    static constexpr size_t index(Color color) { return static_cast<uint8_t>(color) >> 4; }
+
+    std::array<T, 2> m_values;
 };
 
 }
@@ -1,18 +1,24 @@
 #pragma once
 
 #include <chrono>
+#include <memory>
 #include <optional>
 #include <random>
 
+#include <weechess/analysis_cache.h>
+#include <weechess/book.h>
 #include <weechess/evaluator.h>
+#include <weechess/polyglot_book.h>
 #include <weechess/searcher.h>
 #include <weechess/threading.h>
+#include <weechess/transposition_table.h>
 
 namespace weechess {
 
 struct PerformanceEvent {
     size_t current_depth;
     size_t nodes_searched;
+    size_t quiescence_nodes_searched;
     size_t nodes_per_second;
     std::chrono::duration<size_t, std::milli> elapsed_time;
 };
@@ -35,8 +41,15 @@ struct SearchParameters {
     std::optional<size_t> max_depth {};
     std::optional<size_t> max_nodes {};
     std::optional<std::chrono::duration<size_t, std::milli>> max_search_time { std::chrono::seconds(10) };
+    SearchFeatures features {};
 };
 
+// How long to search for a move when playing on a clock, given the time left and the increment. When the number
+// of moves until the next time control isn't known, the game is assumed to go on for a while yet
+std::chrono::duration<size_t, std::milli> time_for_move(std::chrono::duration<size_t, std::milli> remaining,
+    std::chrono::duration<size_t, std::milli> increment,
+    std::optional<size_t> moves_to_go = {});
+
 struct SearchResult {
     Evaluation evaluation;
     std::vector<Move> best_line;
@@ -47,6 +60,24 @@ class Engine {
     struct Settings {
         unsigned int random_seed { std::random_device()() };
         std::chrono::duration<size_t, std::milli> perf_event_interval { 500 };
+
+        // How often the time limit and the caller's token are checked while searching
+        std::chrono::duration<size_t, std::milli> stop_poll_interval { 1 };
+
+        // Positions found in a book are played straight from it without searching. A Polyglot
+        // book, when there is one, is tried first. Neither is used once the game is more than
+        // `book_depth` plies in
+        Book book { Book::default_instance };
+        Book::Selection book_selection {};
+        std::optional<PolyglotBook> polyglot_book {};
+        size_t book_depth { 100 };
+
+        // Results from earlier searches, which is written to as each search finishes
+        std::shared_ptr<AnalysisCache> analysis_cache {};
+
+        // Kept from one search to the next, so each move of a game picks up where the last left off. A
+        // table of the default size is made by the first search when there isn't one
+        std::shared_ptr<TranspositionTable> transposition_table {};
     };
 
 public:
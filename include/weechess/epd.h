@@ -0,0 +1,51 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <weechess/fen.h>
+#include <weechess/game_state.h>
+#include <weechess/move.h>
+
+namespace weechess {
+namespace epd {
+
+    // An opcode and its operands, as in `bm Qxf7+ Nd5;` or `id "WAC.001";`. Quoted operands are kept
+    // without their quotes
+    struct Operation {
+        std::string opcode;
+        std::vector<std::string> operands;
+    };
+
+    // One line of an EPD file: the position, given as the first four fields of a FEN, followed by its
+    // operations. The clocks are read from the `hmvc` and `fmvn` operations, or from two numeric fields
+    // after the position in files that use whole FENs
+    struct Record {
+        GameSnapshot snapshot;
+        std::vector<Operation> operations;
+
+        const Operation* find(std::string_view opcode) const;
+        std::optional<std::string_view> id() const;
+
+        // The moves an operation like `bm` or `am` names in SAN. Nothing if there's no such operation, or
+        // if any of them doesn't name exactly one legal move in the position
+        std::optional<std::vector<Move>> moves(std::string_view opcode) const;
+    };
+
+    using ParseError = fen::ParseError;
+
+    // Where a file failed to load. The line counts from 1, and is 0 if the file couldn't be read at all
+    struct LoadError {
+        size_t line { 0 };
+        ParseError error {};
+    };
+
+    std::optional<Record> from_epd(std::string_view, ParseError* error = nullptr);
+
+    // Reads every record in a file, skipping blank lines and lines starting with '#'
+    std::optional<std::vector<Record>> load(const std::filesystem::path&, LoadError* error = nullptr);
+}
+}
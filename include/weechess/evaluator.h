@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <span>
+
 #include <weechess/game_state.h>
 #include <weechess/move.h>
 #include <weechess/piece.h>
@@ -36,24 +39,75 @@ struct Evaluation {
 
     constexpr operator int() const { return score; }
 
+    // Mate scores count down from infinity by the number of plies until the mate, so
+    // a quicker mate always scores better than a slower one
+    constexpr bool is_mate() const
+    {
+        return score > mate_in(max_mate_plies).score || score < mated_in(max_mate_plies).score;
+    }
+
+    // The number of full moves until mate, negative if the side to move is getting mated
+    constexpr int moves_until_mate() const
+    {
+        return score > 0 ? (positive_inf().score - score + 1) / 2 : (negative_inf().score - score) / 2;
+    }
+
+    // Mate scores in a search are relative to the root. These convert them to and from
+    // scores relative to the position at the given ply, which is how they're stored
+    constexpr Evaluation relative_to_ply(size_t ply) const
+    {
+        if (!is_mate())
+            return *this;
+        return { score > 0 ? score + static_cast<int>(ply) : score - static_cast<int>(ply) };
+    }
+
+    constexpr Evaluation relative_to_root(size_t ply) const
+    {
+        if (!is_mate())
+            return *this;
+        return { score > 0 ? score - static_cast<int>(ply) : score + static_cast<int>(ply) };
+    }
+
+    constexpr static int max_mate_plies = 1000;
+
     constexpr static Evaluation zero() { return { 0 }; }
     constexpr static Evaluation negative_inf() { return { -100 * piece_worth(Piece::Type::Pawn) }; }
     constexpr static Evaluation positive_inf() { return { +100 * piece_worth(Piece::Type::Pawn) }; }
-    constexpr static Evaluation mate_in(size_t) { return positive_inf(); }
+    constexpr static Evaluation mate_in(size_t plies) { return { positive_inf().score - static_cast<int>(plies) }; }
+    constexpr static Evaluation mated_in(size_t plies) { return { negative_inf().score + static_cast<int>(plies) }; }
 
     constexpr static int piece_worth(Piece::Type type) { return piece_values[static_cast<int>(type)]; }
     constexpr static int pawns(int i) { return piece_values[static_cast<int>(Piece::Type::Pawn)] * i; }
 };
 
+// The tunable terms of the evaluation. Piece-square tables are indexed by
+// piece type and laid out from white's point of view, with a8 at index 0
+struct EvaluatorWeights {
+    std::array<int, 7> material;
+    std::array<std::array<int, 64>, 7> piece_squares;
+    std::array<int, 64> king_end_game_squares;
+};
+
 class Evaluator {
 public:
-    Evaluator() = default;
+    Evaluator();
+    Evaluator(const EvaluatorWeights&);
 
     // Evaluate the given game state
     Evaluation evaluate(const GameState&) const;
     Evaluation operator()(const GameState& state) const { return evaluate(state); }
 
+    // Static evaluation of the position only. Doesn't generate moves, so checkmate
+    // and stalemate aren't detected, but it never allocates
+    Evaluation evaluate(const GameSnapshot&) const;
+    void evaluate(std::span<const GameSnapshot>, std::span<Evaluation>) const;
+
+    const EvaluatorWeights& weights() const;
+
     static const Evaluator default_instance;
+
+private:
+    EvaluatorWeights m_weights;
 };
 
 }
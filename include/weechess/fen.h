@@ -0,0 +1,31 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <weechess/game_state.h>
+
+namespace weechess {
+namespace fen {
+    constexpr std::string_view initial_position = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    // The longest FEN a position can produce: a board with a character for every square, all
+    // castling rights, an en passant target and both counters at their largest
+    constexpr size_t max_length = 71 + 2 + 5 + 3 + 6 + 6;
+    using Buffer = std::array<char, max_length>;
+
+    // Where parsing failed, as an offset into the FEN, and why
+    struct ParseError {
+        size_t position { 0 };
+        std::string_view reason {};
+    };
+
+    std::optional<GameSnapshot> from_fen(std::string_view, ParseError* error = nullptr);
+
+    // Writes the FEN into the buffer, returning the part of the buffer that was used
+    std::string_view write_fen(const GameSnapshot&, Buffer& buffer);
+    std::string to_fen(const GameSnapshot&);
+}
+}
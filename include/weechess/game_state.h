@@ -17,8 +17,8 @@
 namespace weechess {
 
 struct CastleRights {
-    bool can_castle_kingside { true };
-    bool can_castle_queenside { true };
+    bool can_castle_kingside : 1 { true };
+    bool can_castle_queenside : 1 { true };
 
     bool has_rights() const;
 
@@ -33,16 +33,16 @@ struct GameSnapshot {
     ColorMap<CastleRights> castle_rights;
     std::optional<Location> en_passant_target;
 
-    size_t halfmove_clock;
-    size_t fullmove_number;
+    uint16_t halfmove_clock;
+    uint16_t fullmove_number;
 
     GameSnapshot() = default;
     GameSnapshot(Board board,
         Color turn_to_move,
         ColorMap<CastleRights> castle_rights,
         std::optional<Location> en_passant_target,
-        size_t halfmove_clock,
-        size_t fullmove_number);
+        uint16_t halfmove_clock,
+        uint16_t fullmove_number);
 
     std::optional<GameSnapshot> by_performing_move(const Move&) const;
     std::optional<GameSnapshot> by_performing_moves(std::span<const std::shared_ptr<MoveQuery>>) const;
@@ -61,6 +61,10 @@ private:
         const GameSnapshot&, std::span<const std::shared_ptr<MoveQuery>>);
 };
 
+#ifndef WEECHESS_INCREMENTAL_ATTACKS
+static_assert(sizeof(GameSnapshot) <= 80);
+#endif
+
 class LegalMove {
 public:
     LegalMove() = default;
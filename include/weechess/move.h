@@ -1,9 +1,10 @@
 #pragma once
 
 #include <array>
-#include <bitset>
+#include <cstdint>
 #include <optional>
 #include <string>
+#include <type_traits>
 
 #include <weechess/location.h>
 #include <weechess/piece.h>
@@ -16,60 +17,61 @@ enum class CastleSide {
 };
 
 class GameState;
+struct GameSnapshot;
 struct MoveHash;
 
 class Move {
 public:
-    using Data = std::bitset<32>;
+    using Data = uint32_t;
 
-    Move() = default;
-    constexpr Move(Data data)
+    constexpr Move() = default;
+    constexpr explicit Move(Data data)
         : m_data(data)
     {
     }
 
-    Piece moving_piece() const;
-    Piece resulting_piece() const;
+    constexpr Piece moving_piece() const;
+    constexpr Piece resulting_piece() const;
 
-    static Move by_moving(Piece, Location from, Location to);
-    static Move by_capturing(Piece, Location from, Location to, Piece::Type captured);
-    static Move by_promoting(Piece, Location from, Location to, Piece::Type promoted);
-    static Move by_castling(Piece, CastleSide);
-    static Move by_en_passant(Piece, Location from, Location to);
+    static constexpr Move by_moving(Piece, Location from, Location to);
+    static constexpr Move by_capturing(Piece, Location from, Location to, Piece::Type captured);
+    static constexpr Move by_promoting(Piece, Location from, Location to, Piece::Type promoted);
+    static constexpr Move by_castling(Piece, CastleSide);
+    static constexpr Move by_en_passant(Piece, Location from, Location to);
 
     static const Move null;
 
-    Data data() const;
+    constexpr Data data() const;
 
-    Location start_location() const;
-    Location end_location() const;
+    constexpr Location start_location() const;
+    constexpr Location end_location() const;
 
-    bool is_capture() const;
-    bool is_promotion() const;
-    bool is_castle() const;
-    bool is_en_passant() const;
-    bool is_double_pawn() const;
+    constexpr bool is_capture() const;
+    constexpr bool is_promotion() const;
+    constexpr bool is_castle() const;
+    constexpr bool is_en_passant() const;
+    constexpr bool is_double_pawn() const;
 
-    Color color() const;
+    constexpr Color color() const;
 
-    void set_color(Color color);
-    void set_piece_type(Piece::Type type);
-    void set_origin(Location location);
-    void set_destination(Location location);
-    void set_capture(Piece::Type type);
-    void set_promotion(Piece::Type type);
-    void set_double_pawn_push();
+    constexpr void set_color(Color color);
+    constexpr void set_piece_type(Piece::Type type);
+    constexpr void set_origin(Location location);
+    constexpr void set_destination(Location location);
+    constexpr void set_capture(Piece::Type type);
+    constexpr void set_promotion(Piece::Type type);
+    constexpr void set_double_pawn_push();
 
-    Piece::Type captured_piece_type() const;
-    Piece::Type promoted_piece_type() const;
-    std::optional<CastleSide> castle_side() const;
+    constexpr Piece::Type captured_piece_type() const;
+    constexpr Piece::Type promoted_piece_type() const;
+    constexpr std::optional<CastleSide> castle_side() const;
 
     std::string san_notation(const GameState&) const;
     std::string to_string() const;
 
-    friend bool operator==(const Move&, const Move&);
-    friend bool operator!=(const Move&, const Move&);
-    friend bool operator<(const Move&, const Move&);
+    friend constexpr bool operator==(const Move&, const Move&);
+    friend constexpr bool operator!=(const Move&, const Move&);
+    friend constexpr bool operator<(const Move&, const Move&);
 
     friend struct MoveHash;
 
@@ -113,19 +115,233 @@ private:
         28,
     };
 
-    uint32_t get_flags(Flags flags) const;
+    constexpr uint32_t get_flags(Flags flags) const;
 
-    void set_flags(Flags flags, uint32_t value);
+    constexpr void set_flags(Flags flags, uint32_t value);
 
-    Data m_data;
+    Data m_data { 0 };
 };
 
 struct MoveHash {
     std::size_t operator()(const Move& move) const;
 };
 
-bool operator==(const Move& lhs, const Move& rhs);
-bool operator!=(const Move& lhs, const Move& rhs);
-bool operator<(const Move& lhs, const Move& rhs);
+constexpr bool operator==(const Move& lhs, const Move& rhs);
+constexpr bool operator!=(const Move& lhs, const Move& rhs);
+constexpr bool operator<(const Move& lhs, const Move& rhs);
+
+inline constexpr Move Move::null {};
+
+constexpr Move::Data Move::data() const { return m_data; }
+
+constexpr uint32_t Move::get_flags(Flags flags) const
+{
+    return (m_data & masks[static_cast<uint32_t>(flags)]) >> shifts[static_cast<uint32_t>(flags)];
+}
+
+constexpr void Move::set_flags(Flags flags, uint32_t value)
+{
+    m_data &= ~masks[static_cast<uint32_t>(flags)];
+    m_data |= ((value << shifts[static_cast<uint32_t>(flags)]) & masks[static_cast<uint32_t>(flags)]);
+}
+
+constexpr Piece Move::moving_piece() const
+{
+    auto piece_type = static_cast<Piece::Type>(get_flags(Flags::PieceType));
+    return Piece(piece_type, color());
+}
+
+constexpr Piece Move::resulting_piece() const
+{
+    if (is_promotion()) {
+        return Piece(promoted_piece_type(), color());
+    } else {
+        return moving_piece();
+    }
+}
+
+constexpr Color Move::color() const { return get_flags(Flags::Color) == 1 ? Color::White : Color::Black; }
+
+constexpr void Move::set_color(Color color) { set_flags(Flags::Color, color == Color::White ? 1 : 0); }
+constexpr void Move::set_piece_type(Piece::Type type) { set_flags(Flags::PieceType, static_cast<uint32_t>(type)); }
+constexpr void Move::set_origin(Location location) { set_flags(Flags::Origin, location.offset); }
+constexpr void Move::set_destination(Location location) { set_flags(Flags::Destination, location.offset); }
+constexpr void Move::set_capture(Piece::Type type) { set_flags(Flags::Capture, static_cast<uint32_t>(type)); }
+constexpr void Move::set_double_pawn_push() { set_flags(Flags::DoublePawn, 1); }
+constexpr void Move::set_promotion(Piece::Type type)
+{
+    if (type == Piece::Type::None) {
+        set_flags(Flags::Promotion, 0b0000);
+    } else {
+        set_flags(Flags::Promotion, 0b1000 | static_cast<uint32_t>(type));
+    }
+}
+
+constexpr Location Move::start_location() const { return Location(get_flags(Flags::Origin)); }
+constexpr Location Move::end_location() const { return Location(get_flags(Flags::Destination)); }
+
+constexpr bool Move::is_capture() const { return get_flags(Flags::Capture) != 0; }
+constexpr bool Move::is_en_passant() const { return get_flags(Flags::EnPassant) != 0; }
+constexpr bool Move::is_double_pawn() const { return get_flags(Flags::DoublePawn) != 0; }
+constexpr bool Move::is_promotion() const { return (get_flags(Flags::Promotion) & 0b1000) != 0; }
+constexpr bool Move::is_castle() const
+{
+    return (get_flags(Flags::KingsideCastle) != 0) || (get_flags(Flags::QueensideCastle) != 0);
+}
+
+constexpr Piece::Type Move::captured_piece_type() const { return static_cast<Piece::Type>(get_flags(Flags::Capture)); }
+constexpr Piece::Type Move::promoted_piece_type() const
+{
+    return static_cast<Piece::Type>(0b0111 & get_flags(Flags::Promotion));
+}
+
+constexpr std::optional<CastleSide> Move::castle_side() const
+{
+    if (get_flags(Flags::KingsideCastle) != 0) {
+        return CastleSide::Kingside;
+    } else if (get_flags(Flags::QueensideCastle) != 0) {
+        return CastleSide::Queenside;
+    } else {
+        return {};
+    }
+}
+
+constexpr Move Move::by_moving(Piece piece, Location from, Location to)
+{
+    Move move;
+    move.set_piece_type(piece.type);
+    move.set_origin(from);
+    move.set_destination(to);
+    move.set_color(piece.color);
+    return move;
+}
+
+constexpr Move Move::by_capturing(Piece piece, Location from, Location to, Piece::Type captured)
+{
+    Move move = by_moving(piece, from, to);
+    move.set_capture(captured);
+    return move;
+}
+
+constexpr Move Move::by_promoting(Piece piece, Location from, Location to, Piece::Type promotion)
+{
+    Move move = by_moving(piece, from, to);
+    move.set_promotion(promotion);
+    return move;
+}
+
+constexpr Move Move::by_en_passant(Piece piece, Location from, Location to)
+{
+    Move move = by_moving(piece, from, to);
+    move.set_flags(Flags::EnPassant, 1);
+    move.set_capture(Piece::Type::Pawn);
+    return move;
+}
+
+constexpr Move Move::by_castling(Piece piece, CastleSide side)
+{
+    // The king moves two squares along its back rank
+    auto back_rank = piece.color == Color::White ? 0 : 7;
+    auto destination_file = side == CastleSide::Kingside ? 6 : 2;
+
+    Move move = by_moving(piece,
+        Location::from_rank_and_file(back_rank, 4),
+        Location::from_rank_and_file(back_rank, destination_file));
+
+    if (side == CastleSide::Kingside) {
+        move.set_flags(Flags::KingsideCastle, 1);
+    } else {
+        move.set_flags(Flags::QueensideCastle, 1);
+    }
+
+    return move;
+}
+
+constexpr bool operator==(const Move& lhs, const Move& rhs) { return lhs.m_data == rhs.m_data; }
+constexpr bool operator!=(const Move& lhs, const Move& rhs) { return !(lhs == rhs); }
+constexpr bool operator<(const Move& lhs, const Move& rhs) { return lhs.m_data < rhs.m_data; }
+
+static_assert(std::is_trivially_copyable_v<Move>);
+static_assert(sizeof(Move) == sizeof(Move::Data));
+
+/*
+A 16 bit form of a move that only keeps the origin, destination, promotion and a flag for
+special moves. Everything else about the move can be recovered from the position it's made
+in, so this is the form used when lots of moves need to be stored (transposition tables,
+books, etc.) and is decoded back into a full move against the position when it's needed
+*/
+class CompactMove {
+public:
+    using Data = uint16_t;
+
+    constexpr CompactMove() = default;
+    constexpr explicit CompactMove(Data data)
+        : m_data(data)
+    {
+    }
+
+    constexpr CompactMove(const Move&);
+
+    constexpr Data data() const;
+
+    constexpr Location start_location() const;
+    constexpr Location end_location() const;
+
+    // Recovers the full move, or nothing if it doesn't fit the position: the side to move has no piece on
+    // the start square, or the flags don't match the piece. It doesn't check that the move is legal (it may
+    // leave the king in check, or a slider may be blocked), so look it up in the legal moves before playing it
+    std::optional<Move> decode(const GameSnapshot&) const;
+
+    friend constexpr bool operator==(const CompactMove&, const CompactMove&);
+    friend constexpr bool operator!=(const CompactMove&, const CompactMove&);
+
+private:
+    enum class Flag : uint16_t {
+        None,
+        Promotion,
+        EnPassant,
+        Castle,
+    };
+
+    static constexpr uint16_t origin_shift = 0;
+    static constexpr uint16_t destination_shift = 6;
+    static constexpr uint16_t promotion_shift = 12;
+    static constexpr uint16_t flag_shift = 14;
+
+    Flag flag() const;
+    Piece::Type promoted_piece_type() const;
+
+    Data m_data { 0 };
+};
+
+constexpr bool operator==(const CompactMove& lhs, const CompactMove& rhs);
+constexpr bool operator!=(const CompactMove& lhs, const CompactMove& rhs);
+
+constexpr CompactMove::CompactMove(const Move& move)
+{
+    auto flag = Flag::None;
+    auto promotion = 0;
+
+    if (move.is_castle()) {
+        flag = Flag::Castle;
+    } else if (move.is_en_passant()) {
+        flag = Flag::EnPassant;
+    } else if (move.is_promotion()) {
+        flag = Flag::Promotion;
+        promotion = static_cast<int>(move.promoted_piece_type()) - static_cast<int>(Piece::Type::Knight);
+    }
+
+    m_data = static_cast<Data>((move.start_location().offset << origin_shift)
+        | (move.end_location().offset << destination_shift) | (promotion << promotion_shift)
+        | (static_cast<uint16_t>(flag) << flag_shift));
+}
+
+constexpr CompactMove::Data CompactMove::data() const { return m_data; }
+
+constexpr Location CompactMove::start_location() const { return Location((m_data >> origin_shift) & 0b111111); }
+constexpr Location CompactMove::end_location() const { return Location((m_data >> destination_shift) & 0b111111); }
+
+constexpr bool operator==(const CompactMove& lhs, const CompactMove& rhs) { return lhs.m_data == rhs.m_data; }
+constexpr bool operator!=(const CompactMove& lhs, const CompactMove& rhs) { return !(lhs == rhs); }
 
 }
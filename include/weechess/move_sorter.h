@@ -1,5 +1,6 @@
 #pragma once
 
+#include <weechess/evaluator.h>
 #include <weechess/game_state.h>
 #include <weechess/move.h>
 
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace weechess {
+
+class MappedFile;
+
+namespace pgn {
+
+    // A game read from a PGN archive. The views point into the archive's text, so they're only valid for
+    // as long as the text is
+    struct Game {
+        // Tag values are left as they appear in the archive, escapes included
+        std::vector<std::pair<std::string_view, std::string_view>> tags;
+
+        // The main line in SAN, without move numbers or annotations like "!?"
+        std::vector<std::string_view> moves;
+
+        // One of "1-0", "0-1", "1/2-1/2" or "*", or empty if the game's movetext didn't end with one
+        std::string_view result;
+
+        std::optional<std::string_view> tag(std::string_view name) const;
+    };
+
+    // Reads games one at a time from the text of a PGN archive without copying it. Comments, recursive
+    // variations, numeric annotation glyphs and escaped lines are skipped over, as are lines of text
+    // between games that come before the next game's tags or first move number
+    class Reader {
+    public:
+        explicit Reader(std::string_view text);
+
+        // The next game, or nothing once the text has run out
+        std::optional<Game> next();
+
+    private:
+        std::string_view m_text;
+        size_t m_position { 0 };
+
+        bool at_end() const;
+        char peek() const;
+        void skip_line();
+        void skip_comment();
+        void skip_variation();
+        void read_tag(Game&);
+        std::string_view read_symbol();
+    };
+
+    // A whole PGN archive, mapped into memory so that it can be read from any number of threads
+    class Archive {
+    public:
+        static std::optional<Archive> open(const std::filesystem::path&);
+
+        std::string_view text() const;
+        Reader reader() const { return Reader(text()); }
+
+    private:
+        explicit Archive(std::shared_ptr<const MappedFile>);
+
+        std::shared_ptr<const MappedFile> m_file;
+    };
+
+}
+}
@@ -7,6 +7,7 @@
 
 namespace weechess {
 
+// ColorMap is indexed by the black bit, so these values are relied on beyond Piece::to_bits
 enum class Color : uint8_t {
     White = 1 << 3,
     Black = 1 << 4,
@@ -40,43 +41,76 @@ struct Piece {
     Type type;
     Color color;
 
-    Piece();
-    Piece(Type type, Color color);
+    constexpr Piece();
+    constexpr Piece(Type type, Color color);
 
-    bool is(Type) const;
-    bool is(Color) const;
+    constexpr bool is(Type) const;
+    constexpr bool is(Color) const;
 
-    bool exists() const;
-    bool is_none() const;
+    constexpr bool exists() const;
+    constexpr bool is_none() const;
 
     char16_t to_symbol() const;
     char to_letter() const;
 
-    bool operator==(const Piece& other) const;
+    // A single byte form of the piece (type | color), with zero for no piece
+    constexpr uint8_t to_bits() const;
+    static constexpr Piece from_bits(uint8_t);
+
+    constexpr bool operator==(const Piece& other) const;
 
     static Piece none() { return Piece(); }
     static const std::array<Piece, 12> all_valid_pieces;
 };
 
-Color invert_color(Color);
+constexpr Color invert_color(Color color) { return color == Color::White ? Color::Black : Color::White; }
 
-inline Piece::Piece()
+constexpr Piece::Piece()
     : type(Type::None)
     , color(Color::White)
 {
 }
 
-inline Piece::Piece(Type type, Color color)
+constexpr Piece::Piece(Type type, Color color)
     : type(type)
     , color(color)
 {
 }
 
-inline bool Piece::is(Type t) const { return type == t; }
-inline bool Piece::is(Color c) const { return color == c; };
-inline bool Piece::exists() const { return type != Type::None; }
-inline bool Piece::is_none() const { return type == Type::None; }
-inline bool Piece::operator==(const Piece& other) const { return other.type == type && other.color == color; };
+constexpr bool Piece::is(Type t) const { return type == t; }
+constexpr bool Piece::is(Color c) const { return color == c; };
+constexpr bool Piece::exists() const { return type != Type::None; }
+constexpr bool Piece::is_none() const { return type == Type::None; }
+constexpr uint8_t Piece::to_bits() const
+{
+    return is_none() ? 0 : static_cast<uint8_t>(type) | static_cast<uint8_t>(color);
+}
+
+constexpr Piece Piece::from_bits(uint8_t bits)
+{
+    if ((bits & type_mask) == 0)
+        return Piece();
+
+    return Piece(static_cast<Type>(bits & type_mask), static_cast<Color>(bits & color_mask));
+}
+
+constexpr bool Piece::operator==(const Piece& other) const { return other.type == type && other.color == color; };
+
+// Defined out of line since Piece is incomplete in its own body, but still usable at compile time
+inline constexpr std::array<Piece, 12> Piece::all_valid_pieces = {
+    Piece(Piece::Type::Pawn, Color::White),
+    Piece(Piece::Type::Knight, Color::White),
+    Piece(Piece::Type::Bishop, Color::White),
+    Piece(Piece::Type::Rook, Color::White),
+    Piece(Piece::Type::Queen, Color::White),
+    Piece(Piece::Type::King, Color::White),
+    Piece(Piece::Type::Pawn, Color::Black),
+    Piece(Piece::Type::Knight, Color::Black),
+    Piece(Piece::Type::Bishop, Color::Black),
+    Piece(Piece::Type::Rook, Color::Black),
+    Piece(Piece::Type::Queen, Color::Black),
+    Piece(Piece::Type::King, Color::Black),
+};
 
 std::ostream& operator<<(std::ostream&, const Piece&);
 
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <weechess/game_state.h>
+#include <weechess/move.h>
+
+namespace weechess {
+
+class MappedFile;
+
+namespace polyglot {
+
+    using Hash = uint64_t;
+
+    // Polyglot keys positions with a fixed table of 781 published random numbers ("Random64" in
+    // the format's specification): one for each piece on each square, four for castle rights,
+    // eight for en passant files and one for white to move
+    constexpr size_t key_count = 781;
+    using Keys = std::array<Hash, key_count>;
+
+    class Hasher {
+    public:
+        // With the table from the specification, which every Polyglot book is keyed by
+        Hasher();
+        explicit Hasher(const Keys&);
+
+        // Reads a table to use instead from a text file of 781 hexadecimal numbers (with or
+        // without a 0x prefix), separated by whitespace or commas, as it's printed in the
+        // specification
+        static std::optional<Hasher> load(const std::filesystem::path&);
+
+        Hash hash(const GameSnapshot&) const;
+
+    private:
+        Keys m_keys;
+    };
+
+    // Moves are stored as from and to squares plus a promotion, with castling written as the
+    // king capturing its own rook
+    uint16_t encode_move(const Move&);
+    std::optional<Move> decode_move(uint16_t, const GameSnapshot&);
+
+    struct Entry {
+        Hash key;
+        uint16_t move;
+        uint16_t weight;
+        uint32_t learn;
+    };
+
+    // Writes entries as a Polyglot book, sorting them by key (and by weight, heaviest first,
+    // within a key) as readers expect
+    bool write_book(const std::filesystem::path&, std::vector<Entry> entries);
+}
+
+// A Polyglot (.bin) opening book. The file is mapped and its big-endian 16 byte entries are
+// binary searched in place, so opening a book of any size costs nothing up front
+class PolyglotBook {
+public:
+    struct WeightedMove {
+        Move move;
+        uint16_t weight;
+    };
+
+    static std::optional<PolyglotBook> open(const std::filesystem::path&, const polyglot::Hasher&);
+
+    size_t size() const;
+
+    // Moves that can't be played in the position (from hash collisions or a mismatched key
+    // table) are skipped
+    std::vector<WeightedMove> lookup(const GameSnapshot&) const;
+
+    // Picks one of the book moves at random, in proportion to their weights
+    std::optional<Move> select(const GameSnapshot&, std::default_random_engine&) const;
+
+private:
+    PolyglotBook(std::shared_ptr<const MappedFile>, const polyglot::Hasher&);
+
+    polyglot::Entry entry_at(size_t index) const;
+
+    std::shared_ptr<const MappedFile> m_file;
+    std::shared_ptr<const polyglot::Hasher> m_hasher;
+};
+
+}
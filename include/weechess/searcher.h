@@ -1,5 +1,9 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <span>
 #include <vector>
 
@@ -7,30 +11,51 @@
 #include <weechess/evaluator.h>
 #include <weechess/game_state.h>
 #include <weechess/threading.h>
+#include <weechess/transposition_table.h>
 
 namespace weechess {
 
-class SearchInstance;
+class AnalysisCache;
 
+// The results of a completed iteration of the search
 class SearchProgress {
 public:
-    SearchProgress(SearchInstance* search_instance, bool has_new_results, size_t max_depth_reached);
+    SearchProgress(size_t max_depth_reached,
+        size_t nodes_searched,
+        size_t quiescence_nodes_searched,
+        Evaluation evaluation,
+        std::vector<Move> best_line);
 
-    bool has_new_results() const;
     size_t max_depth() const;
+    // All nodes visited, including those in the quiescence search. The quiescence
+    // nodes are also reported on their own, since that's where the tree tends to blow up
     size_t nodes_searched() const;
+    size_t quiescence_nodes_searched() const;
     Evaluation evaluation() const;
-    std::vector<Move> best_line() const;
+    const std::vector<Move>& best_line() const;
 
 private:
-    bool m_has_new_results;
     size_t m_max_depth_reached;
-    SearchInstance* m_search_instance;
+    size_t m_nodes_searched;
+    size_t m_quiescence_nodes_searched;
+    Evaluation m_evaluation;
+    std::vector<Move> m_best_line;
 };
 
 struct SearchControl {
     bool stop { false };
-    size_t next_control_event { 1 };
+};
+
+// Adjustments to how deep each move is searched, which can be turned off individually to compare
+struct SearchFeatures {
+    // Search one ply deeper after a move that gives check
+    bool check_extensions { true };
+
+    // Search one ply deeper after the TT move when every other move is clearly worse
+    bool singular_extensions { true };
+
+    // Search one ply shallower in positions that don't have a TT move to try first
+    bool internal_iterative_reductions { true };
 };
 
 class Searcher {
@@ -38,7 +63,37 @@ public:
     using Checkpointer = std::function<void(const SearchProgress&, SearchControl&)>;
 
     Searcher() = default;
+
+    // Results near the root are read from and written to the analysis cache, when there is one. The
+    // transposition table is kept from one search to the next, so a game's searches build on each other.
+    // Without one, the searcher makes a table of the default size for itself
+    explicit Searcher(const SearchFeatures&,
+        std::shared_ptr<AnalysisCache> analysis_cache = {},
+        std::shared_ptr<TranspositionTable> transposition_table = {});
+
+    // Iteratively deepens the search up to the given depth, calling the checkpointer after each
+    // completed iteration. The stop token and the node limit are polled every few thousand nodes,
+    // and a search that's stopped part way through an iteration throws that iteration away.
     void search(const GameState& game_state, size_t max_depth, const Checkpointer&);
+    void search(const GameState& game_state,
+        size_t max_depth,
+        const Checkpointer&,
+        const threading::Token& stop,
+        std::optional<size_t> max_nodes = {});
+
+    // These can be read from another thread while a search is running. The node count
+    // is only brought up to date whenever the search polls the stop token
+    size_t nodes_searched() const;
+    size_t quiescence_nodes_searched() const;
+    size_t current_depth() const;
+
+private:
+    SearchFeatures m_features {};
+    std::shared_ptr<AnalysisCache> m_analysis_cache {};
+    std::shared_ptr<TranspositionTable> m_transposition_table { std::make_shared<TranspositionTable>() };
+    std::atomic<size_t> m_nodes_searched { 0 };
+    std::atomic<size_t> m_quiescence_nodes_searched { 0 };
+    std::atomic<size_t> m_current_depth { 0 };
 };
 
 }
@@ -1,9 +1,16 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <future>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <thread>
+#include <type_traits>
 #include <vector>
 
 namespace weechess::threading {
@@ -25,84 +32,77 @@ private:
     std::atomic<bool> m_invalidated;
 };
 
-class JoinThread {
-private:
-    std::shared_ptr<Token> m_token;
-    std::future<void> m_future;
-    std::thread m_thread;
-
+// A fixed set of worker threads, each with its own deque of tasks. Workers take their own tasks
+// newest first and steal the oldest tasks from other workers when they run out, so tasks that
+// submit more tasks (like splitting a search or a perft) keep their work close by.
+class ThreadPool {
 public:
-    template <typename... Args>
-    JoinThread(std::packaged_task<void(std::shared_ptr<Token>, Args...)> task, Args&&... args)
-        : m_token(std::make_shared<Token>())
-        , m_future(task.get_future())
-        , m_thread(std::move(task), m_token, std::forward<Args>(args)...)
-    {
-    }
+    static size_t default_thread_count();
 
-    JoinThread(const JoinThread&) = delete;
-    JoinThread(JoinThread&&) = delete;
-    JoinThread& operator=(const JoinThread&) = delete;
-    JoinThread& operator=(JoinThread&&) = delete;
+    // When pinning, worker i is bound to CPU i (modulo the CPU count). Pinning is only
+    // supported on Linux and is ignored elsewhere
+    explicit ThreadPool(size_t thread_count = default_thread_count(), bool pin_threads = false);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
 
-    ~JoinThread()
-    {
-        m_token->invalidate();
-        if (m_thread.joinable())
-            m_thread.join();
-    }
+    // Runs every task that's already been submitted before the workers are joined
+    ~ThreadPool();
 
-    void invalidate() { m_token->invalidate(); }
-    bool invalidated() const { return m_token->invalidated(); }
-
-    bool joinable() const { return m_thread.joinable(); }
-    void join() { m_thread.join(); }
-
-    bool valid() const { return m_future.valid(); }
-    bool finished() const { return m_future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
-};
-
-class ThreadDispatcher {
-private:
-    std::vector<std::unique_ptr<JoinThread>> m_threads;
+    size_t size() const;
 
-    void maintenance()
+    template <typename F> auto submit(F&& f) -> std::future<std::invoke_result_t<F>>
     {
-        auto erase_begin = std::remove_if(m_threads.begin(), m_threads.end(), [](const auto& thread) {
-            return !thread->joinable() || thread->invalidated();
-        });
-
-        for (auto it = erase_begin; it != m_threads.end(); ++it) {
-            (*it)->join();
-        }
-
-        m_threads.erase(erase_begin, m_threads.end());
+        using Result = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(f));
+        auto future = task->get_future();
+        push([task]() { (*task)(); });
+        return future;
     }
 
-public:
-    ThreadDispatcher() = default;
-
-    template <typename F, typename... Args> void dispatch(F&& f, Args&&... args)
+    // The task is handed the token so that it can give up early once the token is invalidated.
+    // The token has to outlive the task
+    template <typename F>
+    auto submit(const Token& token, F&& f) -> std::future<std::invoke_result_t<F, const Token&>>
     {
-        std::packaged_task<void(std::shared_ptr<Token>, Args...)> task(f);
-        m_threads.push_back(std::make_unique<JoinThread>(std::move(task), std::forward<Args>(args)...));
+        return submit([&token, f = std::forward<F>(f)]() mutable { return f(token); });
     }
 
-    void invalidate_all()
+    // Waits for the result of a task, running other tasks in the meantime. Tasks should wait on
+    // the tasks they submitted with this rather than std::future::get, so the worker they're
+    // running on keeps working instead of blocking (or deadlocking a small pool)
+    template <typename T> T get(std::future<T>& future)
     {
-        maintenance();
-        for (auto& thread : m_threads) {
-            thread->invalidate();
+        while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            if (!run_pending_task())
+                future.wait_for(std::chrono::microseconds(100));
         }
-    }
 
-    void join_all()
-    {
-        maintenance();
-        for (auto& thread : m_threads) {
-            if (thread->joinable())
-                thread->join();
-        }
+        return future.get();
     }
+
+private:
+    using Task = std::function<void()>;
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<size_t> m_next_worker { 0 };
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    size_t m_pending_tasks { 0 };
+    bool m_stopping { false };
+
+    void push(Task);
+    std::optional<Task> take(std::optional<size_t> worker_index);
+    bool run_pending_task();
+    void run_worker(size_t worker_index);
 };
+
 }
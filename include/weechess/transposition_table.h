@@ -1,6 +1,8 @@
 #pragma once
 
-#include <unordered_map>
+#include <cstdint>
+#include <optional>
+#include <vector>
 
 #include <weechess/evaluator.h>
 #include <weechess/move.h>
@@ -11,31 +13,51 @@ namespace weechess {
 struct GameSnapshot;
 
 struct TranspositionEntry {
-    enum class Type {
-        Exact,
+    // Zero is reserved so that zero-initialized entries in the table are empty
+    enum class Type : uint8_t {
+        Exact = 1,
         LowerBound,
         UpperBound,
     };
 
+    // The upper bits of the zobrist hash, used to tell apart positions sharing a slot
+    uint16_t key;
+    CompactMove move;
+    int16_t score;
+
+    // The remaining depth the position was searched to
+    uint8_t depth;
     Type type;
-    Move move;
-    size_t depth;
-    size_t max_depth;
-    Evaluation evaluation;
+
+    bool is_empty() const { return static_cast<uint8_t>(type) == 0; }
+    Evaluation evaluation() const { return { score }; }
 };
 
+static_assert(sizeof(TranspositionEntry) == 8);
+
 class TranspositionTable {
 public:
     using Key = zobrist::Hash;
     using Value = TranspositionEntry;
 
-    TranspositionTable() = default;
+    static constexpr size_t default_size_in_bytes = 64 * 1024 * 1024;
 
-    void insert(const GameSnapshot&, const Value&);
-    std::optional<Value> find(const GameSnapshot&) const;
+    // The table is a fixed number of entries, the largest power of two that fits in the given size
+    explicit TranspositionTable(size_t size_in_bytes = default_size_in_bytes);
+
+    // Mate scores are stored relative to the position rather than the root of
+    // the search, so the ply of the position needs to be provided
+    void insert(const GameSnapshot&, Value::Type, const Move&, size_t depth, Evaluation, size_t ply);
+    std::optional<Value> find(const GameSnapshot&, size_t ply) const;
+
+    size_t capacity() const;
+    void clear();
 
 private:
-    std::unordered_map<Key, Value> m_table;
+    static uint16_t key_of(Key);
+    size_t index_of(Key) const;
+
+    std::vector<Value> m_entries;
 };
 
 }
@@ -0,0 +1,421 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+#include <weechess/analysis_cache.h>
+#include <weechess/game_state.h>
+
+#include "mapped_file.h"
+
+namespace weechess {
+
+namespace {
+
+    constexpr std::array<char, 8> file_magic = { 'W', 'E', 'E', 'C', 'A', 'C', 'H', 'E' };
+    constexpr uint32_t file_version = 3;
+
+    // As with book files, the byte order is checked by the version and the zobrist hashes by the
+    // hash of the initial position. The table's records follow the header, and everything after
+    // them was appended since the table was written
+    struct FileHeader {
+        std::array<char, 8> magic;
+        uint32_t version;
+        uint32_t table_size;
+        zobrist::Hash initial_position_hash;
+    };
+
+    static_assert(std::is_trivially_copyable_v<FileHeader> && sizeof(FileHeader) == 24);
+
+    FileHeader make_header(size_t table_size)
+    {
+        return FileHeader {
+            .magic = file_magic,
+            .version = file_version,
+            .table_size = static_cast<uint32_t>(table_size),
+            .initial_position_hash = GameSnapshot::initial_position().zobrist_hash(),
+        };
+    }
+
+    // splitmix64's finalizer, which is plenty to catch torn and garbled writes
+    constexpr uint64_t mix(uint64_t value)
+    {
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+        return value ^ (value >> 31);
+    }
+
+    // Seeded, since mixing zero gives zero and a run of zeroes is what a crash leaves behind when the file had
+    // grown but the records hadn't been written yet
+    constexpr uint64_t checksum_seed = 0x9e3779b97f4a7c15ULL;
+    constexpr uint64_t checksum_of(zobrist::Hash hash, uint64_t data) { return mix(hash ^ mix(data ^ checksum_seed)); }
+
+    constexpr bool is_valid_type(uint8_t type)
+    {
+        using Type = TranspositionEntry::Type;
+        return type == static_cast<uint8_t>(Type::Exact) || type == static_cast<uint8_t>(Type::LowerBound)
+            || type == static_cast<uint8_t>(Type::UpperBound);
+    }
+
+    // The share of the capacity that's kept in memory before it's merged into the table. Opening a cache
+    // reads at most twice as many records as that, however big the table is
+    constexpr size_t memory_capacity_divisor = 16;
+
+}
+
+AnalysisCache::Record AnalysisCache::Record::from(zobrist::Hash hash, const Slot& slot)
+{
+    auto data = uint64_t(static_cast<uint16_t>(slot.score)) | (uint64_t(slot.move.data()) << 16)
+        | (uint64_t(slot.depth) << 32) | (uint64_t(static_cast<uint8_t>(slot.type)) << 40);
+    return { hash, data, checksum_of(hash, data) };
+}
+
+std::optional<AnalysisCache::Slot> AnalysisCache::Record::slot() const
+{
+    auto type = static_cast<uint8_t>((data >> 40) & 0xff);
+    if (checksum != checksum_of(hash, data) || !is_valid_type(type))
+        return {};
+
+    return Slot {
+        .score = static_cast<int16_t>(data & 0xffff),
+        .move = CompactMove(static_cast<CompactMove::Data>((data >> 16) & 0xffff)),
+        .depth = static_cast<uint8_t>((data >> 32) & 0xff),
+        .type = static_cast<Value::Type>(type),
+    };
+}
+
+AnalysisCache::AnalysisCache(std::filesystem::path path, size_t capacity)
+    : m_path(std::move(path))
+    , m_capacity(capacity)
+{
+}
+
+std::unique_ptr<AnalysisCache> AnalysisCache::open(const std::filesystem::path& path, size_t size_in_bytes)
+{
+    std::unique_ptr<AnalysisCache> cache(
+        new AnalysisCache(path, std::max(size_in_bytes / sizeof(Record), size_t(1))));
+    if (!cache->load())
+        return nullptr;
+
+    return cache;
+}
+
+bool AnalysisCache::load()
+{
+    std::error_code error;
+    if (!std::filesystem::exists(m_path, error)) {
+        std::ofstream stream(m_path, std::ios::binary | std::ios::trunc);
+        auto header = make_header(0);
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        return stream.good();
+    }
+
+    if (!map_table())
+        return false;
+
+    // Later records supersede the table and earlier records for the same position, unless they're shallower
+    auto bytes = m_file->data();
+    auto valid_size = sizeof(FileHeader) + m_table.size_bytes();
+    while (valid_size + sizeof(Record) <= bytes.size()) {
+        Record record;
+        std::memcpy(&record, bytes.data() + valid_size, sizeof(record));
+        auto slot = record.slot();
+        if (!slot.has_value())
+            break;
+
+        auto existing = find_slot(record.hash);
+        if (!existing.has_value() || slot->depth >= existing->depth)
+            m_slots[record.hash] = *slot;
+
+        valid_size += sizeof(Record);
+        m_records_after_table++;
+    }
+
+    // Whatever follows the last good record was being written when an engine stopped, and has to go
+    // before anything else is appended after it. The mapping has to be gone before the file can be
+    // cut down to size
+    if (valid_size < bytes.size()) {
+        m_table = {};
+        m_file.reset();
+        std::filesystem::resize_file(m_path, valid_size, error);
+        if (error || !map_table())
+            return false;
+    }
+
+    // The file may have been written with a bigger capacity. If it can't be cut down, it's still usable
+    if ((m_table.size() > m_capacity || m_slots.size() > memory_capacity()) && !compact_file())
+        evict_shallowest();
+
+    return true;
+}
+
+bool AnalysisCache::map_table()
+{
+    // The table is searched where it's mapped, so records have to be laid out exactly as they're stored
+    static_assert(std::is_trivially_copyable_v<Record> && sizeof(Record) == 24);
+    static_assert(sizeof(FileHeader) % alignof(Record) == 0);
+
+    std::shared_ptr<const MappedFile> file = MappedFile::open(m_path);
+    if (!file)
+        return false;
+
+    auto bytes = file->data();
+    if (bytes.size() < sizeof(FileHeader))
+        return false;
+
+    FileHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+
+    auto expected_header = make_header(header.table_size);
+    if (header.magic != expected_header.magic || header.version != expected_header.version
+        || header.initial_position_hash != expected_header.initial_position_hash) {
+        return false;
+    }
+
+    // Tables are only ever written whole, so one that's cut short means the file was damaged some other way
+    if (bytes.size() < sizeof(FileHeader) + size_t(header.table_size) * sizeof(Record))
+        return false;
+
+    m_table = { reinterpret_cast<const Record*>(bytes.data() + sizeof(FileHeader)), header.table_size };
+    m_file = std::move(file);
+    return true;
+}
+
+void AnalysisCache::insert(
+    const GameSnapshot& snapshot, Value::Type type, const Move& move, size_t depth, Evaluation evaluation, size_t ply)
+{
+    auto hash = snapshot.zobrist_hash();
+    auto score = evaluation.relative_to_ply(ply).score;
+    assert(score >= INT16_MIN && score <= INT16_MAX);
+
+    auto slot = Slot {
+        .score = static_cast<int16_t>(score),
+        .move = CompactMove(move),
+        .depth = static_cast<uint8_t>(std::min(depth, size_t(UINT8_MAX))),
+        .type = type,
+    };
+
+    std::lock_guard lock(m_mutex);
+    auto existing = find_slot(hash);
+    if (existing.has_value() && slot.depth < existing->depth)
+        return;
+
+    m_slots[hash] = slot;
+    m_unwritten.push_back(hash);
+
+    // Merging into the table keeps the deepest results across both. If the file can't be written,
+    // the shallowest of the new results go instead
+    if (m_slots.size() > memory_capacity() && !compact_file())
+        evict_shallowest();
+}
+
+std::optional<AnalysisCache::Value> AnalysisCache::find(const GameSnapshot& snapshot, size_t ply) const
+{
+    auto hash = snapshot.zobrist_hash();
+
+    std::lock_guard lock(m_mutex);
+    auto slot = find_slot(hash);
+    if (!slot.has_value())
+        return {};
+
+    return Value {
+        .key = static_cast<uint16_t>(hash >> 48),
+        .move = slot->move,
+        .score = static_cast<int16_t>(Evaluation { slot->score }.relative_to_root(ply).score),
+        .depth = slot->depth,
+        .type = slot->type,
+    };
+}
+
+std::optional<AnalysisCache::Slot> AnalysisCache::find_slot(zobrist::Hash hash) const
+{
+    if (auto it = m_slots.find(hash); it != m_slots.end())
+        return it->second;
+
+    return find_in_table(hash);
+}
+
+std::optional<AnalysisCache::Slot> AnalysisCache::find_in_table(zobrist::Hash hash) const
+{
+    auto it = std::lower_bound(m_table.begin(), m_table.end(), hash, [](const auto& record, const auto& hash) {
+        return record.hash < hash;
+    });
+
+    // Records in the table aren't checked when it's opened, only when they're read
+    if (it == m_table.end() || it->hash != hash)
+        return {};
+
+    return it->slot();
+}
+
+size_t AnalysisCache::memory_capacity() const { return std::max(m_capacity / memory_capacity_divisor, size_t(1)); }
+
+void AnalysisCache::evict_shallowest()
+{
+    // Down to half of what fits, so there's a while before the next attempt at merging them into the table
+    auto target = memory_capacity() / 2;
+    if (m_slots.size() <= target)
+        return;
+
+    std::vector<std::pair<uint8_t, zobrist::Hash>> depths;
+    depths.reserve(m_slots.size());
+    for (const auto& [hash, slot] : m_slots)
+        depths.emplace_back(slot.depth, hash);
+
+    auto excess = depths.size() - target;
+    std::nth_element(depths.begin(), depths.begin() + static_cast<std::ptrdiff_t>(excess), depths.end());
+    for (size_t i = 0; i < excess; i++)
+        m_slots.erase(depths[i].second);
+}
+
+bool AnalysisCache::append_records(const std::vector<zobrist::Hash>& hashes) const
+{
+    std::vector<Record> records;
+    records.reserve(hashes.size());
+    for (auto hash : hashes) {
+        auto it = m_slots.find(hash);
+        if (it != m_slots.end())
+            records.push_back(Record::from(hash, it->second));
+    }
+
+    std::ofstream stream(m_path, std::ios::binary | std::ios::app);
+    if (!stream)
+        return false;
+
+    stream.write(reinterpret_cast<const char*>(records.data()), std::streamsize(records.size() * sizeof(Record)));
+    stream.flush();
+    return stream.good();
+}
+
+bool AnalysisCache::flush()
+{
+    std::lock_guard lock(m_mutex);
+    if (m_unwritten.empty())
+        return true;
+
+    // Positions that were improved on more than once since the last flush only need writing once
+    std::sort(m_unwritten.begin(), m_unwritten.end());
+    m_unwritten.erase(std::unique(m_unwritten.begin(), m_unwritten.end()), m_unwritten.end());
+
+    // Records for positions that were improved on again still have to be read when the cache is opened
+    if (m_records_after_table + m_unwritten.size() > 2 * memory_capacity())
+        return compact_file();
+
+    if (!append_records(m_unwritten))
+        return false;
+
+    m_records_after_table += m_unwritten.size();
+    m_unwritten.clear();
+    return true;
+}
+
+bool AnalysisCache::compact()
+{
+    std::lock_guard lock(m_mutex);
+    return compact_file();
+}
+
+bool AnalysisCache::compact_file()
+{
+    std::vector<std::pair<zobrist::Hash, Slot>> slots(m_slots.begin(), m_slots.end());
+    std::sort(slots.begin(), slots.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+    // Every result in order of hash, with the newer results in place of the table's
+    auto for_each_result = [&](const auto& callback) {
+        auto table = m_table.begin();
+        auto visit_table_until = [&](std::optional<zobrist::Hash> hash) {
+            for (; table != m_table.end() && (!hash.has_value() || table->hash < *hash); table++) {
+                if (auto slot = table->slot())
+                    callback(*table, *slot);
+            }
+        };
+
+        for (const auto& [hash, slot] : slots) {
+            visit_table_until(hash);
+            if (table != m_table.end() && table->hash == hash)
+                table++;
+
+            callback(Record::from(hash, slot), slot);
+        }
+
+        visit_table_until({});
+    };
+
+    // Only the deepest results fit. Counting the results at each depth gives the shallowest depth
+    // that's kept, and how many of the results at that depth there's room for
+    std::array<size_t, UINT8_MAX + 1> depth_counts {};
+    for_each_result([&](const Record&, const Slot& slot) { depth_counts[slot.depth]++; });
+
+    size_t min_depth = depth_counts.size() - 1;
+    size_t room = m_capacity;
+    while (min_depth > 0 && depth_counts[min_depth] < room) {
+        room -= depth_counts[min_depth];
+        min_depth--;
+    }
+
+    // Renaming over the old file is atomic, so a crash leaves either the old file or the new one
+    auto temporary_path = m_path;
+    temporary_path += ".tmp";
+    {
+        std::ofstream stream(temporary_path, std::ios::binary | std::ios::trunc);
+        if (!stream)
+            return false;
+
+        auto header = make_header(m_capacity - room + std::min(room, depth_counts[min_depth]));
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        std::vector<Record> records;
+        records.reserve(4096);
+        auto write_records = [&]() {
+            stream.write(
+                reinterpret_cast<const char*>(records.data()), std::streamsize(records.size() * sizeof(Record)));
+            records.clear();
+        };
+
+        for_each_result([&](const Record& record, const Slot& slot) {
+            if (slot.depth < min_depth || (slot.depth == min_depth && room == 0))
+                return;
+
+            if (slot.depth == min_depth)
+                room--;
+
+            records.push_back(record);
+            if (records.size() == records.capacity())
+                write_records();
+        });
+
+        write_records();
+        stream.flush();
+        if (!stream.good())
+            return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary_path, m_path, error);
+    if (error)
+        return false;
+
+    // Everything's in the new table now
+    m_slots.clear();
+    m_unwritten.clear();
+    m_records_after_table = 0;
+    return map_table();
+}
+
+size_t AnalysisCache::size() const
+{
+    std::lock_guard lock(m_mutex);
+    auto size = m_table.size();
+    for (const auto& [hash, _] : m_slots) {
+        if (!find_in_table(hash).has_value())
+            size++;
+    }
+
+    return size;
+}
+
+size_t AnalysisCache::capacity() const { return m_capacity; }
+
+}
@@ -0,0 +1,67 @@
+#include <weechess/attack_maps.h>
+#include <weechess/attack_table.h>
+#include <weechess/board.h>
+
+namespace weechess {
+
+namespace {
+    constexpr bool is_slider(Piece piece)
+    {
+        return piece.is(Piece::Type::Rook) || piece.is(Piece::Type::Bishop) || piece.is(Piece::Type::Queen);
+    }
+}
+
+AttackTable::AttackTable(const Board& board)
+{
+    auto occupancy = board.shared_occupancy();
+    while (occupancy.any()) {
+        auto origin = occupancy.pop_lsb().value();
+        m_square_attacks[origin.offset]
+            = attack_maps::generate_attacks(board.piece_at(origin), origin, board.shared_occupancy());
+    }
+
+    accumulate(board);
+}
+
+AttackTable AttackTable::updated(const Board& board, BitBoard changed) const
+{
+    AttackTable table;
+
+    auto occupancy = board.shared_occupancy();
+    while (occupancy.any()) {
+        auto origin = occupancy.pop_lsb().value();
+        auto piece = board.piece_at(origin);
+
+        // A piece that didn't move only sees different squares if it's a slider
+        // and one of its rays ran into (or through) a square that changed
+        auto previous = m_square_attacks[origin.offset];
+        if (changed[origin] || (is_slider(piece) && (previous & changed).any())) {
+            table.m_square_attacks[origin.offset]
+                = attack_maps::generate_attacks(piece, origin, board.shared_occupancy());
+        } else {
+            table.m_square_attacks[origin.offset] = previous;
+        }
+    }
+
+    table.accumulate(board);
+    return table;
+}
+
+void AttackTable::accumulate(const Board& board)
+{
+    for (const auto& piece : Piece::all_valid_pieces) {
+        auto occupancy = board.occupancy_for(piece);
+        while (occupancy.any()) {
+            auto origin = occupancy.pop_lsb().value();
+            m_color_attacks[piece.color] |= m_square_attacks[origin.offset];
+            if (piece.type == Piece::Type::Pawn)
+                m_pawn_attacks[piece.color] |= m_square_attacks[origin.offset];
+        }
+    }
+}
+
+BitBoard AttackTable::attacks_from(Location location) const { return m_square_attacks[location.offset]; }
+BitBoard AttackTable::attacks(Color color) const { return m_color_attacks[color]; }
+BitBoard AttackTable::pawn_attacks(Color color) const { return m_pawn_attacks[color]; }
+
+}
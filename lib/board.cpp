@@ -3,80 +3,168 @@
 
 namespace weechess {
 
-inline size_t piece_index(Piece piece)
+namespace {
+    constexpr BitBoard not_a_file = ~File('A').mask();
+    constexpr BitBoard not_h_file = ~File('H').mask();
+
+    inline size_t type_index(Piece::Type type) { return static_cast<size_t>(type) - 1; }
+
+#ifndef WEECHESS_INCREMENTAL_ATTACKS
+    template <Color C> BitBoard pawn_attacks_for(const Board& board)
+    {
+        auto pawns = board.occupancy_for(Piece(Piece::Type::Pawn, C));
+        if constexpr (C == Color::White)
+            return ((pawns & not_a_file) << 7) | ((pawns & not_h_file) << 9);
+        else
+            return ((pawns & not_a_file) >> 9) | ((pawns & not_h_file) >> 7);
+    }
+
+    // Gathered per piece type rather than through attack_maps::generate_attacks, so that neither
+    // the color nor the piece type needs to be branched on for every piece
+    template <Color C> BitBoard attacks_for(const Board& board)
+    {
+        const auto& buffer = board.piece_buffer();
+        auto blockers = board.shared_occupancy();
+        auto pieces = board.color_occupancy()[C];
+        auto queens = buffer.occupancy_for(Piece::Type::Queen);
+        auto attacks = pawn_attacks_for<C>(board);
+
+        auto knights = buffer.occupancy_for(Piece::Type::Knight) & pieces;
+        while (knights.any())
+            attacks |= attack_maps::generate_knight_attacks(knights.pop_lsb().value());
+
+        auto kings = buffer.occupancy_for(Piece::Type::King) & pieces;
+        while (kings.any())
+            attacks |= attack_maps::generate_king_attacks(kings.pop_lsb().value());
+
+        auto diagonals = (buffer.occupancy_for(Piece::Type::Bishop) | queens) & pieces;
+        while (diagonals.any())
+            attacks |= attack_maps::generate_bishop_attacks(diagonals.pop_lsb().value(), blockers);
+
+        auto orthogonals = (buffer.occupancy_for(Piece::Type::Rook) | queens) & pieces;
+        while (orthogonals.any())
+            attacks |= attack_maps::generate_rook_attacks(orthogonals.pop_lsb().value(), blockers);
+
+        return attacks & ~pieces;
+    }
+#endif
+}
+
+BitBoard Board::Buffer::occupancy_for(Piece piece) const
+{
+    return m_types[type_index(piece.type)] & m_colors[piece.color];
+}
+
+BitBoard Board::Buffer::occupancy_for(Piece::Type type) const { return m_types[type_index(type)]; }
+
+Piece Board::Buffer::piece_at(Location location) const
 {
-    auto offset = piece.color == Color::White ? 0 : 7;
-    return offset + static_cast<size_t>(piece.type);
+    Color color;
+    if (m_colors[Color::White][location])
+        color = Color::White;
+    else if (m_colors[Color::Black][location])
+        color = Color::Black;
+    else
+        return Piece::none();
+
+    // At most one of the type boards has this square set, so gather the type without branching
+    uint8_t type = 0;
+    for (size_t i = 0; i < m_types.size(); i++)
+        type |= ((m_types[i].data() >> location.offset) & 1) * (i + 1);
+
+    return Piece(static_cast<Piece::Type>(type), color);
 }
 
-BitBoard& Board::Buffer::occupancy_for(Piece piece) { return m_occupancy[piece_index(piece)]; }
-const BitBoard& Board::Buffer::occupancy_for(Piece piece) const { return m_occupancy[piece_index(piece)]; }
+void Board::Buffer::set_piece(Piece piece, Location location)
+{
+    m_types[type_index(piece.type)].set(location);
+    m_colors[piece.color].set(location);
+}
+
+void Board::Buffer::remove_piece(Piece piece, Location location)
+{
+    m_types[type_index(piece.type)].unset(location);
+    m_colors[piece.color].unset(location);
+}
 
 Board::Board() = default;
 Board::Board(Buffer piece_buffer)
     : m_piece_buffer(std::move(piece_buffer))
-    , m_shared_occupancy({})
-    , m_color_occupancy({}, {})
 {
-    for (const auto& piece : Piece::all_valid_pieces) {
-        const auto& occupancy = m_piece_buffer.occupancy_for(piece);
-        m_shared_occupancy |= occupancy;
-        m_color_occupancy[piece.color] |= occupancy;
-    }
+#ifdef WEECHESS_INCREMENTAL_ATTACKS
+    m_attack_table = AttackTable(*this);
+#endif
 }
 
-Piece Board::piece_at(Location location) const
+Board::Board(Buffer piece_buffer, const Board& previous, BitBoard changed)
+    : m_piece_buffer(std::move(piece_buffer))
 {
-    for (const auto& piece : Piece::all_valid_pieces) {
-        if (m_piece_buffer.occupancy_for(piece)[location.offset])
-            return piece;
-    }
-
-    return Piece::none();
+#ifdef WEECHESS_INCREMENTAL_ATTACKS
+    m_attack_table = previous.m_attack_table.updated(*this, changed);
+#endif
 }
 
+Piece Board::piece_at(Location location) const { return m_piece_buffer.piece_at(location); }
+
 Color Board::color_at(Location location) const
 {
     return (location.file() + location.rank()) % 2 == 0 ? Color::White : Color::Black;
 }
 
 const Board::Buffer& Board::piece_buffer() const { return m_piece_buffer; }
-const BitBoard& Board::occupancy_for(Piece piece) const { return m_piece_buffer.occupancy_for(piece); }
-const BitBoard& Board::shared_occupancy() const { return m_shared_occupancy; }
-const ColorMap<BitBoard>& Board::color_occupancy() const { return m_color_occupancy; }
-BitBoard Board::non_occupancy() const { return ~m_shared_occupancy; }
+BitBoard Board::occupancy_for(Piece piece) const { return m_piece_buffer.occupancy_for(piece); }
+const ColorMap<BitBoard>& Board::color_occupancy() const { return m_piece_buffer.m_colors; }
+BitBoard Board::non_occupancy() const { return ~shared_occupancy(); }
 
-BitBoard Board::attacks(Color color) const
+BitBoard Board::shared_occupancy() const
 {
-    if (m_color_attacks[color].none()) {
-        auto mut_this = const_cast<Board*>(this);
-        for (const auto& piece : Piece::all_valid_pieces) {
-            if (piece.color != color)
-                continue;
-
-            auto occupancy = mut_this->m_piece_buffer.occupancy_for(piece);
-            while (occupancy.any()) {
-                auto origin = occupancy.pop_lsb().value();
-                auto attacks = attack_maps::generate_attacks(piece, origin, m_shared_occupancy);
-                mut_this->m_color_attacks[color] |= attacks;
-                if (piece.type == Piece::Type::Pawn)
-                    mut_this->m_pawn_attacks[color] |= attacks;
-            }
-        }
-
-        mut_this->m_color_attacks[color] &= ~m_color_occupancy[color];
-    }
+    return m_piece_buffer.m_colors[Color::White] | m_piece_buffer.m_colors[Color::Black];
+}
+
+#ifdef WEECHESS_INCREMENTAL_ATTACKS
 
-    return m_color_attacks[color];
+BitBoard Board::attacks(Color color) const { return m_attack_table.attacks(color) & ~color_occupancy()[color]; }
+BitBoard Board::pawn_attacks(Color color) const { return m_attack_table.pawn_attacks(color); }
+
+#else
+
+BitBoard Board::attacks(Color color) const
+{
+    return color == Color::White ? attacks_for<Color::White>(*this) : attacks_for<Color::Black>(*this);
 }
 
 BitBoard Board::pawn_attacks(Color color) const
 {
-    // Attacks are lazily initialized in attacks();
-    if (m_color_attacks[color].none())
-        attacks(color);
+    return color == Color::White ? pawn_attacks_for<Color::White>(*this) : pawn_attacks_for<Color::Black>(*this);
+}
+
+#endif
+
+bool Board::is_attacked(Location location, Color attacker) const
+{
+    const auto& buffer = m_piece_buffer;
+    auto blockers = shared_occupancy();
+    auto pieces = color_occupancy()[attacker];
+    auto queens = buffer.occupancy_for(Piece::Type::Queen);
+
+    auto pawns = buffer.occupancy_for(Piece::Type::Pawn) & pieces;
+    if ((attack_maps::generate_pawn_attacks(location, invert_color(attacker)) & pawns).any())
+        return true;
+
+    auto knights = buffer.occupancy_for(Piece::Type::Knight) & pieces;
+    if ((attack_maps::generate_knight_attacks(location) & knights).any())
+        return true;
+
+    auto kings = buffer.occupancy_for(Piece::Type::King) & pieces;
+    if ((attack_maps::generate_king_attacks(location) & kings).any())
+        return true;
+
+    auto diagonals = (buffer.occupancy_for(Piece::Type::Bishop) | queens) & pieces;
+    if ((attack_maps::generate_bishop_attacks(location, blockers) & diagonals).any())
+        return true;
 
-    return m_pawn_attacks[color];
+    auto orthogonals = (buffer.occupancy_for(Piece::Type::Rook) | queens) & pieces;
+    return (attack_maps::generate_rook_attacks(location, blockers) & orthogonals).any();
 }
 
 std::array<Piece, 64> Board::to_array() const
@@ -106,7 +194,8 @@ Board Board::Builder::build() const
     for (size_t i = 0; i < m_pieces.size(); i++) {
         Location location(i);
         Piece piece = m_pieces[i];
-        piece_buffer.occupancy_for(piece).set(location);
+        if (piece.exists())
+            piece_buffer.set_piece(piece, location);
     }
 
     return Board(piece_buffer);
@@ -1,30 +1,199 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <type_traits>
+
 #include <weechess/book.h>
 
 #include "generated/book_data.h"
+#include "mapped_file.h"
 
 namespace weechess {
 
+namespace {
+
+    constexpr std::array<char, 8> file_magic = { 'W', 'E', 'E', 'B', 'O', 'O', 'K', '\0' };
+
+    // Book files are written in the native byte order, which the version number also checks,
+    // since a file from a machine with the other byte order won't read back as a known version.
+    // The hash of the initial position checks that the book was keyed with the same zobrist
+    // hashes as this build
+    struct FileHeader {
+        std::array<char, 8> magic;
+        uint32_t version;
+        uint32_t entry_count;
+        uint32_t move_count;
+        uint32_t reserved;
+        zobrist::Hash initial_position_hash;
+    };
+
+    static_assert(std::is_trivially_copyable_v<FileHeader> && sizeof(FileHeader) == 32);
+    static_assert(std::is_trivially_copyable_v<Book::Entry> && sizeof(Book::Entry) == 16);
+    static_assert(std::is_trivially_copyable_v<Book::MoveEntry> && sizeof(Book::MoveEntry) == 20);
+
+    // The header and entries keep everything after them suitably aligned
+    static_assert(sizeof(FileHeader) % alignof(Book::Entry) == 0);
+    static_assert(sizeof(Book::Entry) % alignof(Book::MoveEntry) == 0);
+
+    FileHeader make_header(const Book::Data& data)
+    {
+        return FileHeader {
+            .magic = file_magic,
+            .version = Book::file_version,
+            .entry_count = static_cast<uint32_t>(data.entries.size()),
+            .move_count = static_cast<uint32_t>(data.moves.size()),
+            .reserved = 0,
+            .initial_position_hash = GameSnapshot::initial_position().zobrist_hash(),
+        };
+    }
+
+}
+
 Book::Book() = default;
 Book::Book(Book::Data data)
     : m_data(data)
 {
 }
 
-std::span<const Move> Book::lookup(const GameSnapshot& snapshot) const { return lookup(snapshot.zobrist_hash()); }
-std::span<const Move> Book::lookup(const zobrist::Hash& hash) const
+std::optional<Book> Book::open(const std::filesystem::path& path)
+{
+    std::shared_ptr<const MappedFile> file = MappedFile::open(path);
+    if (!file)
+        return {};
+
+    auto bytes = file->data();
+    if (bytes.size() < sizeof(FileHeader))
+        return {};
+
+    FileHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+
+    auto expected_header = make_header({});
+    if (header.magic != expected_header.magic || header.version != expected_header.version
+        || header.initial_position_hash != expected_header.initial_position_hash) {
+        return {};
+    }
+
+    auto entries_size = size_t(header.entry_count) * sizeof(Entry);
+    auto moves_size = size_t(header.move_count) * sizeof(MoveEntry);
+    if (bytes.size() != sizeof(FileHeader) + entries_size + moves_size)
+        return {};
+
+    const auto* entries = reinterpret_cast<const Entry*>(bytes.data() + sizeof(FileHeader));
+    const auto* moves = reinterpret_cast<const MoveEntry*>(bytes.data() + sizeof(FileHeader) + entries_size);
+
+    Book book({ { entries, header.entry_count }, { moves, header.move_count } });
+    book.m_file = std::move(file);
+    return book;
+}
+
+bool Book::save(const std::filesystem::path& path) const
+{
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream)
+        return false;
+
+    auto header = make_header(m_data);
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(m_data.entries.data()), m_data.entries.size_bytes());
+    stream.write(reinterpret_cast<const char*>(m_data.moves.data()), m_data.moves.size_bytes());
+
+    return stream.good();
+}
+
+std::vector<Move> Book::lookup(const GameSnapshot& snapshot) const
+{
+    std::vector<Move> moves;
+    for (const auto& entry : lookup(snapshot.zobrist_hash())) {
+        if (auto move = entry.move.decode(snapshot)) {
+            moves.push_back(*move);
+        }
+    }
+
+    return moves;
+}
+
+std::span<const Book::MoveEntry> Book::lookup(const zobrist::Hash& hash) const
 {
     auto it
         = std::lower_bound(m_data.entries.begin(), m_data.entries.end(), hash, [](const auto& entry, const auto& hash) {
               return entry.hash < hash;
           });
 
-    if (it != m_data.entries.end() && it->hash == hash) {
-        return { m_data.moves.begin() + it->offset, it->count };
+    // Entries in a book file aren't checked when it's opened, so make sure this one
+    // doesn't point outside of the moves
+    if (it != m_data.entries.end() && it->hash == hash && size_t(it->offset) + it->count <= m_data.moves.size()) {
+        return m_data.moves.subspan(it->offset, it->count);
+    }
+
+    return {};
+}
+
+std::optional<Move> Book::select(
+    const GameSnapshot& snapshot, const Selection& selection, std::default_random_engine& random_engine) const
+{
+    std::vector<std::pair<Move, const MoveEntry*>> candidates;
+    for (const auto& entry : lookup(snapshot.zobrist_hash())) {
+        if (entry.count < std::max(selection.min_count, uint32_t(1)))
+            continue;
+
+        if (auto move = entry.move.decode(snapshot))
+            candidates.emplace_back(*move, &entry);
+    }
+
+    if (candidates.empty())
+        return {};
+
+    switch (selection.policy) {
+    case Policy::Weighted: {
+        auto total_count = std::accumulate(candidates.begin(), candidates.end(), uint64_t(0),
+            [](uint64_t sum, const auto& candidate) { return sum + candidate.second->count; });
+
+        auto choice = std::uniform_int_distribution<uint64_t>(0, total_count - 1)(random_engine);
+        for (const auto& [move, entry] : candidates) {
+            if (choice < entry->count)
+                return move;
+
+            choice -= entry->count;
+        }
+
+        return candidates.back().first;
+    }
+    case Policy::BestScore: {
+        auto color = snapshot.turn_to_move;
+        auto best = std::max_element(candidates.begin(), candidates.end(), [&](const auto& lhs, const auto& rhs) {
+            return std::make_pair(lhs.second->score(color), lhs.second->count)
+                < std::make_pair(rhs.second->score(color), rhs.second->count);
+        });
+
+        return best->first;
+    }
     }
 
     return {};
 }
 
+double Book::MoveEntry::score(Color color) const
+{
+    auto games = double(white_wins) + double(draws) + double(black_wins);
+    if (games == 0)
+        return 0;
+
+    auto wins = double(color == Color::White ? white_wins : black_wins);
+    auto mean = (wins + 0.5 * double(draws)) / games;
+
+    // Lower bound of the Wilson score interval
+    constexpr double z = 1.96;
+    auto center = mean + z * z / (2 * games);
+    auto margin = z * std::sqrt(mean * (1 - mean) / games + z * z / (4 * games * games));
+    return (center - margin) / (1 + z * z / games);
+}
+
+const Book::Data& Book::data() const { return m_data; }
+
 const Book Book::default_instance(generated::book_data);
 
 }
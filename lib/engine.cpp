@@ -1,3 +1,8 @@
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #include <weechess/book.h>
 #include <weechess/engine.h>
 #include <weechess/searcher.h>
@@ -6,6 +11,26 @@
 
 namespace weechess {
 
+namespace {
+
+    constexpr size_t default_moves_to_go = 30;
+
+    // Kept back from every move for the time it takes to report it, so the clock never quite runs out
+    constexpr std::chrono::duration<size_t, std::milli> move_overhead { 20 };
+
+}
+
+std::chrono::duration<size_t, std::milli> time_for_move(std::chrono::duration<size_t, std::milli> remaining,
+    std::chrono::duration<size_t, std::milli> increment,
+    std::optional<size_t> moves_to_go)
+{
+    using Milliseconds = std::chrono::duration<size_t, std::milli>;
+
+    auto usable = remaining > 2 * move_overhead ? remaining - move_overhead : remaining / 2;
+    auto share = usable / std::max<size_t>(moves_to_go.value_or(default_moves_to_go), 1) + increment * 3 / 4;
+    return std::clamp(share, Milliseconds(1), std::max(usable, Milliseconds(1)));
+}
+
 Engine::Engine()
     : Engine(Settings())
 {
@@ -23,12 +48,23 @@ SearchResult Engine::calculate(const GameState& game_state,
     SearchDelegate& delegate)
 {
     // First, check if we have a book move
-    auto book_moves = Book::default_instance.lookup(game_state.snapshot());
-    if (!book_moves.empty()) {
-        auto book_move = book_moves[m_random_engine() % book_moves.size()];
+    const auto& snapshot = game_state.snapshot();
+    auto ply = (size_t(std::max<uint16_t>(snapshot.fullmove_number, 1)) - 1) * 2
+        + (snapshot.turn_to_move == Color::Black ? 1 : 0);
+
+    std::optional<Move> book_move;
+    if (ply < m_settings.book_depth) {
+        if (m_settings.polyglot_book.has_value())
+            book_move = m_settings.polyglot_book->select(snapshot, m_random_engine);
+
+        if (!book_move.has_value())
+            book_move = m_settings.book.select(snapshot, m_settings.book_selection, m_random_engine);
+    }
+
+    if (book_move.has_value()) {
         return SearchResult {
             .evaluation = Evaluation::zero(),
-            .best_line = { book_move },
+            .best_line = { *book_move },
             .is_book_move = true,
         };
     }
@@ -37,31 +73,69 @@ SearchResult Engine::calculate(const GameState& game_state,
     // reach it. If we do then good for us - we've beaten chess :)
     auto max_depth_to_search = parameters.max_depth.value_or(100000);
 
-    auto time_start = std::chrono::high_resolution_clock::now();
-    auto time_of_last_perf_event = time_start;
+    using namespace std::chrono;
+    auto time_start = steady_clock::now();
+    auto elapsed_since_start = [&]() { return duration_cast<milliseconds>(steady_clock::now() - time_start); };
+
+    if (m_settings.transposition_table == nullptr)
+        m_settings.transposition_table = std::make_shared<TranspositionTable>();
+
+    Searcher searcher(parameters.features, m_settings.analysis_cache, m_settings.transposition_table);
+    threading::Token stop;
     SearchResult result;
 
-    Searcher().search(game_state, max_depth_to_search, [&, this](const auto& progress, auto& control) {
-        using namespace std::chrono;
-        auto time_now = high_resolution_clock::now();
-        auto time_elapsed = duration_cast<milliseconds>(time_now - time_start);
-        auto time_since_last_perf_event = duration_cast<milliseconds>(time_now - time_of_last_perf_event);
-        auto nodes_per_second = (1000 * progress.nodes_searched()) / time_elapsed.count();
-
-        // Emit a performance event every so often
-        if (time_since_last_perf_event > m_settings.perf_event_interval || progress.has_new_results()) {
-            PerformanceEvent evt;
-            evt.current_depth = progress.max_depth();
-            evt.nodes_searched = progress.nodes_searched();
-            evt.elapsed_time = time_elapsed;
-            if (time_elapsed.count() != 0)
-                evt.nodes_per_second = nodes_per_second;
-
-            delegate.on_performance_event(evt);
-            time_of_last_perf_event = time_now;
+    // Delegate calls come from both the search and the reporter thread, so they're serialized
+    std::mutex mutex;
+    std::condition_variable finished_condition;
+    bool finished = false;
+
+    auto emit_performance_event = [&](size_t depth, size_t nodes_searched, size_t quiescence_nodes_searched) {
+        auto time_elapsed = elapsed_since_start();
+
+        PerformanceEvent evt {};
+        evt.current_depth = depth;
+        evt.nodes_searched = nodes_searched;
+        evt.quiescence_nodes_searched = quiescence_nodes_searched;
+        evt.elapsed_time = time_elapsed;
+        if (time_elapsed.count() != 0)
+            evt.nodes_per_second = (1000 * nodes_searched) / time_elapsed.count();
+
+        delegate.on_performance_event(evt);
+    };
+
+    // The search itself only polls a flag, so everything that needs a clock (the time limit,
+    // periodic performance events) or needs to watch the caller's token is handled here
+    std::thread reporter([&]() {
+        std::unique_lock lock(mutex);
+        auto next_perf_event = m_settings.perf_event_interval;
+        while (!finished) {
+            finished_condition.wait_for(lock, m_settings.stop_poll_interval);
+            if (finished)
+                break;
+
+            auto time_elapsed = elapsed_since_start();
+            auto reached_max_time
+                = parameters.max_search_time.has_value() && time_elapsed >= *parameters.max_search_time;
+
+            if (token.invalidated() || reached_max_time)
+                stop.invalidate();
+
+            if (time_elapsed >= next_perf_event) {
+                emit_performance_event(
+                    searcher.current_depth(), searcher.nodes_searched(), searcher.quiescence_nodes_searched());
+                next_perf_event = time_elapsed + m_settings.perf_event_interval;
+            }
         }
+    });
+
+    searcher.search(
+        game_state,
+        max_depth_to_search,
+        [&](const auto& progress, auto&) {
+            std::lock_guard lock(mutex);
+            emit_performance_event(
+                progress.max_depth(), progress.nodes_searched(), progress.quiescence_nodes_searched());
 
-        if (progress.has_new_results()) {
             EvaluationEvent evt;
             evt.best_line = progress.best_line();
             evt.evaluation = progress.evaluation();
@@ -69,23 +143,23 @@ SearchResult Engine::calculate(const GameState& game_state,
 
             result.evaluation = evt.evaluation;
             result.best_line = evt.best_line;
-        }
-
-        // Update search control
-        control.next_control_event = progress.nodes_searched() + 50000;
-
-        auto invalidated = token.invalidated();
-        auto reached_max_nodes = false;
-        auto reached_max_time = false;
-
-        if (parameters.max_nodes.has_value())
-            reached_max_nodes = progress.nodes_searched() >= *parameters.max_nodes;
+        },
+        stop,
+        parameters.max_nodes);
+
+    // The periodic events lag behind, so the delegate always gets to see the totals the search ended with
+    {
+        std::lock_guard lock(mutex);
+        finished = true;
+        emit_performance_event(
+            searcher.current_depth(), searcher.nodes_searched(), searcher.quiescence_nodes_searched());
+    }
 
-        if (parameters.max_search_time.has_value())
-            reached_max_time = time_elapsed >= *parameters.max_search_time;
+    finished_condition.notify_all();
+    reporter.join();
 
-        control.stop = invalidated || reached_max_nodes || reached_max_time;
-    });
+    if (m_settings.analysis_cache != nullptr && !m_settings.analysis_cache->flush())
+        log::warn("Unable to write to the analysis cache");
 
     return result;
 }
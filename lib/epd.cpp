@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+
+#include <weechess/epd.h>
+#include <weechess/move_query.h>
+
+namespace weechess::epd {
+
+namespace {
+
+    constexpr size_t position_field_count = 4;
+
+    bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    std::optional<uint16_t> parse_clock(std::string_view text)
+    {
+        uint16_t value = 0;
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error != std::errc() || end != text.data() + text.size())
+            return {};
+
+        return value;
+    }
+
+    class Parser {
+    public:
+        explicit Parser(std::string_view text)
+            : m_text(text)
+        {
+        }
+
+        std::optional<Record> parse(ParseError* error)
+        {
+            m_error = error;
+
+            skip_spaces();
+            auto position_begin = m_position;
+            for (size_t i = 0; i < position_field_count; i++) {
+                if (read_field().empty())
+                    return fail("Expected the four fields of a position");
+            }
+
+            // The FEN parser wants the clocks too, which are filled in properly once the operations are read
+            auto position = std::string(m_text.substr(position_begin, m_position - position_begin)) + " 0 1";
+            ParseError fen_error;
+            auto snapshot = fen::from_fen(position, &fen_error);
+            if (!snapshot.has_value()) {
+                m_position = position_begin + fen_error.position;
+                return fail(fen_error.reason);
+            }
+
+            Record record { .snapshot = *snapshot };
+
+            // Some suites use whole FENs, clocks and all
+            auto clocks_begin = m_position;
+            auto halfmove_clock = parse_clock(read_field());
+            auto fullmove_number = parse_clock(read_field());
+            if (halfmove_clock.has_value() && fullmove_number.has_value()) {
+                record.snapshot.halfmove_clock = *halfmove_clock;
+                record.snapshot.fullmove_number = *fullmove_number;
+            } else {
+                m_position = clocks_begin;
+            }
+
+            while (skip_spaces(), !at_end()) {
+                auto operation = read_operation();
+                if (!operation.has_value())
+                    return {};
+
+                record.operations.push_back(std::move(*operation));
+            }
+
+            if (!read_clock(record, "hmvc", record.snapshot.halfmove_clock)
+                || !read_clock(record, "fmvn", record.snapshot.fullmove_number))
+                return {};
+
+            return record;
+        }
+
+    private:
+        std::string_view m_text;
+        size_t m_position { 0 };
+        ParseError* m_error { nullptr };
+
+        bool at_end() const { return m_position >= m_text.size(); }
+
+        std::nullopt_t fail(std::string_view reason)
+        {
+            if (m_error != nullptr)
+                *m_error = ParseError { .position = m_position, .reason = reason };
+
+            return std::nullopt;
+        }
+
+        void skip_spaces()
+        {
+            while (!at_end() && is_space(m_text[m_position]))
+                m_position++;
+        }
+
+        std::string_view read_field()
+        {
+            skip_spaces();
+            auto begin = m_position;
+            while (!at_end() && !is_space(m_text[m_position]))
+                m_position++;
+
+            return m_text.substr(begin, m_position - begin);
+        }
+
+        std::optional<Operation> read_operation()
+        {
+            Operation operation;
+
+            auto begin = m_position;
+            while (!at_end() && !is_space(m_text[m_position]) && m_text[m_position] != ';')
+                m_position++;
+
+            operation.opcode = m_text.substr(begin, m_position - begin);
+            if (operation.opcode.empty())
+                return fail("Expected an opcode");
+
+            while (true) {
+                skip_spaces();
+
+                // Being forgiving of a missing semicolon at the end of the line, since that's a common slip
+                if (at_end())
+                    break;
+
+                if (m_text[m_position] == ';') {
+                    m_position++;
+                    break;
+                }
+
+                if (m_text[m_position] == '"') {
+                    auto end = m_text.find('"', m_position + 1);
+                    if (end == std::string_view::npos)
+                        return fail("Unterminated string operand");
+
+                    operation.operands.emplace_back(m_text.substr(m_position + 1, end - m_position - 1));
+                    m_position = end + 1;
+                    continue;
+                }
+
+                begin = m_position;
+                while (!at_end() && !is_space(m_text[m_position]) && m_text[m_position] != ';')
+                    m_position++;
+
+                operation.operands.emplace_back(m_text.substr(begin, m_position - begin));
+            }
+
+            return operation;
+        }
+
+        bool read_clock(const Record& record, std::string_view opcode, uint16_t& clock)
+        {
+            const auto* operation = record.find(opcode);
+            if (operation == nullptr)
+                return true;
+
+            auto value = operation->operands.size() == 1 ? parse_clock(operation->operands[0]) : std::nullopt;
+            if (!value.has_value()) {
+                fail("Expected a single number for a clock operation");
+                return false;
+            }
+
+            clock = *value;
+            return true;
+        }
+    };
+
+}
+
+const Operation* Record::find(std::string_view opcode) const
+{
+    auto it = std::find_if(operations.begin(), operations.end(), [&](const auto& op) { return op.opcode == opcode; });
+    return it != operations.end() ? &*it : nullptr;
+}
+
+std::optional<std::string_view> Record::id() const
+{
+    const auto* operation = find("id");
+    if (operation == nullptr || operation->operands.empty())
+        return {};
+
+    return operation->operands[0];
+}
+
+std::optional<std::vector<Move>> Record::moves(std::string_view opcode) const
+{
+    const auto* operation = find(opcode);
+    if (operation == nullptr)
+        return {};
+
+    GameState game_state(snapshot);
+    std::vector<Move> moves;
+    for (const auto& operand : operation->operands) {
+        // Suites sometimes annotate their moves, which isn't part of the SAN
+        auto notation = std::string_view(operand);
+        while (!notation.empty() && (notation.back() == '!' || notation.back() == '?'))
+            notation.remove_suffix(1);
+
+        auto query = PGNMoveQuery::from(notation);
+        if (!query.has_value())
+            return {};
+
+        auto legal_moves = game_state.move_set().find(*query);
+        if (legal_moves.size() != 1)
+            return {};
+
+        moves.push_back(legal_moves[0].move());
+    }
+
+    return moves;
+}
+
+std::optional<Record> from_epd(std::string_view text, ParseError* error) { return Parser(text).parse(error); }
+
+std::optional<std::vector<Record>> load(const std::filesystem::path& path, LoadError* error)
+{
+    std::ifstream stream(path);
+    if (!stream) {
+        if (error != nullptr)
+            *error = LoadError { .line = 0, .error = { .reason = "Unable to open file" } };
+
+        return {};
+    }
+
+    std::vector<Record> records;
+    size_t line_number = 0;
+    for (std::string line; std::getline(stream, line);) {
+        line_number++;
+
+        auto first = std::find_if(line.begin(), line.end(), [](char c) { return !is_space(c); });
+        if (first == line.end() || *first == '#')
+            continue;
+
+        ParseError parse_error;
+        auto record = from_epd(line, &parse_error);
+        if (!record.has_value()) {
+            if (error != nullptr)
+                *error = LoadError { .line = line_number, .error = parse_error };
+
+            return {};
+        }
+
+        records.push_back(std::move(*record));
+    }
+
+    return records;
+}
+
+}
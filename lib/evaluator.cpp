@@ -2,134 +2,66 @@
 
 #include <weechess/evaluator.h>
 
-namespace weechess {
-
-namespace {
-    // clang-format off
-    constexpr std::array<int, 64> pawns = {
-        0,  0,  0,  0,  0,  0,  0,  0,
-        50, 50, 50, 50, 50, 50, 50, 50,
-        10, 10, 20, 30, 30, 20, 10, 10,
-        5,  5, 10, 25, 25, 10,  5,  5,
-        0,  0,  0, 20, 20,  0,  0,  0,
-        5, -5,-10,  0,  0,-10, -5,  5,
-        5, 10, 10,-20,-20, 10, 10,  5,
-        0,  0,  0,  0,  0,  0,  0,  0
-    };
-
-    constexpr std::array<int, 64> knights = {
-        -50,-40,-30,-30,-30,-30,-40,-50,
-        -40,-20,  0,  0,  0,  0,-20,-40,
-        -30,  0, 10, 15, 15, 10,  0,-30,
-        -30,  5, 15, 20, 20, 15,  5,-30,
-        -30,  0, 15, 20, 20, 15,  0,-30,
-        -30,  5, 10, 15, 15, 10,  5,-30,
-        -40,-20,  0,  5,  5,  0,-20,-40,
-        -50,-40,-30,-30,-30,-30,-40,-50,
-    };
-
-    constexpr std::array<int, 64> bishops = {
-        -20,-10,-10,-10,-10,-10,-10,-20,
-        -10,  0,  0,  0,  0,  0,  0,-10,
-        -10,  0,  5, 10, 10,  5,  0,-10,
-        -10,  5,  5, 10, 10,  5,  5,-10,
-        -10,  0, 10, 10, 10, 10,  0,-10,
-        -10, 10, 10, 10, 10, 10, 10,-10,
-        -10,  5,  0,  0,  0,  0,  5,-10,
-        -20,-10,-10,-10,-10,-10,-10,-20,
-    };
-
-    constexpr std::array<int, 64> rooks = {
-        0,  0,  0,  0,  0,  0,  0,  0,
-        5, 10, 10, 10, 10, 10, 10,  5,
-        -5,  0,  0,  0,  0,  0,  0, -5,
-        -5,  0,  0,  0,  0,  0,  0, -5,
-        -5,  0,  0,  0,  0,  0,  0, -5,
-        -5,  0,  0,  0,  0,  0,  0, -5,
-        -5,  0,  0,  0,  0,  0,  0, -5,
-        0,  0,  0,  5,  5,  0,  0,  0
-    };
-
-    constexpr std::array<int, 64> queens = {
-        -20,-10,-10, -5, -5,-10,-10,-20,
-        -10,  0,  0,  0,  0,  0,  0,-10,
-        -10,  0,  5,  5,  5,  5,  0,-10,
-        -5,  0,  5,  5,  5,  5,  0, -5,
-        0,  0,  5,  5,  5,  5,  0, -5,
-        -10,  5,  5,  5,  5,  5,  0,-10,
-        -10,  0,  5,  0,  0,  0,  0,-10,
-        -20,-10,-10, -5, -5,-10,-10,-20
-    };
-
-    constexpr std::array<int, 64> kingMiddle = {
-        -30,-40,-40,-50,-50,-40,-40,-30,
-        -30,-40,-40,-50,-50,-40,-40,-30,
-        -30,-40,-40,-50,-50,-40,-40,-30,
-        -30,-40,-40,-50,-50,-40,-40,-30,
-        -20,-30,-30,-40,-40,-30,-30,-20,
-        -10,-20,-20,-20,-20,-20,-20,-10,
-        20, 20,  0,  0,  0,  0, 20, 20,
-        20, 30, 10,  0,  0, 10, 30, 20
-    };
+#include "generated/evaluator_weights.h"
 
-    constexpr std::array<int, 64> kingEnd = {
-        -50,-40,-30,-20,-20,-30,-40,-50,
-        -30,-20,-10,  0,  0,-10,-20,-30,
-        -30,-10, 20, 30, 30, 20,-10,-30,
-        -30,-10, 30, 40, 40, 30,-10,-30,
-        -30,-10, 30, 40, 40, 30,-10,-30,
-        -30,-10, 20, 30, 30, 20,-10,-30,
-        -30,-30,  0,  0,  0,  0,-30,-30,
-        -50,-30,-30,-30,-30,-30,-30,-50
-    };
-    // clang-format on
-}
+namespace weechess {
 
 const Evaluator Evaluator::default_instance = Evaluator();
 
 struct EvaluationParameters {
+    const EvaluatorWeights& weights;
     float normalized_end_game_weight;
 };
 
-template <typename... Args>
-Evaluation reduce(const GameState& game_state, const EvaluationParameters& params, const Args&&... args)
+// Each evaluator is instantiated for the side to move, so that flipping the result into
+// their point of view is decided at compile time instead of in every term
+template <Color C, typename... Args>
+Evaluation reduce(const GameSnapshot& snapshot, const EvaluationParameters& params, const Args&&... args)
 {
-    return (... + ([&](const auto& e) { return e(game_state, params); })(args));
+    return (... + ([&](const auto& e) { return e.template evaluate<C>(snapshot, params); })(args));
+}
+
+template <Color C> Evaluation relative_to(Evaluation evaluation)
+{
+    if constexpr (C == Color::White)
+        return evaluation;
+    else
+        return evaluation.invert();
 }
 
 // Sum up the material value of each piece on the board for each color
 struct MaterialEvaluator {
-    Evaluation operator()(const GameState& game_state, const EvaluationParameters&) const
+    template <Color C> Evaluation evaluate(const GameSnapshot& snapshot, const EvaluationParameters& params) const
     {
-        const auto& board = game_state.board();
+        const auto& board = snapshot.board;
 
         ColorMap<int> material_value { 0 };
         for (const auto& piece : Piece::all_valid_pieces) {
             const auto occupancy = board.occupancy_for(piece);
-            material_value[piece.color] += Evaluation::piece_worth(piece.type) * occupancy.count();
+            material_value[piece.color]
+                += params.weights.material[static_cast<int>(piece.type)] * static_cast<int>(occupancy.count());
         }
 
-        auto evaluation = Evaluation { material_value[Color::White] - material_value[Color::Black] };
-        return game_state.turn_to_move() == Color::White ? evaluation : evaluation.invert();
+        return relative_to<C>(Evaluation { material_value[Color::White] - material_value[Color::Black] });
     }
 };
 
 // If there aren't too many pieces left on the board and we have a winning advantage,
 // we should try to force the king to the edge of the board
 struct ForceKingToEdgeEvaluator {
-    Evaluation operator()(const GameState& game_state, const EvaluationParameters& params) const
+    template <Color C> Evaluation evaluate(const GameSnapshot& snapshot, const EvaluationParameters& params) const
     {
         if (params.normalized_end_game_weight < 0.5f)
             return { 0 };
 
-        auto white_piece_count = game_state.board().color_occupancy()[Color::White].count();
-        auto black_piece_count = game_state.board().color_occupancy()[Color::Black].count();
+        auto white_piece_count = snapshot.board.color_occupancy()[Color::White].count();
+        auto black_piece_count = snapshot.board.color_occupancy()[Color::Black].count();
 
         if (white_piece_count < black_piece_count + 2)
             return { 0 };
 
-        auto white_king_location = game_state.board().occupancy_for(Piece(Piece::Type::King, Color::White)).lsb();
-        auto black_king_location = game_state.board().occupancy_for(Piece(Piece::Type::King, Color::Black)).lsb();
+        auto white_king_location = snapshot.board.occupancy_for(Piece(Piece::Type::King, Color::White)).lsb();
+        auto black_king_location = snapshot.board.occupancy_for(Piece(Piece::Type::King, Color::Black)).lsb();
         if (!white_king_location.has_value() || !black_king_location.has_value())
             return { 0 };
 
@@ -138,53 +70,30 @@ struct ForceKingToEdgeEvaluator {
             + black_king_location->distance_to_nearest_file_edge();
 
         int absolute_evaluation = ((10 * edge_to_black_king_distance) - kings_distance);
-        auto evaluation = Evaluation { static_cast<int>(absolute_evaluation * params.normalized_end_game_weight) };
-        return game_state.turn_to_move() == Color::White ? evaluation : evaluation.invert();
+        return relative_to<C>(Evaluation { static_cast<int>(absolute_evaluation * params.normalized_end_game_weight) });
     }
 };
 
 struct GoodSquaresForPiecesEvaluator {
-    Evaluation operator()(const GameState& game_state, const EvaluationParameters& params) const
+    template <Color C> Evaluation evaluate(const GameSnapshot& snapshot, const EvaluationParameters& params) const
     {
         auto evaluation = Evaluation::zero();
-        auto color = game_state.turn_to_move();
         for (const auto type : Piece::types) {
-            auto occupancy = game_state.board().occupancy_for(Piece(type, color));
+            const auto& squares = (type == Piece::Type::King && params.normalized_end_game_weight >= 0.5f)
+                ? params.weights.king_end_game_squares
+                : params.weights.piece_squares[static_cast<int>(type)];
+
+            auto occupancy = snapshot.board.occupancy_for(Piece(type, C));
             while (occupancy.any()) {
                 auto location = occupancy.pop_lsb();
                 auto board_index = location->offset;
-                if (color == Color::White) {
+                if constexpr (C == Color::White) {
                     auto file = location->file();
                     auto rank = 7 - location->rank();
                     board_index = rank * 8 + file;
                 }
 
-                switch (type) {
-                case Piece::Type::Pawn:
-                    evaluation += pawns[board_index];
-                    break;
-                case Piece::Type::Knight:
-                    evaluation += knights[board_index];
-                    break;
-                case Piece::Type::Bishop:
-                    evaluation += bishops[board_index];
-                    break;
-                case Piece::Type::Rook:
-                    evaluation += rooks[board_index];
-                    break;
-                case Piece::Type::Queen:
-                    evaluation += queens[board_index];
-                    break;
-                case Piece::Type::King:
-                    if (params.normalized_end_game_weight < 0.5f)
-                        evaluation += kingMiddle[board_index];
-                    else
-                        evaluation += kingEnd[board_index];
-
-                    break;
-                default:
-                    break;
-                }
+                evaluation += squares[board_index];
             }
         }
 
@@ -192,9 +101,20 @@ struct GoodSquaresForPiecesEvaluator {
     }
 };
 
-float compute_normalized_end_game_weight(const GameState& game_state)
+template <Color C> Evaluation evaluate_for(const GameSnapshot& snapshot, const EvaluationParameters& parameters)
 {
-    const auto& board = game_state.board();
+    // clang-format off
+    return reduce<C>(snapshot, parameters,
+        MaterialEvaluator(),
+        ForceKingToEdgeEvaluator(),
+        GoodSquaresForPiecesEvaluator()
+    );
+    // clang-format on
+}
+
+float compute_normalized_end_game_weight(const GameSnapshot& snapshot)
+{
+    const auto& board = snapshot.board;
     auto count_pieces = [&](Piece::Type type) {
         return board.occupancy_for(Piece(type, Color::White)).count()
             + board.occupancy_for(Piece(type, Color::Black)).count();
@@ -215,6 +135,18 @@ float compute_normalized_end_game_weight(const GameState& game_state)
     return 1.0f - (w1 * v1 + w2 * v2 + w3 * v3) / (w1 + w2 + w3);
 }
 
+Evaluator::Evaluator()
+    : Evaluator(generated::evaluator_weights)
+{
+}
+
+Evaluator::Evaluator(const EvaluatorWeights& weights)
+    : m_weights(weights)
+{
+}
+
+const EvaluatorWeights& Evaluator::weights() const { return m_weights; }
+
 Evaluation Evaluator::evaluate(const GameState& state) const
 {
     if (state.is_checkmate()) {
@@ -223,16 +155,27 @@ Evaluation Evaluator::evaluate(const GameState& state) const
         return Evaluation { 0 };
     }
 
+    return evaluate(state.snapshot());
+}
+
+Evaluation Evaluator::evaluate(const GameSnapshot& snapshot) const
+{
     EvaluationParameters parameters = {
-        .normalized_end_game_weight = compute_normalized_end_game_weight(state),
+        .weights = m_weights,
+        .normalized_end_game_weight = compute_normalized_end_game_weight(snapshot),
     };
 
-    // clang-format off
-    return reduce(state, parameters,
-        MaterialEvaluator(),
-        ForceKingToEdgeEvaluator(),
-        GoodSquaresForPiecesEvaluator()
-    );
-    // clang-format on
+    if (snapshot.turn_to_move == Color::White)
+        return evaluate_for<Color::White>(snapshot, parameters);
+    else
+        return evaluate_for<Color::Black>(snapshot, parameters);
+}
+
+void Evaluator::evaluate(std::span<const GameSnapshot> snapshots, std::span<Evaluation> evaluations) const
+{
+    assert(snapshots.size() == evaluations.size());
+    for (size_t i = 0; i < snapshots.size(); i++) {
+        evaluations[i] = evaluate(snapshots[i]);
+    }
 }
 }
@@ -1,259 +1,356 @@
-#include <iostream>
-#include <regex>
+#include <array>
+#include <limits>
 
 #include <weechess/color_map.h>
+#include <weechess/fen.h>
 #include <weechess/location.h>
 #include <weechess/piece.h>
 
-#include "fen.h"
-
 namespace weechess::fen {
-constexpr const char* regex_string
-    = R"(^(((?:[rnbqkpRNBQKP1-8]+\/){7})[rnbqkpRNBQKP1-8]+)\s([b|w])\s(-|([K|Q|k|q]{1,4}))\s(-|[a-h][1-8])\s(\d+)\s(\d+)$)";
-
-namespace groups {
-    constexpr size_t count = 9;
-
-    constexpr size_t board = 1;
-    constexpr size_t turn_to_move = 3;
-    constexpr size_t castle_rights = 4;
-    constexpr size_t en_passant_target = 6;
-    constexpr size_t half_move_clock = 7;
-    constexpr size_t full_move_number = 8;
-}
 
-constexpr char white_pawn = 'P';
-constexpr char white_knight = 'N';
-constexpr char white_bishop = 'B';
-constexpr char white_rook = 'R';
-constexpr char white_queen = 'Q';
-constexpr char white_king = 'K';
-constexpr char black_pawn = 'p';
-constexpr char black_knight = 'n';
-constexpr char black_bishop = 'b';
-constexpr char black_rook = 'r';
-constexpr char black_queen = 'q';
-constexpr char black_king = 'k';
-
-std::optional<Board> board_from_fen_fragment(std::string_view fragment);
-ColorMap<CastleRights> castle_rights_from_fen_fragment(std::string_view fragment);
-std::optional<Location> location_from_fen_fragment(std::string_view fragment);
-std::optional<Piece> piece_from_fen(char c);
-std::optional<char> piece_to_fen(const Piece& piece);
+namespace {
+
+    constexpr char white_pawn = 'P';
+    constexpr char white_knight = 'N';
+    constexpr char white_bishop = 'B';
+    constexpr char white_rook = 'R';
+    constexpr char white_queen = 'Q';
+    constexpr char white_king = 'K';
+    constexpr char black_pawn = 'p';
+    constexpr char black_knight = 'n';
+    constexpr char black_bishop = 'b';
+    constexpr char black_rook = 'r';
+    constexpr char black_queen = 'q';
+    constexpr char black_king = 'k';
+
+    constexpr char separator = ' ';
+    constexpr char rank_separator = '/';
+    constexpr char none = '-';
+
+    std::optional<Piece> piece_from_fen(char c)
+    {
+        switch (c) {
+        case white_pawn:
+            return Piece(Piece::Type::Pawn, Color::White);
+        case white_knight:
+            return Piece(Piece::Type::Knight, Color::White);
+        case white_bishop:
+            return Piece(Piece::Type::Bishop, Color::White);
+        case white_rook:
+            return Piece(Piece::Type::Rook, Color::White);
+        case white_queen:
+            return Piece(Piece::Type::Queen, Color::White);
+        case white_king:
+            return Piece(Piece::Type::King, Color::White);
+        case black_pawn:
+            return Piece(Piece::Type::Pawn, Color::Black);
+        case black_knight:
+            return Piece(Piece::Type::Knight, Color::Black);
+        case black_bishop:
+            return Piece(Piece::Type::Bishop, Color::Black);
+        case black_rook:
+            return Piece(Piece::Type::Rook, Color::Black);
+        case black_queen:
+            return Piece(Piece::Type::Queen, Color::Black);
+        case black_king:
+            return Piece(Piece::Type::King, Color::Black);
+        default:
+            return {};
+        }
+    }
 
-std::string to_fen(const GameSnapshot& snapshot)
-{
-    const auto& cells = snapshot.board.to_array();
-    const auto& turn_to_move = snapshot.turn_to_move;
-    const auto& castle_rights = snapshot.castle_rights;
-    const auto& en_passant_target = snapshot.en_passant_target;
+    char piece_to_fen(Piece piece)
+    {
+        constexpr std::array<char, 6> white_pieces
+            = { white_pawn, white_knight, white_bishop, white_rook, white_queen, white_king };
+        constexpr std::array<char, 6> black_pieces
+            = { black_pawn, black_knight, black_bishop, black_rook, black_queen, black_king };
 
-    std::string fen_str;
-    uint8_t space_count = 0;
-    for (size_t i = 0; i < Board::cell_count; i++) {
+        auto index = static_cast<uint8_t>(piece.type) - static_cast<uint8_t>(Piece::Type::Pawn);
+        return piece.is(Color::White) ? white_pieces[index] : black_pieces[index];
+    }
 
-        Location l(i);
-        Location corrected = Location::from_rank_and_file(7 - l.rank(), l.file());
+    /*
+    Parses a FEN in one pass from left to right, checking it as it goes. Every step either
+    consumes its part of the FEN or records where and why it gave up, so a bad FEN in a large
+    file can be pointed at precisely.
+    */
+    class Parser {
+    public:
+        explicit Parser(std::string_view fen)
+            : m_fen(fen)
+        {
+        }
 
-        if (i % 8 == 0 && i != 0) {
-            if (space_count > 0) {
-                fen_str += std::to_string(space_count);
-                space_count = 0;
+        std::optional<GameSnapshot> parse(ParseError* error)
+        {
+            Board::Buffer board;
+            Color turn_to_move = Color::White;
+            ColorMap<CastleRights> castle_rights(CastleRights::none());
+            std::optional<Location> en_passant_target;
+            uint16_t halfmove_clock = 0;
+            uint16_t fullmove_number = 0;
+
+            bool parsed = parse_board(board) && expect(separator, "Expected a space after the board")
+                && parse_turn_to_move(turn_to_move) && expect(separator, "Expected a space after the side to move")
+                && parse_castle_rights(castle_rights) && expect(separator, "Expected a space after the castle rights")
+                && parse_en_passant_target(en_passant_target)
+                && expect(separator, "Expected a space after the en passant target")
+                && parse_counter(halfmove_clock) && expect(separator, "Expected a space after the halfmove clock")
+                && parse_counter(fullmove_number) && expect_end();
+
+            if (!parsed) {
+                if (error != nullptr)
+                    *error = m_error;
+
+                return {};
             }
 
-            fen_str += '/';
+            return GameSnapshot(
+                Board(board), turn_to_move, castle_rights, en_passant_target, halfmove_clock, fullmove_number);
         }
 
-        auto fen_char = piece_to_fen(cells[corrected.offset]);
-        if (fen_char.has_value()) {
-            if (space_count > 0) {
-                fen_str += std::to_string(space_count);
-                space_count = 0;
-            }
+    private:
+        std::string_view m_fen;
+        size_t m_position { 0 };
+        ParseError m_error {};
 
-            fen_str += fen_char.value();
-        } else {
-            space_count++;
+        bool fail(std::string_view reason)
+        {
+            m_error = { m_position, reason };
+            return false;
         }
-    }
 
-    if (space_count > 0) {
-        fen_str += std::to_string(space_count);
-    }
+        bool at_end() const { return m_position >= m_fen.size(); }
+        char peek() const { return at_end() ? '\0' : m_fen[m_position]; }
 
-    fen_str += " ";
-    fen_str += turn_to_move == Color::White ? 'w' : 'b';
+        bool expect(char c, std::string_view reason)
+        {
+            if (peek() != c)
+                return fail(reason);
 
-    fen_str += " ";
-    if (castle_rights[Color::White].has_rights() || castle_rights[Color::Black].has_rights()) {
-        if (castle_rights[Color::White].can_castle_kingside)
-            fen_str += 'K';
-        if (castle_rights[Color::White].can_castle_queenside)
-            fen_str += 'Q';
-        if (castle_rights[Color::Black].can_castle_kingside)
-            fen_str += 'k';
-        if (castle_rights[Color::Black].can_castle_queenside)
-            fen_str += 'q';
-    } else {
-        fen_str += "-";
-    }
+            m_position++;
+            return true;
+        }
 
-    fen_str += " ";
-    if (en_passant_target.has_value()) {
-        fen_str += en_passant_target.value().to_string();
-    } else {
-        fen_str += "-";
-    }
+        bool expect_end() { return at_end() || fail("Unexpected characters after the fullmove number"); }
+
+        bool parse_board(Board::Buffer& board)
+        {
+            for (int rank = 7; rank >= 0; rank--) {
+                if (rank != 7 && !expect(rank_separator, "Expected '/' after eight squares"))
+                    return false;
+
+                int file = 0;
+                while (file < 8) {
+                    auto c = peek();
+                    if (c >= '1' && c <= '8') {
+                        file += c - '0';
+                        if (file > 8)
+                            return fail("Too many squares in rank");
+                    } else if (auto piece = piece_from_fen(c)) {
+                        board.set_piece(*piece, Location::from_rank_and_file(rank, file));
+                        file++;
+                    } else if (c == rank_separator || c == separator || at_end()) {
+                        return fail("Too few squares in rank");
+                    } else {
+                        return fail("Expected a piece or a number of empty squares");
+                    }
+
+                    m_position++;
+                }
+            }
 
-    fen_str += " " + std::to_string(snapshot.halfmove_clock);
-    fen_str += " " + std::to_string(snapshot.fullmove_number);
+            return true;
+        }
 
-    return fen_str;
-}
+        bool parse_turn_to_move(Color& turn_to_move)
+        {
+            switch (peek()) {
+            case 'w':
+                turn_to_move = Color::White;
+                break;
+            case 'b':
+                turn_to_move = Color::Black;
+                break;
+            default:
+                return fail("Expected 'w' or 'b' for the side to move");
+            }
 
-std::optional<GameSnapshot> from_fen(std::string_view fen_sv)
-{
-    std::regex re(regex_string);
-    std::match_results<std::string_view::const_iterator> match;
-    auto flags = std::regex_constants::match_default;
+            m_position++;
+            return true;
+        }
 
-    if (!std::regex_match(fen_sv.begin(), fen_sv.end(), match, re, flags)) {
-        return {};
-    }
+        bool parse_castle_rights(ColorMap<CastleRights>& castle_rights)
+        {
+            if (peek() == none) {
+                m_position++;
+                return true;
+            }
 
-    if (match.size() != groups::count) {
-        return {};
-    }
+            auto start = m_position;
+            uint8_t seen = 0;
+            for (; !at_end() && peek() != separator; m_position++) {
+                uint8_t right;
+                switch (peek()) {
+                case white_king:
+                    right = 1 << 0;
+                    castle_rights[Color::White].can_castle_kingside = true;
+                    break;
+                case white_queen:
+                    right = 1 << 1;
+                    castle_rights[Color::White].can_castle_queenside = true;
+                    break;
+                case black_king:
+                    right = 1 << 2;
+                    castle_rights[Color::Black].can_castle_kingside = true;
+                    break;
+                case black_queen:
+                    right = 1 << 3;
+                    castle_rights[Color::Black].can_castle_queenside = true;
+                    break;
+                default:
+                    return fail("Expected castle rights made up of 'KQkq' or '-'");
+                }
+
+                if (seen & right)
+                    return fail("Castle right given more than once");
+
+                seen |= right;
+            }
 
-    std::string board_string(match[groups::board].str());
-    std::string turn_to_move_string(match[groups::turn_to_move].str());
-    std::string castle_rights_string(match[groups::castle_rights].str());
-    std::string en_passant_target_string(match[groups::en_passant_target].str());
-    std::string half_move_clock_string(match[groups::half_move_clock].str());
-    std::string full_move_number_string(match[groups::full_move_number].str());
+            return m_position != start || fail("Expected castle rights made up of 'KQkq' or '-'");
+        }
 
-    Board board = board_from_fen_fragment(board_string).value();
-    Color turn_to_move = turn_to_move_string[0] == 'w' ? Color::White : Color::Black;
-    ColorMap<CastleRights> castle_rights = castle_rights_from_fen_fragment(castle_rights_string);
-    std::optional<Location> en_passant_target = location_from_fen_fragment(en_passant_target_string);
+        bool parse_en_passant_target(std::optional<Location>& en_passant_target)
+        {
+            if (peek() == none) {
+                m_position++;
+                return true;
+            }
 
-    size_t half_move_clock = std::stoul(half_move_clock_string);
-    size_t full_move_number = std::stoul(full_move_number_string);
+            auto file = peek();
+            if (file < 'a' || file > 'h')
+                return fail("Expected an en passant target square or '-'");
 
-    return GameSnapshot(board, turn_to_move, castle_rights, en_passant_target, half_move_clock, full_move_number);
-}
+            m_position++;
+            auto rank = peek();
+            if (rank < '1' || rank > '8')
+                return fail("Expected the rank of the en passant target square");
 
-std::optional<Board> board_from_fen_fragment(std::string_view fragment)
-{
-    Board::Builder builder;
-    size_t i = 0;
-    for (char c : fragment) {
-        if (c == ' ') {
-            break;
-        } else if (c == '/') {
-            continue;
-        } else if (std::isdigit(c)) {
-            i += (c - '0');
-        } else if (auto piece = piece_from_fen(c)) {
-            Location l(i);
-            Location corrected = Location::from_rank_and_file(7 - l.rank(), l.file());
-            builder[corrected.offset] = piece.value();
-            i++;
-        } else {
-            return {};
+            m_position++;
+            en_passant_target = Location::from_rank_and_file(rank - '1', file - 'a');
+            return true;
         }
-    }
 
-    return builder.build();
-}
+        bool parse_counter(uint16_t& counter)
+        {
+            auto c = peek();
+            if (c < '0' || c > '9')
+                return fail("Expected a number");
 
-ColorMap<CastleRights> castle_rights_from_fen_fragment(std::string_view fragment)
-{
-    ColorMap<CastleRights> castle_rights(CastleRights::none());
-    for (char c : fragment) {
-        switch (c) {
-        case white_king:
-            castle_rights[Color::White].can_castle_kingside = true;
-            break;
-        case black_king:
-            castle_rights[Color::Black].can_castle_kingside = true;
-            break;
-        case white_queen:
-            castle_rights[Color::White].can_castle_queenside = true;
-            break;
-        case black_queen:
-            castle_rights[Color::Black].can_castle_queenside = true;
-            break;
+            uint32_t value = 0;
+            for (; c >= '0' && c <= '9'; c = peek()) {
+                value = value * 10 + static_cast<uint32_t>(c - '0');
+                if (value > std::numeric_limits<uint16_t>::max())
+                    return fail("Number is too large");
+
+                m_position++;
+            }
+
+            counter = static_cast<uint16_t>(value);
+            return true;
         }
+    };
+
+    char* write_counter(char* out, uint16_t value)
+    {
+        // Written backwards into a scratch buffer, then copied out in the right order
+        std::array<char, 5> digits;
+        size_t count = 0;
+        do {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value > 0);
+
+        while (count > 0)
+            *out++ = digits[--count];
+
+        return out;
     }
 
-    return castle_rights;
 }
 
-std::optional<Location> location_from_fen_fragment(std::string_view fragment)
+std::optional<GameSnapshot> from_fen(std::string_view fen, ParseError* error) { return Parser(fen).parse(error); }
+
+std::string_view write_fen(const GameSnapshot& snapshot, Buffer& buffer)
 {
-    if (fragment.size() != 2) {
-        return std::nullopt;
-    }
+    const auto& board = snapshot.board.piece_buffer();
+    auto occupancy = snapshot.board.shared_occupancy();
+    char* out = buffer.data();
+
+    for (int rank = 7; rank >= 0; rank--) {
+        char empty_squares = 0;
+        for (int file = 0; file < 8; file++) {
+            auto location = Location::from_rank_and_file(rank, file);
+            if (!occupancy[location]) {
+                empty_squares++;
+                continue;
+            }
 
-    char file = fragment[0];
-    char rank = fragment[1];
+            if (empty_squares > 0) {
+                *out++ = static_cast<char>('0' + empty_squares);
+                empty_squares = 0;
+            }
+
+            *out++ = piece_to_fen(board.piece_at(location));
+        }
 
-    if (file < 'a' || file > 'h' || rank < '1' || rank > '8') {
-        return {};
+        if (empty_squares > 0)
+            *out++ = static_cast<char>('0' + empty_squares);
+
+        if (rank > 0)
+            *out++ = rank_separator;
     }
 
-    return Location::from_rank_and_file(rank - '1', file - 'a');
-}
+    *out++ = separator;
+    *out++ = snapshot.turn_to_move == Color::White ? 'w' : 'b';
 
-std::optional<Piece> piece_from_fen(char c)
-{
-    switch (c) {
-    case white_pawn:
-        return Piece(Piece::Type::Pawn, Color::White);
-    case white_knight:
-        return Piece(Piece::Type::Knight, Color::White);
-    case white_bishop:
-        return Piece(Piece::Type::Bishop, Color::White);
-    case white_rook:
-        return Piece(Piece::Type::Rook, Color::White);
-    case white_queen:
-        return Piece(Piece::Type::Queen, Color::White);
-    case white_king:
-        return Piece(Piece::Type::King, Color::White);
-    case black_pawn:
-        return Piece(Piece::Type::Pawn, Color::Black);
-    case black_knight:
-        return Piece(Piece::Type::Knight, Color::Black);
-    case black_bishop:
-        return Piece(Piece::Type::Bishop, Color::Black);
-    case black_rook:
-        return Piece(Piece::Type::Rook, Color::Black);
-    case black_queen:
-        return Piece(Piece::Type::Queen, Color::Black);
-    case black_king:
-        return Piece(Piece::Type::King, Color::Black);
-    default:
-        return {};
+    *out++ = separator;
+    const auto& castle_rights = snapshot.castle_rights;
+    if (castle_rights[Color::White].has_rights() || castle_rights[Color::Black].has_rights()) {
+        if (castle_rights[Color::White].can_castle_kingside)
+            *out++ = white_king;
+        if (castle_rights[Color::White].can_castle_queenside)
+            *out++ = white_queen;
+        if (castle_rights[Color::Black].can_castle_kingside)
+            *out++ = black_king;
+        if (castle_rights[Color::Black].can_castle_queenside)
+            *out++ = black_queen;
+    } else {
+        *out++ = none;
     }
-}
 
-std::optional<char> piece_to_fen(const Piece& piece)
-{
-    if (piece.is(Piece::Type::Pawn)) {
-        return piece.is(Color::White) ? white_pawn : black_pawn;
-    } else if (piece.is(Piece::Type::Knight)) {
-        return piece.is(Color::White) ? white_knight : black_knight;
-    } else if (piece.is(Piece::Type::Bishop)) {
-        return piece.is(Color::White) ? white_bishop : black_bishop;
-    } else if (piece.is(Piece::Type::Rook)) {
-        return piece.is(Color::White) ? white_rook : black_rook;
-    } else if (piece.is(Piece::Type::Queen)) {
-        return piece.is(Color::White) ? white_queen : black_queen;
-    } else if (piece.is(Piece::Type::King)) {
-        return piece.is(Color::White) ? white_king : black_king;
+    *out++ = separator;
+    if (snapshot.en_passant_target.has_value()) {
+        *out++ = static_cast<char>('a' + snapshot.en_passant_target->file());
+        *out++ = static_cast<char>('1' + snapshot.en_passant_target->rank());
     } else {
-        return {};
+        *out++ = none;
     }
+
+    *out++ = separator;
+    out = write_counter(out, snapshot.halfmove_clock);
+    *out++ = separator;
+    out = write_counter(out, snapshot.fullmove_number);
+
+    return { buffer.data(), static_cast<size_t>(out - buffer.data()) };
 }
+
+std::string to_fen(const GameSnapshot& snapshot)
+{
+    Buffer buffer;
+    return std::string(write_fen(snapshot, buffer));
+}
+
 }
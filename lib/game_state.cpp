@@ -1,7 +1,7 @@
 #include <sstream>
 
-#include "fen.h"
 #include "log.h"
+#include <weechess/fen.h>
 #include <weechess/game_state.h>
 #include <weechess/move_generator.h>
 
@@ -13,8 +13,8 @@ GameSnapshot::GameSnapshot(Board board,
     Color turn_to_move,
     ColorMap<CastleRights> castle_rights,
     std::optional<Location> en_passant_target,
-    size_t halfmove_clock,
-    size_t fullmove_number)
+    uint16_t halfmove_clock,
+    uint16_t fullmove_number)
     : board(std::move(board))
     , turn_to_move(turn_to_move)
     , castle_rights(castle_rights)
@@ -130,9 +130,8 @@ size_t GameState::fullmove_number() const { return m_snapshot.fullmove_number; }
 
 bool GameState::is_check() const
 {
-    auto king_mask = board().occupancy_for(Piece(Piece::Type::King, turn_to_move()));
-    auto attack_mask = board().attacks(invert_color(turn_to_move()));
-    return (king_mask & attack_mask).any();
+    auto king_location = board().occupancy_for(Piece(Piece::Type::King, turn_to_move())).lsb();
+    return king_location.has_value() && board().is_attacked(*king_location, invert_color(turn_to_move()));
 }
 
 bool GameState::is_checkmate() const { return move_set().legal_moves().empty() && is_check(); }
@@ -159,35 +158,57 @@ std::string GameState::san_notation(const Move& move) const
 
     std::stringstream ss;
 
-    if (piece.type == Piece::Type::Pawn && move.is_capture()) {
-        ss << static_cast<char>('a' + origin.file());
+    if (move.is_castle()) {
+        ss << (move.castle_side() == CastleSide::Kingside ? "O-O" : "O-O-O");
+    } else if (piece.type == Piece::Type::Pawn) {
+        if (move.is_capture()) {
+            ss << static_cast<char>('a' + origin.file()) << 'x';
+        }
+
+        ss << target.to_string();
+
+        if (move.is_promotion()) {
+            ss << '=' << static_cast<char>(std::toupper(Piece(move.promoted_piece_type(), piece.color).to_letter()));
+        }
     } else {
         ss << static_cast<char>(std::toupper(piece.to_letter()));
 
-        std::vector<Location> alternative_possible_sources;
+        // Only as much of the origin as it takes to tell the piece apart from others that could move there
+        bool is_ambiguous = false;
+        bool shares_file = false;
+        bool shares_rank = false;
         for (const auto& legal_move : move_set().legal_moves()) {
-            const auto& move = legal_move.move();
-            if (move.end_location() == target && move.start_location() != origin && move.moving_piece() == piece) {
-                alternative_possible_sources.push_back(move.start_location());
+            const auto& other = legal_move.move();
+            if (other.end_location() == target && other.start_location() != origin && other.moving_piece() == piece) {
+                is_ambiguous = true;
+                shares_file |= other.start_location().file() == origin.file();
+                shares_rank |= other.start_location().rank() == origin.rank();
             }
         }
 
-        if (alternative_possible_sources.size() == 1) {
-            if (alternative_possible_sources[0].file() != origin.file()) {
-                ss << static_cast<char>('a' + origin.file());
-            } else {
-                ss << (origin.rank() + 1);
-            }
-        } else if (alternative_possible_sources.size() > 1) {
-            ss << origin.to_string();
+        if (is_ambiguous && (!shares_file || shares_rank)) {
+            ss << static_cast<char>('a' + origin.file());
         }
-    }
 
-    if (move.is_capture()) {
-        ss << 'x';
+        if (is_ambiguous && shares_file) {
+            ss << (origin.rank() + 1);
+        }
+
+        if (move.is_capture()) {
+            ss << 'x';
+        }
+
+        ss << target.to_string();
     }
 
-    ss << target.to_string();
+    if (auto legal_move = move_set().find(move)) {
+        GameState next_state(legal_move->snapshot());
+        if (next_state.is_checkmate()) {
+            ss << '#';
+        } else if (next_state.is_check()) {
+            ss << '+';
+        }
+    }
 
     return ss.str();
 }
@@ -372,9 +393,15 @@ std::optional<Board> GameSnapshot::augmented_board_for_move(const GameSnapshot&
 
     auto buffer = snapshot.board.piece_buffer();
 
-    // Start and end positions of the piece
-    buffer.occupancy_for(moving_piece).unset(move.start_location());
-    buffer.occupancy_for(resulting_piece).set(move.end_location());
+    // Every square whose contents change, so attacks can be updated incrementally
+    BitBoard changed;
+    changed.set(move.start_location());
+    changed.set(move.end_location());
+
+    // The piece is lifted off its start position here, and only placed on its end position once any
+    // captured piece is cleared. The type and color bitboards are shared between pieces, so clearing
+    // a capture after placing the piece would clear some of the moving piece too.
+    buffer.remove_piece(moving_piece, move.start_location());
 
     if (move.is_en_passant()) {
         if (!snapshot.en_passant_target.has_value()) {
@@ -385,38 +412,41 @@ std::optional<Board> GameSnapshot::augmented_board_for_move(const GameSnapshot&
         auto captured_piece = Piece(Piece::Type::Pawn, other_color);
         if (other_color == Color::Black) {
             auto removed_location = snapshot.en_passant_target->offset_by(Location::RankShift { -1 }).value();
-            buffer.occupancy_for(captured_piece).unset(removed_location);
+            buffer.remove_piece(captured_piece, removed_location);
+            changed.set(removed_location);
         } else {
             auto removed_location = snapshot.en_passant_target->offset_by(Location::RankShift { 1 }).value();
-            buffer.occupancy_for(captured_piece).unset(removed_location);
+            buffer.remove_piece(captured_piece, removed_location);
+            changed.set(removed_location);
         }
     } else if (move.is_capture()) {
         auto captured_piece = Piece(move.captured_piece_type(), other_color);
-        buffer.occupancy_for(captured_piece).unset(move.end_location());
+        buffer.remove_piece(captured_piece, move.end_location());
     }
 
-    if (move.is_promotion()) {
-        buffer.occupancy_for(moving_piece).unset(move.end_location());
-        buffer.occupancy_for(resulting_piece).set(move.end_location());
-    }
+    buffer.set_piece(resulting_piece, move.end_location());
 
     if (move.is_castle()) {
         if (move.castle_side() == CastleSide::Kingside) {
             auto rook_start = Location::from_rank_and_file(move.start_location().rank(), 7);
             auto rook_end = Location::from_rank_and_file(move.start_location().rank(), 5);
             auto rook = Piece(Piece::Type::Rook, color);
-            buffer.occupancy_for(rook).unset(rook_start);
-            buffer.occupancy_for(rook).set(rook_end);
+            buffer.remove_piece(rook, rook_start);
+            buffer.set_piece(rook, rook_end);
+            changed.set(rook_start);
+            changed.set(rook_end);
         } else {
             auto rook_start = Location::from_rank_and_file(move.start_location().rank(), 0);
             auto rook_end = Location::from_rank_and_file(move.start_location().rank(), 3);
             auto rook = Piece(Piece::Type::Rook, color);
-            buffer.occupancy_for(rook).unset(rook_start);
-            buffer.occupancy_for(rook).set(rook_end);
+            buffer.remove_piece(rook, rook_start);
+            buffer.set_piece(rook, rook_end);
+            changed.set(rook_start);
+            changed.set(rook_end);
         }
     }
 
-    return Board(std::move(buffer));
+    return Board(std::move(buffer), snapshot.board, changed);
 }
 
 } // namespace weechess
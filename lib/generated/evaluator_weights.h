@@ -0,0 +1,102 @@
+#pragma once
+
+#include <weechess/evaluator.h>
+
+namespace weechess::generated {
+
+// clang-format off
+constexpr EvaluatorWeights evaluator_weights = {
+    .material = { 0, 100, 300, 300, 500, 900, 0 },
+    .piece_squares = { {
+        // None
+        {
+               0,   0,   0,   0,   0,   0,   0,   0,
+               0,   0,   0,   0,   0,   0,   0,   0,
+               0,   0,   0,   0,   0,   0,   0,   0,
+               0,   0,   0,   0,   0,   0,   0,   0,
+               0,   0,   0,   0,   0,   0,   0,   0,
+               0,   0,   0,   0,   0,   0,   0,   0,
+               0,   0,   0,   0,   0,   0,   0,   0,
+               0,   0,   0,   0,   0,   0,   0,   0,
+        },
+        // Pawn
+        {
+               0,   0,   0,   0,   0,   0,   0,   0,
+              50,  50,  50,  50,  50,  50,  50,  50,
+              10,  10,  20,  30,  30,  20,  10,  10,
+               5,   5,  10,  25,  25,  10,   5,   5,
+               0,   0,   0,  20,  20,   0,   0,   0,
+               5,  -5, -10,   0,   0, -10,  -5,   5,
+               5,  10,  10, -20, -20,  10,  10,   5,
+               0,   0,   0,   0,   0,   0,   0,   0,
+        },
+        // Knight
+        {
+             -50, -40, -30, -30, -30, -30, -40, -50,
+             -40, -20,   0,   0,   0,   0, -20, -40,
+             -30,   0,  10,  15,  15,  10,   0, -30,
+             -30,   5,  15,  20,  20,  15,   5, -30,
+             -30,   0,  15,  20,  20,  15,   0, -30,
+             -30,   5,  10,  15,  15,  10,   5, -30,
+             -40, -20,   0,   5,   5,   0, -20, -40,
+             -50, -40, -30, -30, -30, -30, -40, -50,
+        },
+        // Bishop
+        {
+             -20, -10, -10, -10, -10, -10, -10, -20,
+             -10,   0,   0,   0,   0,   0,   0, -10,
+             -10,   0,   5,  10,  10,   5,   0, -10,
+             -10,   5,   5,  10,  10,   5,   5, -10,
+             -10,   0,  10,  10,  10,  10,   0, -10,
+             -10,  10,  10,  10,  10,  10,  10, -10,
+             -10,   5,   0,   0,   0,   0,   5, -10,
+             -20, -10, -10, -10, -10, -10, -10, -20,
+        },
+        // Rook
+        {
+               0,   0,   0,   0,   0,   0,   0,   0,
+               5,  10,  10,  10,  10,  10,  10,   5,
+              -5,   0,   0,   0,   0,   0,   0,  -5,
+              -5,   0,   0,   0,   0,   0,   0,  -5,
+              -5,   0,   0,   0,   0,   0,   0,  -5,
+              -5,   0,   0,   0,   0,   0,   0,  -5,
+              -5,   0,   0,   0,   0,   0,   0,  -5,
+               0,   0,   0,   5,   5,   0,   0,   0,
+        },
+        // Queen
+        {
+             -20, -10, -10,  -5,  -5, -10, -10, -20,
+             -10,   0,   0,   0,   0,   0,   0, -10,
+             -10,   0,   5,   5,   5,   5,   0, -10,
+              -5,   0,   5,   5,   5,   5,   0,  -5,
+               0,   0,   5,   5,   5,   5,   0,  -5,
+             -10,   5,   5,   5,   5,   5,   0, -10,
+             -10,   0,   5,   0,   0,   0,   0, -10,
+             -20, -10, -10,  -5,  -5, -10, -10, -20,
+        },
+        // King (middle game)
+        {
+             -30, -40, -40, -50, -50, -40, -40, -30,
+             -30, -40, -40, -50, -50, -40, -40, -30,
+             -30, -40, -40, -50, -50, -40, -40, -30,
+             -30, -40, -40, -50, -50, -40, -40, -30,
+             -20, -30, -30, -40, -40, -30, -30, -20,
+             -10, -20, -20, -20, -20, -20, -20, -10,
+              20,  20,   0,   0,   0,   0,  20,  20,
+              20,  30,  10,   0,   0,  10,  30,  20,
+        },
+    } },
+    .king_end_game_squares = {
+         -50, -40, -30, -20, -20, -30, -40, -50,
+         -30, -20, -10,   0,   0, -10, -20, -30,
+         -30, -10,  20,  30,  30,  20, -10, -30,
+         -30, -10,  30,  40,  40,  30, -10, -30,
+         -30, -10,  30,  40,  40,  30, -10, -30,
+         -30, -10,  20,  30,  30,  20, -10, -30,
+         -30, -30,   0,   0,   0,   0, -30, -30,
+         -50, -30, -30, -30, -30, -30, -30, -50,
+    },
+};
+// clang-format on
+
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "../slider_attacks.h"
+
+namespace weechess::generated {
+
+extern const slider_attacks::SliderTable magic_slider_table;
+#ifdef WEECHESS_HAS_PEXT
+extern const slider_attacks::SliderTable pext_slider_table;
+#endif
+
+}
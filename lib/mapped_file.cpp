@@ -0,0 +1,79 @@
+#include <fstream>
+
+#include "mapped_file.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define WEECHESS_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace weechess {
+
+#ifdef WEECHESS_HAS_MMAP
+
+std::unique_ptr<MappedFile> MappedFile::open(const std::filesystem::path& path)
+{
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+
+    struct stat status;
+    if (::fstat(fd, &status) != 0) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    std::unique_ptr<MappedFile> file(new MappedFile());
+    file->m_size = static_cast<size_t>(status.st_size);
+
+    // Mapping an empty file fails, but there's nothing to map anyway
+    if (file->m_size > 0) {
+        auto* data = ::mmap(nullptr, file->m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            ::close(fd);
+            return nullptr;
+        }
+
+        file->m_data = static_cast<const std::byte*>(data);
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    return file;
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data != nullptr)
+        ::munmap(const_cast<std::byte*>(m_data), m_size);
+}
+
+#else
+
+std::unique_ptr<MappedFile> MappedFile::open(const std::filesystem::path& path)
+{
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream)
+        return nullptr;
+
+    std::unique_ptr<MappedFile> file(new MappedFile());
+    file->m_buffer.resize(static_cast<size_t>(stream.tellg()));
+    stream.seekg(0);
+    if (!stream.read(reinterpret_cast<char*>(file->m_buffer.data()), file->m_buffer.size()))
+        return nullptr;
+
+    file->m_data = file->m_buffer.data();
+    file->m_size = file->m_buffer.size();
+    return file;
+}
+
+MappedFile::~MappedFile() = default;
+
+#endif
+
+std::span<const std::byte> MappedFile::data() const { return { m_data, m_size }; }
+
+}
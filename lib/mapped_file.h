@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace weechess {
+
+// A read-only view of a whole file. Where the platform supports it the file is mapped into
+// memory, so nothing is read until it's touched and pages are shared between processes.
+// Elsewhere the file is read into memory up front.
+class MappedFile {
+public:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+    ~MappedFile();
+
+    static std::unique_ptr<MappedFile> open(const std::filesystem::path&);
+
+    std::span<const std::byte> data() const;
+
+private:
+    MappedFile() = default;
+
+    const std::byte* m_data { nullptr };
+    size_t m_size { 0 };
+    std::vector<std::byte> m_buffer {};
+};
+
+}
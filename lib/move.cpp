@@ -1,3 +1,4 @@
+#include <cstdlib>
 #include <functional>
 
 #include <weechess/game_state.h>
@@ -5,148 +6,75 @@
 
 namespace weechess {
 
-const Move Move::null {};
+std::string Move::san_notation(const GameState& gs) const { return gs.san_notation(*this); }
+std::string Move::to_string() const { return start_location().to_string() + end_location().to_string(); }
 
-Move::Data Move::data() const { return m_data; }
+std::size_t MoveHash::operator()(const Move& move) const { return std::hash<Move::Data> {}(move.m_data); }
 
-Piece Move::moving_piece() const
+CompactMove::Flag CompactMove::flag() const { return static_cast<Flag>((m_data >> flag_shift) & 0b11); }
+Piece::Type CompactMove::promoted_piece_type() const
 {
-    auto piece_type = static_cast<Piece::Type>(get_flags(Flags::PieceType));
-    return Piece(piece_type, color());
+    return static_cast<Piece::Type>(((m_data >> promotion_shift) & 0b11) + static_cast<int>(Piece::Type::Knight));
 }
 
-Piece Move::resulting_piece() const
+std::optional<Move> CompactMove::decode(const GameSnapshot& snapshot) const
 {
-    if (is_promotion()) {
-        auto piece_type = promoted_piece_type();
-        return Piece(piece_type, color());
-    } else {
-        auto piece_type = static_cast<Piece::Type>(get_flags(Flags::PieceType));
-        return Piece(piece_type, color());
+    auto origin = start_location();
+    auto destination = end_location();
+    if (origin == destination) {
+        return {};
     }
-}
 
-uint32_t Move::get_flags(Flags flags) const
-{
-    return (m_data.to_ulong() & masks[static_cast<uint32_t>(flags)]) >> shifts[static_cast<uint32_t>(flags)];
-}
-
-Color Move::color() const { return get_flags(Flags::Color) == 1 ? Color::White : Color::Black; }
-
-void Move::set_flags(Flags flags, uint32_t value)
-{
-    m_data &= ~masks[static_cast<uint32_t>(flags)];
-    m_data |= ((value << shifts[static_cast<uint32_t>(flags)]) & masks[static_cast<uint32_t>(flags)]);
-}
-
-void Move::set_color(Color color) { set_flags(Flags::Color, color == Color::White ? 1 : 0); }
-void Move::set_piece_type(Piece::Type type) { set_flags(Flags::PieceType, static_cast<uint32_t>(type)); }
-void Move::set_origin(Location location) { set_flags(Flags::Origin, location.offset); }
-void Move::set_destination(Location location) { set_flags(Flags::Destination, location.offset); }
-void Move::set_capture(Piece::Type type) { set_flags(Flags::Capture, static_cast<uint32_t>(type)); }
-void Move::set_double_pawn_push() { set_flags(Flags::DoublePawn, 1); }
-void Move::set_promotion(Piece::Type type)
-{
-    if (type == Piece::Type::None) {
-        set_flags(Flags::Promotion, 0b0000);
-    } else {
-        set_flags(Flags::Promotion, 0b1000 | static_cast<uint32_t>(type));
+    auto piece = snapshot.board.piece_at(origin);
+    if (!piece.exists() || piece.color != snapshot.turn_to_move) {
+        return {};
     }
-}
-
-Location Move::start_location() const { return Location(get_flags(Flags::Origin)); }
-Location Move::end_location() const { return Location(get_flags(Flags::Destination)); }
-
-bool Move::is_capture() const { return get_flags(Flags::Capture) != 0; }
-bool Move::is_en_passant() const { return get_flags(Flags::EnPassant) != 0; }
-bool Move::is_double_pawn() const { return get_flags(Flags::DoublePawn) != 0; }
-bool Move::is_promotion() const { return (get_flags(Flags::Promotion) & 0b1000) != 0; }
-bool Move::is_castle() const
-{
-    return (get_flags(Flags::KingsideCastle) != 0) || (get_flags(Flags::QueensideCastle) != 0);
-}
-
-Piece::Type Move::captured_piece_type() const { return static_cast<Piece::Type>(get_flags(Flags::Capture)); }
-Piece::Type Move::promoted_piece_type() const { return static_cast<Piece::Type>(0b0111 & get_flags(Flags::Promotion)); }
 
-std::optional<CastleSide> Move::castle_side() const
-{
-    if (get_flags(Flags::KingsideCastle) != 0) {
-        return CastleSide::Kingside;
-    } else if (get_flags(Flags::QueensideCastle) != 0) {
-        return CastleSide::Queenside;
-    } else {
+    auto target = snapshot.board.piece_at(destination);
+    if (target.exists() && target.color == piece.color) {
         return {};
     }
-}
-
-Move Move::by_moving(Piece piece, Location from, Location to)
-{
-    Move move;
-    move.set_piece_type(piece.type);
-    move.set_origin(from);
-    move.set_destination(to);
-    move.set_color(piece.color);
-    return move;
-}
 
-Move Move::by_capturing(Piece piece, Location from, Location to, Piece::Type captured)
-{
-    Move move = by_moving(piece, from, to);
-    move.set_capture(captured);
-    return move;
-}
-
-Move Move::by_promoting(Piece piece, Location from, Location to, Piece::Type promotion)
-{
-    Move move = by_moving(piece, from, to);
-    move.set_promotion(promotion);
-    return move;
-}
+    switch (flag()) {
+    case Flag::Castle:
+        if (!piece.is(Piece::Type::King)) {
+            return {};
+        }
 
-Move Move::by_en_passant(Piece piece, Location from, Location to)
-{
-    Move move = by_moving(piece, from, to);
-    move.set_flags(Flags::EnPassant, 1);
-    move.set_capture(Piece::Type::Pawn);
-    return move;
-}
+        return Move::by_castling(
+            piece, destination.file() > origin.file() ? CastleSide::Kingside : CastleSide::Queenside);
+    case Flag::EnPassant:
+        if (!piece.is(Piece::Type::Pawn)) {
+            return {};
+        }
 
-Move Move::by_castling(Piece piece, CastleSide side)
-{
-    Move move;
-    move.set_piece_type(piece.type);
-    move.set_color(piece.color);
-    if (side == CastleSide::Kingside) {
-        move.set_flags(Flags::KingsideCastle, 1);
-        if (piece.color == Color::White) {
-            move.set_origin(Location::E1);
-            move.set_destination(Location::G1);
-        } else {
-            move.set_origin(Location::E8);
-            move.set_destination(Location::G8);
+        return Move::by_en_passant(piece, origin, destination);
+    case Flag::Promotion: {
+        if (!piece.is(Piece::Type::Pawn)) {
+            return {};
         }
-    } else {
-        move.set_flags(Flags::QueensideCastle, 1);
-        if (piece.color == Color::White) {
-            move.set_origin(Location::E1);
-            move.set_destination(Location::C1);
-        } else {
-            move.set_origin(Location::E8);
-            move.set_destination(Location::C8);
+
+        auto move = Move::by_promoting(piece, origin, destination, promoted_piece_type());
+        if (target.exists()) {
+            move.set_capture(target.type);
         }
-    }
 
-    return move;
-}
+        return move;
+    }
+    case Flag::None:
+        break;
+    }
 
-std::string Move::san_notation(const GameState& gs) const { return gs.san_notation(*this); }
-std::string Move::to_string() const { return start_location().to_string() + end_location().to_string(); }
+    if (target.exists()) {
+        return Move::by_capturing(piece, origin, destination, target.type);
+    }
 
-std::size_t MoveHash::operator()(const Move& move) const { return std::hash<Move::Data> {}(move.m_data); }
+    auto move = Move::by_moving(piece, origin, destination);
+    if (piece.is(Piece::Type::Pawn) && std::abs(destination.rank() - origin.rank()) == 2) {
+        move.set_double_pawn_push();
+    }
 
-bool operator==(const Move& lhs, const Move& rhs) { return lhs.m_data == rhs.m_data; }
-bool operator!=(const Move& lhs, const Move& rhs) { return !(lhs == rhs); }
-bool operator<(const Move& lhs, const Move& rhs) { return lhs.m_data.to_ulong() < rhs.m_data.to_ulong(); }
+    return move;
+}
 
 } // namespace weechess
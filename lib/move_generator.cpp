@@ -24,28 +24,34 @@ namespace {
         Piece::Type::Knight,
     };
 
-    class Helper {
+    // Everything that depends on the side to move is resolved at compile time, so
+    // the generator is instantiated once per color and dispatched to once per call
+    template <Color C> class Helper {
     private:
+        static constexpr Color opponent = invert_color(C);
+
         const GameSnapshot& m_snapshot;
+        BitBoard m_threats;
 
     public:
         Helper(const GameSnapshot& snapshot)
             : m_snapshot(snapshot)
+            , m_threats(snapshot.board.attacks(opponent))
         {
         }
 
         const Board& board() const { return m_snapshot.board; }
 
-        Color color_to_move() const { return m_snapshot.turn_to_move; }
-        Piece piece_to_move(Piece::Type type) const { return Piece(type, m_snapshot.turn_to_move); }
+        constexpr Color color_to_move() const { return C; }
+        constexpr Piece piece_to_move(Piece::Type type) const { return Piece(type, C); }
 
         std::optional<Location> en_passant_target() const { return m_snapshot.en_passant_target; }
 
-        CastleRights castle_rights_to_move() const { return m_snapshot.castle_rights[color_to_move()]; }
+        CastleRights castle_rights_to_move() const { return m_snapshot.castle_rights[C]; }
 
         Location forward(Location location) const
         {
-            if (m_snapshot.turn_to_move == Color::White)
+            if constexpr (C == Color::White)
                 return location.offset_by(Location::Up).value();
             else
                 return location.offset_by(Location::Down).value();
@@ -53,47 +59,47 @@ namespace {
 
         Location backward(Location location) const
         {
-            if (m_snapshot.turn_to_move == Color::White)
+            if constexpr (C == Color::White)
                 return location.offset_by(Location::Down).value();
             else
                 return location.offset_by(Location::Up).value();
         }
 
-        Location file_shifted(Location location, int8_t sign) const
+        template <int8_t Sign> Location file_shifted(Location location) const
         {
-            if ((m_snapshot.turn_to_move == Color::White) == (sign > 0))
+            if constexpr ((C == Color::White) == (Sign > 0))
                 return location.offset_by(Location::Right).value();
             else
                 return location.offset_by(Location::Left).value();
         }
 
-        BitBoard file_shifted(BitBoard bb, int8_t sign) const
+        template <int8_t Sign> BitBoard file_shifted(BitBoard bb) const
         {
-            if ((m_snapshot.turn_to_move == Color::White) == (sign > 0))
+            if constexpr ((C == Color::White) == (Sign > 0))
                 return (bb & ~File('H').mask()) << 1;
             else
                 return (bb & ~File('A').mask()) >> 1;
         }
 
-        BitBoard backrank_mask() const
+        constexpr BitBoard backrank_mask() const
         {
-            if (m_snapshot.turn_to_move == Color::White)
+            if constexpr (C == Color::White)
                 return Rank(8).mask();
             else
                 return Rank(1).mask();
         }
 
-        BitBoard home_rank_mask(Rank rank) const
+        constexpr BitBoard home_rank_mask(Rank rank) const
         {
-            if (m_snapshot.turn_to_move == Color::White)
+            if constexpr (C == Color::White)
                 return rank.mask();
             else
                 return rank.inverted().mask();
         }
 
-        BitBoard edge_file_mask(int sign) const
+        template <int8_t Sign> constexpr BitBoard edge_file_mask() const
         {
-            if ((m_snapshot.turn_to_move == Color::White) == (sign > 0))
+            if constexpr ((C == Color::White) == (Sign > 0))
                 return File('H').mask();
             else
                 return File('A').mask();
@@ -101,28 +107,18 @@ namespace {
 
         BitBoard shift_forward(BitBoard bb) const
         {
-            if (m_snapshot.turn_to_move == Color::White)
+            if constexpr (C == Color::White)
                 return bb << 8;
             else
                 return bb >> 8;
         }
 
-        BitBoard occupancy_to_move(Piece::Type type) const
-        {
-            return m_snapshot.board.occupancy_for(Piece(type, m_snapshot.turn_to_move));
-        }
+        BitBoard occupancy_to_move(Piece::Type type) const { return m_snapshot.board.occupancy_for(Piece(type, C)); }
 
-        BitBoard attackable() const
-        {
-            auto other_color = invert_color(m_snapshot.turn_to_move);
-            return m_snapshot.board.color_occupancy()[other_color];
-        }
+        BitBoard own_pieces() const { return m_snapshot.board.color_occupancy()[C]; }
+        BitBoard attackable() const { return m_snapshot.board.color_occupancy()[opponent]; }
 
-        BitBoard threats() const
-        {
-            auto other_color = invert_color(m_snapshot.turn_to_move);
-            return m_snapshot.board.attacks(other_color);
-        }
+        BitBoard threats() const { return m_threats; }
 
         BitBoard en_passant_mask() const
         {
@@ -135,8 +131,9 @@ namespace {
         }
     };
 
+    template <Color C>
     void expand_moves(
-        const Helper& helper, std::vector<Move>& moves, Location origin, BitBoard targets, Piece::Type type)
+        const Helper<C>& helper, std::vector<Move>& moves, Location origin, BitBoard targets, Piece::Type type)
     {
         auto piece = helper.piece_to_move(type);
         auto attacks = helper.attackable() & targets;
@@ -154,9 +151,47 @@ namespace {
         }
     }
 
-    void generate_pawn_moves(const Helper& helper, std::vector<Move>& moves)
+    template <Color C, int8_t Sign> void generate_pawn_captures(const Helper<C>& helper, std::vector<Move>& moves)
     {
+        Piece piece = helper.piece_to_move(Piece::Type::Pawn);
+        BitBoard pawns = helper.occupancy_to_move(Piece::Type::Pawn);
+        BitBoard attacks = helper.template file_shifted<Sign>(helper.shift_forward(pawns)) & helper.attackable();
+        BitBoard attacks_with_promotion = attacks & helper.backrank_mask();
+        BitBoard en_passant_attacks
+            = helper.template file_shifted<Sign>(helper.shift_forward(pawns)) & helper.en_passant_mask();
 
+        attacks &= ~helper.backrank_mask();
+
+        // Regular captures
+        while (attacks.any()) {
+            auto target = attacks.pop_lsb().value();
+            auto origin = helper.backward(helper.template file_shifted<-Sign>(target));
+            auto move = Move::by_capturing(piece, origin, target, helper.board().piece_at(target).type);
+            moves.push_back(move);
+        }
+
+        // Promotion captures
+        while (attacks_with_promotion.any()) {
+            auto target = attacks_with_promotion.pop_lsb().value();
+            auto capture = helper.board().piece_at(target).type;
+            for (const auto& type : promotion_types) {
+                auto move = Move::by_promoting(
+                    piece, helper.backward(helper.template file_shifted<-Sign>(target)), target, type);
+                move.set_capture(capture);
+                moves.push_back(move);
+            }
+        }
+
+        // En passant captures
+        if (en_passant_attacks.any()) {
+            auto target = helper.en_passant_target().value();
+            moves.push_back(
+                Move::by_en_passant(piece, helper.backward(helper.template file_shifted<-Sign>(target)), target));
+        }
+    }
+
+    template <Color C> void generate_pawn_moves(const Helper<C>& helper, std::vector<Move>& moves)
+    {
         Piece piece = helper.piece_to_move(Piece::Type::Pawn);
 
         // Single step forward moves
@@ -198,48 +233,11 @@ namespace {
         }
 
         // Captures
-        {
-            BitBoard pawns = helper.occupancy_to_move(Piece::Type::Pawn);
-            constexpr std::array<int8_t, 2> signs = { -1, 1 };
-            for (const auto& sign : signs) {
-                BitBoard attacks = helper.file_shifted(helper.shift_forward(pawns), sign) & helper.attackable();
-                BitBoard attacks_with_promotion = attacks & helper.backrank_mask();
-                BitBoard en_passant_attacks
-                    = helper.file_shifted(helper.shift_forward(pawns), sign) & helper.en_passant_mask();
-
-                attacks &= ~helper.backrank_mask();
-
-                // Regular captures
-                while (attacks.any()) {
-                    auto target = attacks.pop_lsb().value();
-                    auto origin = helper.backward(helper.file_shifted(target, -sign));
-                    auto move = Move::by_capturing(piece, origin, target, helper.board().piece_at(target).type);
-                    moves.push_back(move);
-                }
-
-                // Promotion captures
-                while (attacks_with_promotion.any()) {
-                    auto target = attacks_with_promotion.pop_lsb().value();
-                    auto capture = helper.board().piece_at(target).type;
-                    for (const auto& type : promotion_types) {
-                        auto move = Move::by_promoting(
-                            piece, helper.backward(helper.file_shifted(target, -sign)), target, type);
-                        move.set_capture(capture);
-                        moves.push_back(move);
-                    }
-                }
-
-                // En passant captures
-                if (en_passant_attacks.any()) {
-                    auto target = helper.en_passant_target().value();
-                    moves.push_back(
-                        Move::by_en_passant(piece, helper.backward(helper.file_shifted(target, -sign)), target));
-                }
-            }
-        }
+        generate_pawn_captures<C, -1>(helper, moves);
+        generate_pawn_captures<C, 1>(helper, moves);
     }
 
-    void generate_knight_moves(const Helper& helper, std::vector<Move>& moves)
+    template <Color C> void generate_knight_moves(const Helper<C>& helper, std::vector<Move>& moves)
     {
         auto knights = helper.occupancy_to_move(Piece::Type::Knight);
         while (knights.any()) {
@@ -250,9 +248,8 @@ namespace {
         }
     }
 
-    void generate_king_moves(const Helper& helper, std::vector<Move>& moves)
+    template <Color C> void generate_king_moves(const Helper<C>& helper, std::vector<Move>& moves)
     {
-        auto color = helper.color_to_move();
         auto kings = helper.occupancy_to_move(Piece::Type::King);
         while (kings.any()) {
             auto origin = kings.pop_lsb().value();
@@ -262,27 +259,27 @@ namespace {
         }
 
         if (helper.castle_rights_to_move().can_castle_kingside) {
-            auto path_blocks = helper.board().shared_occupancy() & castling::kingside_path_mask[color];
-            auto path_checks = helper.threats() & castling::kingside_check_mask[color];
+            auto path_blocks = helper.board().shared_occupancy() & castling::kingside_path_mask[C];
+            auto path_checks = helper.threats() & castling::kingside_check_mask[C];
             if (path_blocks.none() && path_checks.none()) {
                 moves.push_back(Move::by_castling(helper.piece_to_move(Piece::Type::King), CastleSide::Kingside));
             }
         }
 
         if (helper.castle_rights_to_move().can_castle_queenside) {
-            auto path_blocks = helper.board().shared_occupancy() & castling::queenside_path_mask[color];
-            auto path_checks = helper.threats() & castling::queenside_check_mask[color];
+            auto path_blocks = helper.board().shared_occupancy() & castling::queenside_path_mask[C];
+            auto path_checks = helper.threats() & castling::queenside_check_mask[C];
             if (path_blocks.none() && path_checks.none()) {
                 moves.push_back(Move::by_castling(helper.piece_to_move(Piece::Type::King), CastleSide::Queenside));
             }
         }
     }
 
-    void generate_bishop_moves(const Helper& helper, std::vector<Move>& moves)
+    template <Color C> void generate_bishop_moves(const Helper<C>& helper, std::vector<Move>& moves)
     {
         auto occupancy = helper.board().shared_occupancy();
         auto bishops = helper.occupancy_to_move(Piece::Type::Bishop);
-        auto own_pieces = helper.board().color_occupancy()[helper.color_to_move()];
+        auto own_pieces = helper.own_pieces();
         while (bishops.any()) {
             auto origin = bishops.pop_lsb().value();
             auto attacks = attack_maps::generate_bishop_attacks(origin, occupancy);
@@ -291,11 +288,11 @@ namespace {
         }
     }
 
-    void generate_rook_moves(const Helper& helper, std::vector<Move>& moves)
+    template <Color C> void generate_rook_moves(const Helper<C>& helper, std::vector<Move>& moves)
     {
         auto occupancy = helper.board().shared_occupancy();
         auto rooks = helper.occupancy_to_move(Piece::Type::Rook);
-        auto own_pieces = helper.board().color_occupancy()[helper.color_to_move()];
+        auto own_pieces = helper.own_pieces();
         while (rooks.any()) {
             auto origin = rooks.pop_lsb().value();
             auto attacks = attack_maps::generate_rook_attacks(origin, occupancy);
@@ -304,11 +301,11 @@ namespace {
         }
     }
 
-    void generate_queen_moves(const Helper& helper, std::vector<Move>& moves)
+    template <Color C> void generate_queen_moves(const Helper<C>& helper, std::vector<Move>& moves)
     {
         auto occupancy = helper.board().shared_occupancy();
         auto queens = helper.occupancy_to_move(Piece::Type::Queen);
-        auto own_pieces = helper.board().color_occupancy()[helper.color_to_move()];
+        auto own_pieces = helper.own_pieces();
         while (queens.any()) {
             auto origin = queens.pop_lsb().value();
             auto attacks = attack_maps::generate_queen_attacks(origin, occupancy);
@@ -317,9 +314,9 @@ namespace {
         }
     }
 
-    void generate_psuedo_legal_moves(const GameSnapshot& snapshot, std::vector<Move>& moves)
+    template <Color C> void generate_psuedo_legal_moves(const GameSnapshot& snapshot, std::vector<Move>& moves)
     {
-        Helper helper(snapshot);
+        Helper<C> helper(snapshot);
         generate_pawn_moves(helper, moves);
         generate_knight_moves(helper, moves);
         generate_king_moves(helper, moves);
@@ -338,15 +335,18 @@ MoveGenerator::Result MoveGenerator::execute(const GameSnapshot& snapshot) const
     std::vector<Move> moves;
     moves.reserve(128);
 
-    generate_psuedo_legal_moves(snapshot, moves);
+    if (snapshot.turn_to_move == Color::White)
+        generate_psuedo_legal_moves<Color::White>(snapshot, moves);
+    else
+        generate_psuedo_legal_moves<Color::Black>(snapshot, moves);
 
     result.legal_moves.reserve(moves.size());
     for (const auto& move : moves) {
         auto new_snapshot = snapshot.by_performing_move(move);
-        auto king_position = new_snapshot->board.occupancy_for(Piece(Piece::Type::King, snapshot.turn_to_move));
-        auto attacked_positions = new_snapshot->board.attacks(new_snapshot->turn_to_move);
+        const auto& board = new_snapshot->board;
+        auto king_location = board.occupancy_for(Piece(Piece::Type::King, snapshot.turn_to_move)).lsb();
 
-        if ((king_position & attacked_positions).none()) {
+        if (!king_location.has_value() || !board.is_attacked(*king_location, new_snapshot->turn_to_move)) {
             result.legal_moves.emplace_back(move, std::move(*new_snapshot));
         }
     }
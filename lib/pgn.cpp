@@ -0,0 +1,225 @@
+#include <algorithm>
+
+#include <weechess/pgn.h>
+
+#include "mapped_file.h"
+
+namespace weechess::pgn {
+
+namespace {
+
+    constexpr std::string_view byte_order_mark = "\xEF\xBB\xBF";
+
+    constexpr bool is_whitespace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f'; }
+
+    // Characters that end a symbol without being part of it
+    constexpr bool is_delimiter(char c)
+    {
+        return is_whitespace(c) || c == '{' || c == '}' || c == '(' || c == ')' || c == '[' || c == ']' || c == ';'
+            || c == '$' || c == '"';
+    }
+
+    constexpr bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+    constexpr bool is_result(std::string_view symbol)
+    {
+        return symbol == "1-0" || symbol == "0-1" || symbol == "1/2-1/2" || symbol == "*";
+    }
+
+    // Strips the move number from symbols like "12.e4" or "12...e5", and suffix annotations like "!?"
+    constexpr std::string_view move_from_symbol(std::string_view symbol)
+    {
+        auto start = symbol.find_first_not_of("0123456789");
+        if (start == std::string_view::npos)
+            return {};
+
+        if (start > 0 && symbol[start] != '.')
+            return symbol;
+
+        symbol.remove_prefix(std::min(symbol.size(), symbol.find_first_not_of('.', start)));
+
+        auto end = symbol.find_last_not_of("!?");
+        return end == std::string_view::npos ? std::string_view() : symbol.substr(0, end + 1);
+    }
+
+}
+
+std::optional<std::string_view> Game::tag(std::string_view name) const
+{
+    auto it = std::find_if(tags.begin(), tags.end(), [&](const auto& tag) { return tag.first == name; });
+    if (it == tags.end())
+        return {};
+
+    return it->second;
+}
+
+Reader::Reader(std::string_view text)
+    : m_text(text)
+{
+    if (m_text.starts_with(byte_order_mark))
+        m_position = byte_order_mark.size();
+}
+
+bool Reader::at_end() const { return m_position >= m_text.size(); }
+
+char Reader::peek() const { return m_text[m_position]; }
+
+void Reader::skip_line()
+{
+    auto end = m_text.find('\n', m_position);
+    m_position = end == std::string_view::npos ? m_text.size() : end + 1;
+}
+
+void Reader::skip_comment()
+{
+    // Brace comments don't nest, and run until the first closing brace
+    auto end = m_text.find('}', m_position);
+    m_position = end == std::string_view::npos ? m_text.size() : end + 1;
+}
+
+void Reader::skip_variation()
+{
+    size_t depth = 0;
+    while (!at_end()) {
+        switch (peek()) {
+        case '(':
+            depth++;
+            m_position++;
+            break;
+        case ')':
+            m_position++;
+            if (--depth == 0)
+                return;
+            break;
+        case '{':
+            skip_comment();
+            break;
+        case ';':
+            skip_line();
+            break;
+        default:
+            m_position++;
+            break;
+        }
+    }
+}
+
+std::string_view Reader::read_symbol()
+{
+    auto start = m_position;
+    while (!at_end() && !is_delimiter(peek()))
+        m_position++;
+
+    return m_text.substr(start, m_position - start);
+}
+
+void Reader::read_tag(Game& game)
+{
+    // Skip the opening bracket
+    m_position++;
+
+    while (!at_end() && is_whitespace(peek()))
+        m_position++;
+
+    auto name = read_symbol();
+
+    auto value_start = m_text.find('"', m_position);
+    auto line_end = std::min(m_text.find('\n', m_position), m_text.size());
+    if (value_start >= line_end) {
+        // Not a well formed tag, so there's nothing worth keeping on the rest of the line
+        m_position = line_end;
+        return;
+    }
+
+    auto value_end = value_start + 1;
+    while (value_end < m_text.size() && m_text[value_end] != '"') {
+        if (m_text[value_end] == '\\')
+            value_end++;
+        value_end++;
+    }
+
+    value_end = std::min(value_end, m_text.size());
+    game.tags.emplace_back(name, m_text.substr(value_start + 1, value_end - value_start - 1));
+
+    auto close = m_text.find(']', value_end);
+    m_position = close == std::string_view::npos ? m_text.size() : close + 1;
+}
+
+std::optional<Game> Reader::next()
+{
+    Game game;
+    bool started = false;
+    while (!at_end()) {
+        auto c = peek();
+
+        // Lines starting with a percent sign are escaped from the format entirely
+        if (c == '%' && (m_position == 0 || m_text[m_position - 1] == '\n')) {
+            skip_line();
+        } else if (is_whitespace(c) || c == ')' || c == '}' || c == ']' || c == '"') {
+            m_position++;
+        } else if (c == ';') {
+            skip_line();
+        } else if (c == '{') {
+            skip_comment();
+        } else if (c == '(') {
+            skip_variation();
+        } else if (c == '$') {
+            m_position++;
+            while (!at_end() && is_digit(peek()))
+                m_position++;
+        } else if (c == '[') {
+            // Tags after movetext belong to the next game, which happens when a game is missing its result
+            if (!game.moves.empty())
+                return game;
+
+            read_tag(game);
+            started = true;
+        } else {
+            auto symbol = read_symbol();
+
+            // Archives sometimes have headings and the like between games. Until a game has started with a
+            // tag or a move number, anything else is taken as part of them
+            if (!started && !is_digit(symbol.front()) && symbol != "*") {
+                skip_line();
+                continue;
+            }
+
+            started = true;
+
+            if (is_result(symbol)) {
+                game.result = symbol;
+                return game;
+            }
+
+            if (auto move = move_from_symbol(symbol); !move.empty())
+                game.moves.push_back(move);
+        }
+    }
+
+    if (game.tags.empty() && game.moves.empty())
+        return {};
+
+    return game;
+}
+
+Archive::Archive(std::shared_ptr<const MappedFile> file)
+    : m_file(std::move(file))
+{
+}
+
+std::optional<Archive> Archive::open(const std::filesystem::path& path)
+{
+    std::shared_ptr<const MappedFile> file = MappedFile::open(path);
+    if (!file)
+        return {};
+
+    return Archive(std::move(file));
+}
+
+std::string_view Archive::text() const
+{
+    auto data = m_file->data();
+    return { reinterpret_cast<const char*>(data.data()), data.size() };
+}
+
+}
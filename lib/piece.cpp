@@ -40,30 +40,6 @@ char Piece::to_letter() const
     }
 }
 
-Color invert_color(Color color)
-{
-    if (color == Color::White) {
-        return Color::Black;
-    } else {
-        return Color::White;
-    }
-}
-
-const std::array<Piece, 12> Piece::all_valid_pieces = {
-    Piece(Piece::Type::Pawn, Color::White),
-    Piece(Piece::Type::Knight, Color::White),
-    Piece(Piece::Type::Bishop, Color::White),
-    Piece(Piece::Type::Rook, Color::White),
-    Piece(Piece::Type::Queen, Color::White),
-    Piece(Piece::Type::King, Color::White),
-    Piece(Piece::Type::Pawn, Color::Black),
-    Piece(Piece::Type::Knight, Color::Black),
-    Piece(Piece::Type::Bishop, Color::Black),
-    Piece(Piece::Type::Rook, Color::Black),
-    Piece(Piece::Type::Queen, Color::Black),
-    Piece(Piece::Type::King, Color::Black),
-};
-
 std::ostream& operator<<(std::ostream& os, const Piece& piece)
 {
     os << piece.to_letter();
@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+
+#include <weechess/polyglot_book.h>
+
+#include "generated/polyglot_keys.h"
+#include "mapped_file.h"
+
+namespace weechess {
+
+namespace {
+
+    constexpr size_t entry_size = 16;
+
+    constexpr size_t castle_keys_offset = 768;
+    constexpr size_t en_passant_keys_offset = 772;
+    constexpr size_t turn_key_offset = 780;
+
+    // Polyglot orders pieces black then white for each type, from pawn up to king
+    size_t piece_key_index(Piece piece, Location location)
+    {
+        auto type_index = static_cast<size_t>(piece.type) - static_cast<size_t>(Piece::Type::Pawn);
+        auto kind = type_index * 2 + (piece.color == Color::White ? 1 : 0);
+        return kind * 64 + location.offset;
+    }
+
+    // The en passant file only counts when a pawn of the side to move is actually next to
+    // the pawn that just moved, ready to capture it
+    bool has_en_passant_capture(const GameSnapshot& snapshot)
+    {
+        if (!snapshot.en_passant_target.has_value())
+            return false;
+
+        auto target = *snapshot.en_passant_target;
+        auto pawn_rank = snapshot.turn_to_move == Color::White ? 4 : 3;
+        auto pawns = snapshot.board.occupancy_for(Piece(Piece::Type::Pawn, snapshot.turn_to_move));
+
+        for (int file : { target.file() - 1, target.file() + 1 }) {
+            if (file >= 0 && file < 8 && pawns[Location::from_rank_and_file(pawn_rank, static_cast<uint8_t>(file))])
+                return true;
+        }
+
+        return false;
+    }
+
+    uint64_t read_big_endian(const std::byte* bytes, size_t size)
+    {
+        uint64_t value = 0;
+        for (size_t i = 0; i < size; i++)
+            value = (value << 8) | static_cast<uint64_t>(bytes[i]);
+
+        return value;
+    }
+
+    void write_big_endian(std::ostream& os, uint64_t value, size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+            os.put(static_cast<char>((value >> (8 * (size - i - 1))) & 0xff));
+    }
+
+    constexpr std::array<Piece::Type, 5> promotion_types = {
+        Piece::Type::None,
+        Piece::Type::Knight,
+        Piece::Type::Bishop,
+        Piece::Type::Rook,
+        Piece::Type::Queen,
+    };
+
+}
+
+namespace polyglot {
+
+    Hasher::Hasher()
+        : m_keys(generated::polyglot_keys)
+    {
+    }
+
+    Hasher::Hasher(const Keys& keys)
+        : m_keys(keys)
+    {
+    }
+
+    std::optional<Hasher> Hasher::load(const std::filesystem::path& path)
+    {
+        std::ifstream stream(path);
+        if (!stream)
+            return {};
+
+        Keys keys {};
+        size_t count = 0;
+        std::string token;
+        while (stream >> token) {
+            std::replace(token.begin(), token.end(), ',', ' ');
+            std::istringstream tokens(token);
+            for (std::string value; tokens >> value;) {
+                if (count == key_count)
+                    return {};
+
+                size_t parsed = 0;
+                try {
+                    keys[count++] = std::stoull(value, &parsed, 16);
+                } catch (const std::logic_error&) {
+                    return {};
+                }
+
+                // Allows for C style suffixes, as in 0x9D39247E33776D41ULL
+                auto suffix = value.substr(parsed);
+                if (!suffix.empty() && suffix != "ULL" && suffix != "ull" && suffix != "U" && suffix != "u")
+                    return {};
+            }
+        }
+
+        if (count != key_count)
+            return {};
+
+        return Hasher(keys);
+    }
+
+    Hash Hasher::hash(const GameSnapshot& snapshot) const
+    {
+        Hash hash = 0;
+        for (auto piece : Piece::all_valid_pieces) {
+            auto occupancy = snapshot.board.occupancy_for(piece);
+            while (occupancy.any()) {
+                auto location = occupancy.pop_lsb();
+                hash ^= m_keys[piece_key_index(piece, *location)];
+            }
+        }
+
+        const auto& castle_rights = snapshot.castle_rights;
+        if (castle_rights[Color::White].can_castle_kingside)
+            hash ^= m_keys[castle_keys_offset + 0];
+        if (castle_rights[Color::White].can_castle_queenside)
+            hash ^= m_keys[castle_keys_offset + 1];
+        if (castle_rights[Color::Black].can_castle_kingside)
+            hash ^= m_keys[castle_keys_offset + 2];
+        if (castle_rights[Color::Black].can_castle_queenside)
+            hash ^= m_keys[castle_keys_offset + 3];
+
+        if (has_en_passant_capture(snapshot))
+            hash ^= m_keys[en_passant_keys_offset + snapshot.en_passant_target->file()];
+
+        if (snapshot.turn_to_move == Color::White)
+            hash ^= m_keys[turn_key_offset];
+
+        return hash;
+    }
+
+    uint16_t encode_move(const Move& move)
+    {
+        auto origin = move.start_location();
+        auto destination = move.end_location();
+
+        // The king's destination is replaced by the square of the rook it castles with
+        if (move.is_castle())
+            destination = Location::from_rank_and_file(destination.rank(), destination.file() == 6 ? 7 : 0);
+
+        uint16_t promotion = 0;
+        if (move.is_promotion()) {
+            auto it = std::find(promotion_types.begin(), promotion_types.end(), move.promoted_piece_type());
+            promotion = static_cast<uint16_t>(it - promotion_types.begin());
+        }
+
+        return static_cast<uint16_t>(destination.file() | (destination.rank() << 3) | (origin.file() << 6)
+            | (origin.rank() << 9) | (promotion << 12));
+    }
+
+    std::optional<Move> decode_move(uint16_t data, const GameSnapshot& snapshot)
+    {
+        auto destination = Location::from_rank_and_file((data >> 3) & 7, data & 7);
+        auto origin = Location::from_rank_and_file((data >> 9) & 7, (data >> 6) & 7);
+        size_t promotion_index = (data >> 12) & 7;
+        if (promotion_index >= promotion_types.size())
+            return {};
+
+        auto promotion = promotion_types[promotion_index];
+
+        GameState state(snapshot);
+        for (const auto& legal_move : state.move_set().legal_moves()) {
+            const auto& move = legal_move.move();
+            if (move.start_location() != origin)
+                continue;
+
+            auto move_destination = move.end_location();
+            if (move.is_castle()) {
+                auto rook_file = move_destination.file() == 6 ? 7 : 0;
+                move_destination = Location::from_rank_and_file(move_destination.rank(), rook_file);
+            }
+
+            auto move_promotion = move.is_promotion() ? move.promoted_piece_type() : Piece::Type::None;
+            if (move_destination == destination && move_promotion == promotion)
+                return move;
+        }
+
+        return {};
+    }
+
+    bool write_book(const std::filesystem::path& path, std::vector<Entry> entries)
+    {
+        std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) {
+            return lhs.key != rhs.key ? lhs.key < rhs.key : lhs.weight > rhs.weight;
+        });
+
+        std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+        if (!stream)
+            return false;
+
+        for (const auto& entry : entries) {
+            write_big_endian(stream, entry.key, 8);
+            write_big_endian(stream, entry.move, 2);
+            write_big_endian(stream, entry.weight, 2);
+            write_big_endian(stream, entry.learn, 4);
+        }
+
+        return stream.good();
+    }
+
+}
+
+PolyglotBook::PolyglotBook(std::shared_ptr<const MappedFile> file, const polyglot::Hasher& hasher)
+    : m_file(std::move(file))
+    , m_hasher(std::make_shared<const polyglot::Hasher>(hasher))
+{
+}
+
+std::optional<PolyglotBook> PolyglotBook::open(const std::filesystem::path& path, const polyglot::Hasher& hasher)
+{
+    std::shared_ptr<const MappedFile> file = MappedFile::open(path);
+    if (!file || file->data().size() % entry_size != 0)
+        return {};
+
+    return PolyglotBook(std::move(file), hasher);
+}
+
+size_t PolyglotBook::size() const { return m_file->data().size() / entry_size; }
+
+polyglot::Entry PolyglotBook::entry_at(size_t index) const
+{
+    const auto* bytes = m_file->data().data() + index * entry_size;
+    return polyglot::Entry {
+        .key = read_big_endian(bytes, 8),
+        .move = static_cast<uint16_t>(read_big_endian(bytes + 8, 2)),
+        .weight = static_cast<uint16_t>(read_big_endian(bytes + 10, 2)),
+        .learn = static_cast<uint32_t>(read_big_endian(bytes + 12, 4)),
+    };
+}
+
+std::vector<PolyglotBook::WeightedMove> PolyglotBook::lookup(const GameSnapshot& snapshot) const
+{
+    auto key = m_hasher->hash(snapshot);
+
+    // Lower bound on the key, reading only the keys of the entries that are probed
+    size_t first = 0;
+    size_t count = size();
+    while (count > 0) {
+        auto step = count / 2;
+        if (read_big_endian(m_file->data().data() + (first + step) * entry_size, 8) < key) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+
+    std::vector<WeightedMove> moves;
+    for (auto i = first; i < size(); i++) {
+        auto entry = entry_at(i);
+        if (entry.key != key)
+            break;
+
+        if (auto move = polyglot::decode_move(entry.move, snapshot))
+            moves.push_back({ *move, entry.weight });
+    }
+
+    return moves;
+}
+
+std::optional<Move> PolyglotBook::select(const GameSnapshot& snapshot, std::default_random_engine& random_engine) const
+{
+    auto moves = lookup(snapshot);
+    if (moves.empty())
+        return {};
+
+    auto total_weight = std::accumulate(
+        moves.begin(), moves.end(), uint64_t(0), [](uint64_t sum, const auto& move) { return sum + move.weight; });
+
+    // Books sometimes keep moves with no weight around. If that's all there is, they're all as good as each other
+    if (total_weight == 0)
+        return moves[std::uniform_int_distribution<size_t>(0, moves.size() - 1)(random_engine)].move;
+
+    auto choice = std::uniform_int_distribution<uint64_t>(0, total_weight - 1)(random_engine);
+    for (const auto& move : moves) {
+        if (choice < move.weight)
+            return move.move;
+
+        choice -= move.weight;
+    }
+
+    return moves.back().move;
+}
+
+}
@@ -3,6 +3,7 @@
 #include <optional>
 #include <vector>
 
+#include <weechess/analysis_cache.h>
 #include <weechess/evaluator.h>
 #include <weechess/move_sorter.h>
 #include <weechess/searcher.h>
@@ -14,114 +15,358 @@ namespace weechess {
 
 using Checkpointer = std::function<void(const SearchProgress&, SearchControl&)>;
 
-class SearchAbortedException : public std::exception { };
+// How many nodes are searched between checks of the stop token. Small enough that a search
+// stops within a millisecond or so, large enough that the check doesn't show up in profiles
+constexpr size_t stop_poll_interval = 2048;
+
+// Allowance for positional gains when deciding whether a capture could possibly raise alpha
+constexpr int delta_pruning_margin = Evaluation::pawns(2);
+
+// Extensions stop once a line is this many times longer than the depth being searched
+constexpr size_t max_extended_ply_factor = 2;
+
+// How far below the TT score, per ply of remaining depth, every other move must fall for the TT move to be singular
+constexpr int singular_extension_margin = 25;
+constexpr int singular_extension_min_depth = 4;
+constexpr int internal_iterative_reduction_min_depth = 4;
+
+// The analysis cache is only read and written this close to the root, where positions recur from one
+// analysis to the next and a deep result saves the most work
+constexpr size_t analysis_cache_max_ply = 4;
 
 class SearchInstance {
 private:
     size_t m_nodes_searched { 0 };
-    size_t m_next_control_event { 0 };
-    TranspositionTable m_transposition_table {};
+    size_t m_quiescence_nodes_searched { 0 };
+    size_t m_nodes_until_poll { stop_poll_interval };
+    size_t m_root_depth { 0 };
+    bool m_aborted { false };
 
-    const Checkpointer& m_checkpointer;
+    TranspositionTable& m_transposition_table;
     const GameState& m_root_game_state;
+    AnalysisCache* const m_analysis_cache;
+    const SearchFeatures m_features;
+    const threading::Token& m_stop;
+    const std::optional<size_t> m_max_nodes;
+    std::atomic<size_t>& m_published_nodes;
+    std::atomic<size_t>& m_published_quiescence_nodes;
 
-    void submit_progress(size_t depth, bool has_new_results)
+    size_t total_nodes_searched() const { return m_nodes_searched + m_quiescence_nodes_searched; }
+
+    void publish_nodes_searched()
     {
-        SearchProgress progress(this, has_new_results, depth);
-        SearchControl control;
-        m_checkpointer(progress, control);
+        m_published_nodes.store(total_nodes_searched(), std::memory_order_relaxed);
+        m_published_quiescence_nodes.store(m_quiescence_nodes_searched, std::memory_order_relaxed);
+    }
 
-        if (control.stop)
-            throw SearchAbortedException();
+    /*
+    Called once for every node. Every so often this checks whether the search has been asked
+    to stop, and once it has, every caller unwinds by returning straight away. Nothing found
+    after that point is stored, since it's the result of a search that didn't finish.
+
+    The first iteration is always allowed to finish, so that there's a move to play no matter
+    how soon the search is stopped.
+    */
+    inline bool should_abort()
+    {
+        if (m_aborted || --m_nodes_until_poll > 0)
+            return m_aborted;
+
+        m_nodes_until_poll = stop_poll_interval;
+        publish_nodes_searched();
+        if (m_root_depth <= 1)
+            return false;
+
+        m_aborted = m_stop.invalidated() || (m_max_nodes.has_value() && total_nodes_searched() >= *m_max_nodes);
+        return m_aborted;
+    }
+
+    // Results near the root are also kept in the analysis cache, for later searches to pick up
+    inline void store(const GameSnapshot& snapshot,
+        TranspositionEntry::Type type,
+        const Move& move,
+        int depth,
+        Evaluation evaluation,
+        size_t ply)
+    {
+        m_transposition_table.insert(snapshot, type, move, depth, evaluation, ply);
+        if (m_analysis_cache != nullptr && ply <= analysis_cache_max_ply)
+            m_analysis_cache->insert(snapshot, type, move, depth, evaluation, ply);
+    }
+
+    // Whichever of the transposition table and the analysis cache searched the position deeper. This only
+    // steers the search, see find_in_line for reading the result back
+    inline std::optional<TranspositionEntry> find(const GameSnapshot& snapshot, size_t ply) const
+    {
+        auto entry = m_transposition_table.find(snapshot, ply);
+        if (m_analysis_cache != nullptr && ply <= analysis_cache_max_ply) {
+            auto cached = m_analysis_cache->find(snapshot, ply);
+            if (cached.has_value() && (!entry.has_value() || cached->depth > entry->depth))
+                entry = cached;
+        }
+
+        return entry;
+    }
+
+    /*
+    The entry to follow when reading back the best line. That's this search's own, since a deeper
+    cached bound may only have an arbitrary move to go with it (for example, when no move raised alpha).
+    Cutoffs on exact cached scores leave nothing behind in the transposition table, so those fill the gaps
+    */
+    inline std::optional<TranspositionEntry> find_in_line(const GameSnapshot& snapshot, size_t ply) const
+    {
+        auto entry = m_transposition_table.find(snapshot, ply);
+        if (entry.has_value() || ply == 0 || m_analysis_cache == nullptr || ply > analysis_cache_max_ply)
+            return entry;
+
+        auto cached = m_analysis_cache->find(snapshot, ply);
+        if (cached.has_value() && cached->type == TranspositionEntry::Type::Exact)
+            return cached;
+
+        return {};
+    }
 
-        m_next_control_event = control.next_control_event;
+    // The entry's move, if it's legal here. Compact moves only get a light check when they're decoded,
+    // so one from a position with a colliding key can still turn out to be illegal (leaving the king in check)
+    static std::optional<LegalMove> legal_move_of(const TranspositionEntry& entry, const GameState& game_state)
+    {
+        auto move = entry.move.decode(game_state.snapshot());
+        if (!move.has_value())
+            return {};
+
+        return game_state.move_set().find(*move);
+    }
+
+    /*
+    Scores a position with no legal moves. Checkmates are scored by how far from the root
+    they are, so that the search prefers the quickest mate (or the slowest loss)
+    */
+    inline Evaluation terminal_evaluation(const GameState& game_state, size_t ply) const
+    {
+        if (game_state.is_check())
+            return Evaluation::mated_in(ply);
+
+        return Evaluation::zero();
     }
 
     /*
     Performs a recursive search by only looking at captures. Once the position is 'quiet'
-    then we evaluate it and return the evaluation.
+    then we evaluate it and return the evaluation. When in check, standing pat isn't an
+    option, so every evasion is searched instead.
     */
-    inline Evaluation quiescence_search(const GameState& game_state, Evaluation alpha, Evaluation beta)
+    inline Evaluation quiescence_search(const GameState& game_state, size_t ply, Evaluation alpha, Evaluation beta)
     {
-        auto legal_moves = game_state.move_set().legal_moves();
+        // Quiescence results are stored with no remaining depth, so any entry for this position will do
+        auto entry = m_transposition_table.find(game_state.snapshot(), ply);
+        if (entry.has_value()) {
+            switch (entry->type) {
+            case TranspositionEntry::Type::Exact:
+                return entry->evaluation();
+            case TranspositionEntry::Type::LowerBound:
+                if (entry->evaluation() >= beta)
+                    return beta;
+                break;
+            case TranspositionEntry::Type::UpperBound:
+                if (entry->evaluation() <= alpha)
+                    return alpha;
+                break;
+            }
+        }
 
-        if (legal_moves.empty()) {
+        const auto& all_legal_moves = game_state.move_set().legal_moves();
+        if (all_legal_moves.empty()) {
             // Don't bother searching further, the game is either in a
             // checkmate or stalemate
-            return Evaluator::default_instance.evaluate(game_state);
+            return terminal_evaluation(game_state, ply);
         }
 
-        auto is_quiet = std::all_of(legal_moves.begin(), legal_moves.end(), [](const auto& legal_move) {
-            return !legal_move.move().is_capture();
-        });
+        // An entry searched by the main search is worth more than anything found here, so leave it be
+        auto store = [&](TranspositionEntry::Type type, const Move& move, Evaluation evaluation) {
+            if (!entry.has_value() || entry->depth == 0)
+                m_transposition_table.insert(game_state.snapshot(), type, move, 0, evaluation, ply);
+        };
+
+        auto original_alpha = alpha;
+        auto is_check = game_state.is_check();
+        auto stand_pat = Evaluation::negative_inf();
+        if (!is_check) {
+            stand_pat = Evaluator::default_instance.evaluate(game_state.snapshot());
+            if (stand_pat >= beta)
+                return beta;
+            if (alpha < stand_pat)
+                alpha = stand_pat;
+        }
+
+        std::vector<LegalMove> legal_moves;
+        legal_moves.reserve(all_legal_moves.size());
+        for (const auto& legal_move : all_legal_moves) {
+            if (is_check || legal_move.move().is_capture())
+                legal_moves.push_back(legal_move);
+        }
 
-        auto normal_eval = Evaluator::default_instance.evaluate(game_state);
-        if (is_quiet)
-            return normal_eval;
-        if (normal_eval >= beta)
-            return beta;
-        if (alpha < normal_eval)
-            alpha = normal_eval;
+        std::sort(legal_moves.begin(), legal_moves.end(), MoveSorter::default_instance);
 
+        std::optional<Move> best_move {};
         for (const auto& legal_move : legal_moves) {
-            if (!legal_move.move().is_capture())
-                continue;
+            const auto& move = legal_move.move();
+
+            // Delta pruning. If winning the captured piece (with some margin for positional
+            // gains) still can't bring the evaluation up to alpha, the capture isn't worth a look
+            if (!is_check) {
+                auto gain = Evaluation::piece_worth(move.captured_piece_type()) + delta_pruning_margin;
+                if (move.is_promotion())
+                    gain += Evaluation::piece_worth(move.promoted_piece_type()) - Evaluation::pawns(1);
+
+                if (stand_pat + Evaluation { gain } <= alpha)
+                    continue;
+            }
+
+            m_quiescence_nodes_searched++;
+            if (should_abort())
+                return Evaluation::zero();
 
             auto new_game_state = GameState(legal_move.snapshot());
-            auto evaluation = -quiescence_search(new_game_state, -beta, -alpha);
+            auto evaluation = -quiescence_search(new_game_state, ply + 1, -beta, -alpha);
+            if (m_aborted)
+                return Evaluation::zero();
 
-            if (evaluation >= beta)
+            if (evaluation >= beta) {
+                store(TranspositionEntry::Type::LowerBound, move, beta);
                 return beta;
+            }
 
-            if (evaluation > alpha)
+            if (evaluation > alpha) {
                 alpha = evaluation;
+                best_move = move;
+            }
         }
 
+        store(alpha > original_alpha ? TranspositionEntry::Type::Exact : TranspositionEntry::Type::UpperBound,
+            best_move.value_or(all_legal_moves.front().move()),
+            alpha);
+
         return alpha;
     }
 
-    inline Evaluation search(
-        const GameState& game_state, size_t depth, size_t max_depth, Evaluation alpha, Evaluation beta)
+    /*
+    How much deeper (or shallower) than usual to search a move. Checks get another ply so that
+    they're resolved before the horizon instead of handed to the quiescence search, and so does
+    a TT move that's singular, meaning every alternative is clearly worse than it.
+    */
+    inline int depth_adjustment(const GameState& new_game_state, size_t ply, bool is_singular) const
+    {
+        // Keep a line of checks from extending the search forever
+        if (ply >= max_extended_ply_factor * m_root_depth)
+            return 0;
+
+        if (m_features.check_extensions && new_game_state.is_check())
+            return 1;
+
+        if (is_singular)
+            return 1;
+
+        return 0;
+    }
+
+    /*
+    A TT move is singular if searching every other move, at a reduced depth and against a
+    window a margin below the TT score, fails low
+    */
+    inline bool is_singular(const GameState& game_state,
+        size_t ply,
+        int depth,
+        const std::optional<TranspositionEntry>& entry,
+        const std::optional<Move>& tt_move)
+    {
+        if (!m_features.singular_extensions || !tt_move.has_value() || depth < singular_extension_min_depth)
+            return false;
+
+        if (entry->type == TranspositionEntry::Type::UpperBound || entry->evaluation().is_mate()
+            || static_cast<int>(entry->depth) < depth - 3)
+            return false;
+
+        auto singular_beta = entry->evaluation() - Evaluation { singular_extension_margin * depth };
+        auto evaluation
+            = search(game_state, ply, (depth - 1) / 2, singular_beta - Evaluation { 1 }, singular_beta, tt_move);
+        return evaluation < singular_beta;
+    }
+
+    /*
+    Searches the position to the given remaining depth. When there's an excluded move, the
+    position is searched as if that move didn't exist, and nothing is read from or written to
+    the transposition table, since the result doesn't describe the real position.
+    */
+    inline Evaluation search(const GameState& game_state,
+        size_t ply,
+        int depth,
+        Evaluation alpha,
+        Evaluation beta,
+        std::optional<Move> excluded_move = {})
     {
         m_nodes_searched++;
+        if (should_abort())
+            return Evaluation::zero();
+
+        // Mate distance pruning. Even mating on the next move can't score better than a mate
+        // from here, so if a quicker mate has already been found there's nothing to search
+        alpha = std::max(alpha, Evaluation::mated_in(ply));
+        beta = std::min(beta, Evaluation::mate_in(ply + 1));
+        if (alpha >= beta)
+            return alpha;
 
         // First thing to do is check the transposition table to see if we've
         // searched this position to a greater depth than we're about to search now
-        if (auto entry = m_transposition_table.find(game_state.snapshot()); entry.has_value()) {
-            auto current_depth_remaining = max_depth - depth;
-            auto tt_depth_remaining = entry->max_depth - entry->depth;
-            if (tt_depth_remaining >= current_depth_remaining) {
-                switch (entry->type) {
-                case TranspositionEntry::Type::Exact:
-                    return entry->evaluation;
-                case TranspositionEntry::Type::UpperBound:
-                    beta = std::min(beta, entry->evaluation);
-                    break;
-                case TranspositionEntry::Type::LowerBound:
-                    alpha = std::max(alpha, entry->evaluation);
-                    break;
-                }
-
-                if (alpha >= beta)
-                    return entry->evaluation;
+        std::optional<TranspositionEntry> entry {};
+        if (!excluded_move.has_value())
+            entry = find(game_state.snapshot(), ply);
+
+        // The best line is read back out of the transposition table, so the root always has to be
+        // searched for it to have an entry there. A deep result from the analysis cache still
+        // puts its move first, and the positions after it will mostly be cached too. Only this
+        // search's own entry for the root decides the move that gets played
+        if (entry.has_value() && static_cast<int>(entry->depth) >= depth && ply > 0) {
+            switch (entry->type) {
+            case TranspositionEntry::Type::Exact:
+                return entry->evaluation();
+            case TranspositionEntry::Type::UpperBound:
+                beta = std::min(beta, entry->evaluation());
+                break;
+            case TranspositionEntry::Type::LowerBound:
+                alpha = std::max(alpha, entry->evaluation());
+                break;
             }
+
+            if (alpha >= beta)
+                return entry->evaluation();
         }
 
-        if (depth >= max_depth) {
+        if (depth <= 0) {
             // We've reached the max depth but stopping here could be dangerous. For example,
             // if we just captured a pawn with our queen, it could look like we're up a pawn
             // here. In reality, we're probably about to lose our queen for that pawn, so
             // we need to exaust all captures in the current position before we evaluate it
-            return quiescence_search(game_state, alpha, beta);
+            return quiescence_search(game_state, ply, alpha, beta);
         }
 
         const auto& move_set = game_state.move_set();
         if (move_set.legal_moves().empty()) {
             // Don't bother searching further, the game is either in a
             // checkmate or stalemate
-            return Evaluator::default_instance.evaluate(game_state);
+            return terminal_evaluation(game_state, ply);
+        }
+
+        std::optional<Move> tt_move {};
+        if (entry.has_value()) {
+            if (auto legal_move = legal_move_of(*entry, game_state); legal_move.has_value())
+                tt_move = legal_move->move();
         }
 
+        // Internal iterative reduction. Without a TT move the move ordering here is poor, so
+        // search it a little shallower and let the next iteration find a move to start with
+        if (m_features.internal_iterative_reductions && !tt_move.has_value()
+            && depth >= internal_iterative_reduction_min_depth)
+            depth--;
+
         auto evaluation_type = TranspositionEntry::Type::UpperBound;
         std::optional<Move> best_move {};
 
@@ -130,31 +375,47 @@ private:
 
         // Sort the legal moves by a rough evaluation of move quality. This
         // improves Alpha-Beta pruning performance significantly since we're
-        // likely to find good moves first, and thus prune more of the search
+        // likely to find good moves first, and thus prune more of the search.
+        // The TT move was the best move last time, so it's tried before all of them
         std::copy(move_set.legal_moves().begin(), move_set.legal_moves().end(), std::back_inserter(legal_moves));
-        std::sort(legal_moves.begin(),
-            std::next(legal_moves.begin(), move_set.legal_moves().size()),
-            MoveSorter::default_instance);
+        std::sort(legal_moves.begin(), legal_moves.end(), MoveSorter::default_instance);
+        if (tt_move.has_value()) {
+            auto it = std::find_if(legal_moves.begin(), legal_moves.end(), [&](const auto& legal_move) {
+                return legal_move.move() == *tt_move;
+            });
 
-        for (size_t i = 0; i < move_set.legal_moves().size(); i++) {
-            const auto& legal_move = legal_moves[i];
+            if (it != legal_moves.end())
+                std::rotate(legal_moves.begin(), it, std::next(it));
+        }
+
+        auto tt_move_is_singular = !excluded_move.has_value() && is_singular(game_state, ply, depth, entry, tt_move);
+        if (m_aborted)
+            return Evaluation::zero();
+
+        for (const auto& legal_move : legal_moves) {
             assert(legal_move.move() != Move::null);
+            if (excluded_move.has_value() && legal_move.move() == *excluded_move)
+                continue;
 
             auto new_game_state = GameState(legal_move.snapshot());
-            auto evaluation = -search(new_game_state, depth + 1, max_depth, -beta, -alpha);
+            auto extension
+                = depth_adjustment(new_game_state, ply, tt_move_is_singular && legal_move.move() == *tt_move);
+            auto evaluation = -search(new_game_state, ply + 1, depth - 1 + extension, -beta, -alpha);
+            if (m_aborted)
+                return Evaluation::zero();
 
             // This move is better than a previous best-case for the opponent,
             // so the opponent won't allow us to make it. We can prune the rest of the
             // search tree.
             if (evaluation >= beta) {
-                m_transposition_table.insert(game_state.snapshot(),
-                    {
-                        .type = TranspositionEntry::Type::LowerBound,
-                        .move = legal_move.move(),
-                        .depth = depth,
-                        .max_depth = max_depth,
-                        .evaluation = beta,
-                    });
+                if (!excluded_move.has_value()) {
+                    store(game_state.snapshot(),
+                        TranspositionEntry::Type::LowerBound,
+                        legal_move.move(),
+                        depth,
+                        beta,
+                        ply);
+                }
 
                 return beta;
             }
@@ -166,93 +427,158 @@ private:
             }
         }
 
-        m_transposition_table.insert(game_state.snapshot(),
-            {
-                .type = evaluation_type,
-                .move = best_move.value_or(move_set.legal_moves().front().move()),
-                .depth = depth,
-                .max_depth = max_depth,
-                .evaluation = alpha,
-            });
-
-        if (m_nodes_searched > m_next_control_event) {
-            submit_progress(max_depth, false);
+        if (!excluded_move.has_value()) {
+            store(game_state.snapshot(),
+                evaluation_type,
+                best_move.value_or(legal_moves.front().move()),
+                depth,
+                alpha,
+                ply);
         }
 
         return alpha;
     }
 
+    std::vector<Move> best_line(size_t max_depth) const
+    {
+        std::vector<Move> line = {};
+
+        auto snapshot = m_root_game_state.snapshot();
+        while (line.size() < max_depth) {
+            auto entry = find_in_line(snapshot, line.size());
+            if (!entry.has_value()) {
+                break;
+            }
+
+            // Moves are stored in their compact form, so need to be decoded against the position
+            auto legal_move = legal_move_of(*entry, GameState(snapshot));
+            if (!legal_move.has_value()) {
+                break;
+            }
+
+            line.push_back(legal_move->move());
+            snapshot = legal_move->snapshot();
+        }
+
+        return line;
+    }
+
 public:
-    SearchInstance(const Checkpointer& checkpointer, const GameState& root_game_state)
-        : m_checkpointer(checkpointer)
+    SearchInstance(const GameState& root_game_state,
+        TranspositionTable& transposition_table,
+        AnalysisCache* analysis_cache,
+        const SearchFeatures& features,
+        const threading::Token& stop,
+        std::optional<size_t> max_nodes,
+        std::atomic<size_t>& published_nodes,
+        std::atomic<size_t>& published_quiescence_nodes)
+        : m_transposition_table(transposition_table)
         , m_root_game_state(root_game_state)
+        , m_analysis_cache(analysis_cache)
+        , m_features(features)
+        , m_stop(stop)
+        , m_max_nodes(max_nodes)
+        , m_published_nodes(published_nodes)
+        , m_published_quiescence_nodes(published_quiescence_nodes)
     {
     }
 
-    void search_to_depth(size_t max_depth)
+    // Returns the results of the iteration, unless it was stopped before it could finish
+    std::optional<SearchProgress> search_to_depth(size_t max_depth)
     {
         log::debug("Starting search to depth: {}", max_depth);
-        search(m_root_game_state, 0, max_depth, Evaluation::negative_inf(), Evaluation::positive_inf());
-        submit_progress(max_depth, true);
-    }
+        m_root_depth = max_depth;
+        auto evaluation = search(
+            m_root_game_state, 0, static_cast<int>(max_depth), Evaluation::negative_inf(), Evaluation::positive_inf());
+
+        publish_nodes_searched();
+        if (m_aborted)
+            return {};
 
-    friend class SearchProgress;
+        return SearchProgress(
+            max_depth, total_nodes_searched(), m_quiescence_nodes_searched, evaluation, best_line(max_depth));
+    }
 };
 
-SearchProgress::SearchProgress(SearchInstance* instance, bool has_new_results, size_t max_depth_reached)
-    : m_has_new_results(has_new_results)
-    , m_max_depth_reached(max_depth_reached)
-    , m_search_instance(instance)
+SearchProgress::SearchProgress(size_t max_depth_reached,
+    size_t nodes_searched,
+    size_t quiescence_nodes_searched,
+    Evaluation evaluation,
+    std::vector<Move> best_line)
+    : m_max_depth_reached(max_depth_reached)
+    , m_nodes_searched(nodes_searched)
+    , m_quiescence_nodes_searched(quiescence_nodes_searched)
+    , m_evaluation(evaluation)
+    , m_best_line(std::move(best_line))
 {
 }
 
-bool SearchProgress::has_new_results() const { return m_has_new_results; }
 size_t SearchProgress::max_depth() const { return m_max_depth_reached; }
-size_t SearchProgress::nodes_searched() const { return m_search_instance->m_nodes_searched; }
-
-Evaluation SearchProgress::evaluation() const
+size_t SearchProgress::nodes_searched() const { return m_nodes_searched; }
+size_t SearchProgress::quiescence_nodes_searched() const { return m_quiescence_nodes_searched; }
+Evaluation SearchProgress::evaluation() const { return m_evaluation; }
+const std::vector<Move>& SearchProgress::best_line() const { return m_best_line; }
+
+Searcher::Searcher(const SearchFeatures& features,
+    std::shared_ptr<AnalysisCache> analysis_cache,
+    std::shared_ptr<TranspositionTable> transposition_table)
+    : m_features(features)
+    , m_analysis_cache(std::move(analysis_cache))
+    , m_transposition_table(
+          transposition_table != nullptr ? std::move(transposition_table) : std::make_shared<TranspositionTable>())
 {
-    auto entry = m_search_instance->m_transposition_table.find(m_search_instance->m_root_game_state.snapshot());
-    if (!entry.has_value()) {
-        return Evaluation::zero();
-    }
-
-    return entry->evaluation;
 }
 
-std::vector<Move> SearchProgress::best_line() const
+size_t Searcher::nodes_searched() const { return m_nodes_searched.load(std::memory_order_relaxed); }
+size_t Searcher::quiescence_nodes_searched() const
 {
-    std::vector<Move> line = {};
-
-    std::optional<GameSnapshot> next_snapshot = m_search_instance->m_root_game_state.snapshot();
-    while (next_snapshot.has_value() && line.size() < m_max_depth_reached) {
-        auto entry = m_search_instance->m_transposition_table.find(next_snapshot.value());
-        if (!entry.has_value()) {
-            break;
-        }
+    return m_quiescence_nodes_searched.load(std::memory_order_relaxed);
+}
 
-        line.push_back(entry->move);
-        next_snapshot = next_snapshot->by_performing_move(entry->move);
-    }
+size_t Searcher::current_depth() const { return m_current_depth.load(std::memory_order_relaxed); }
 
-    return line;
+void Searcher::search(const GameState& game_state, size_t max_depth, const Checkpointer& checkpointer)
+{
+    threading::Token stop;
+    search(game_state, max_depth, checkpointer, stop);
 }
 
-void Searcher::search(const GameState& game_state, size_t max_depth, const Checkpointer& checkpointer)
+void Searcher::search(const GameState& game_state,
+    size_t max_depth,
+    const Checkpointer& checkpointer,
+    const threading::Token& stop,
+    std::optional<size_t> max_nodes)
 {
-    SearchInstance instance(checkpointer, game_state);
+    m_nodes_searched.store(0, std::memory_order_relaxed);
+    m_quiescence_nodes_searched.store(0, std::memory_order_relaxed);
+    m_current_depth.store(0, std::memory_order_relaxed);
+
+    SearchInstance instance(game_state,
+        *m_transposition_table,
+        m_analysis_cache.get(),
+        m_features,
+        stop,
+        max_nodes,
+        m_nodes_searched,
+        m_quiescence_nodes_searched);
     if (game_state.move_set().legal_moves().empty()) {
         return;
     }
 
     // https://en.wikipedia.org/wiki/Iterative_deepening_depth-first_search
     for (size_t i = 0; i < max_depth; ++i) {
-        try {
-            instance.search_to_depth(i + 1);
-        } catch (const SearchAbortedException&) {
+        m_current_depth.store(i + 1, std::memory_order_relaxed);
+
+        auto progress = instance.search_to_depth(i + 1);
+        if (!progress.has_value()) {
             log::debug("Search aborted");
             break;
         }
+
+        SearchControl control;
+        checkpointer(*progress, control);
+        if (control.stop)
+            break;
     }
 
     log::debug("Search finished");
@@ -0,0 +1,426 @@
+#pragma once
+
+// The rook and bishop attack table layout, shared by the library and the generator that
+// precomputes the tables at build time (see tools/slidergen)
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define WEECHESS_HAS_PEXT
+#endif
+
+#include <array>
+#include <optional>
+#include <tuple>
+
+#include <weechess/attack_maps.h>
+#include <weechess/bit_board.h>
+#include <weechess/board.h>
+#include <weechess/location.h>
+
+namespace weechess::slider_attacks {
+
+using attack_maps::SliderBackend;
+
+constexpr std::array<BitBoard, 64> rook_magics = {
+    BitBoard(0xa8002c000108020ULL),
+    BitBoard(0x6c00049b0002001ULL),
+    BitBoard(0x100200010090040ULL),
+    BitBoard(0x2480041000800801ULL),
+    BitBoard(0x280028004000800ULL),
+    BitBoard(0x900410008040022ULL),
+    BitBoard(0x280020001001080ULL),
+    BitBoard(0x2880002041000080ULL),
+    BitBoard(0xa000800080400034ULL),
+    BitBoard(0x4808020004000ULL),
+    BitBoard(0x2290802004801000ULL),
+    BitBoard(0x411000d00100020ULL),
+    BitBoard(0x402800800040080ULL),
+    BitBoard(0xb000401004208ULL),
+    BitBoard(0x2409000100040200ULL),
+    BitBoard(0x1002100004082ULL),
+    BitBoard(0x22878001e24000ULL),
+    BitBoard(0x1090810021004010ULL),
+    BitBoard(0x801030040200012ULL),
+    BitBoard(0x500808008001000ULL),
+    BitBoard(0xa08018014000880ULL),
+    BitBoard(0x8000808004000200ULL),
+    BitBoard(0x201008080010200ULL),
+    BitBoard(0x801020000441091ULL),
+    BitBoard(0x800080204005ULL),
+    BitBoard(0x1040200040100048ULL),
+    BitBoard(0x120200402082ULL),
+    BitBoard(0xd14880480100080ULL),
+    BitBoard(0x12040280080080ULL),
+    BitBoard(0x100040080020080ULL),
+    BitBoard(0x9020010080800200ULL),
+    BitBoard(0x813241200148449ULL),
+    BitBoard(0x491604001800080ULL),
+    BitBoard(0x100401000402001ULL),
+    BitBoard(0x4820010021001040ULL),
+    BitBoard(0x400402202000812ULL),
+    BitBoard(0x209009005000802ULL),
+    BitBoard(0x810800601800400ULL),
+    BitBoard(0x4301083214000150ULL),
+    BitBoard(0x204026458e001401ULL),
+    BitBoard(0x40204000808000ULL),
+    BitBoard(0x8001008040010020ULL),
+    BitBoard(0x8410820820420010ULL),
+    BitBoard(0x1003001000090020ULL),
+    BitBoard(0x804040008008080ULL),
+    BitBoard(0x12000810020004ULL),
+    BitBoard(0x1000100200040208ULL),
+    BitBoard(0x430000a044020001ULL),
+    BitBoard(0x280009023410300ULL),
+    BitBoard(0xe0100040002240ULL),
+    BitBoard(0x200100401700ULL),
+    BitBoard(0x2244100408008080ULL),
+    BitBoard(0x8000400801980ULL),
+    BitBoard(0x2000810040200ULL),
+    BitBoard(0x8010100228810400ULL),
+    BitBoard(0x2000009044210200ULL),
+    BitBoard(0x4080008040102101ULL),
+    BitBoard(0x40002080411d01ULL),
+    BitBoard(0x2005524060000901ULL),
+    BitBoard(0x502001008400422ULL),
+    BitBoard(0x489a000810200402ULL),
+    BitBoard(0x1004400080a13ULL),
+    BitBoard(0x4000011008020084ULL),
+    BitBoard(0x26002114058042ULL),
+};
+
+constexpr std::array<BitBoard, 64> bishop_magics = {
+    BitBoard(0x89a1121896040240ULL),
+    BitBoard(0x2004844802002010ULL),
+    BitBoard(0x2068080051921000ULL),
+    BitBoard(0x62880a0220200808ULL),
+    BitBoard(0x0004042004000000ULL),
+    BitBoard(0x0100822020200011ULL),
+    BitBoard(0xc00444222012000aULL),
+    BitBoard(0x0028808801216001ULL),
+    BitBoard(0x0400492088408100ULL),
+    BitBoard(0x0201c401040c0084ULL),
+    BitBoard(0x00840800910a0010ULL),
+    BitBoard(0x0000082080240060ULL),
+    BitBoard(0x2000840504006000ULL),
+    BitBoard(0x30010c4108405004ULL),
+    BitBoard(0x1008005410080802ULL),
+    BitBoard(0x8144042209100900ULL),
+    BitBoard(0x0208081020014400ULL),
+    BitBoard(0x004800201208ca00ULL),
+    BitBoard(0x0f18140408012008ULL),
+    BitBoard(0x1004002802102001ULL),
+    BitBoard(0x0841000820080811ULL),
+    BitBoard(0x0040200200a42008ULL),
+    BitBoard(0x0000800054042000ULL),
+    BitBoard(0x88010400410c9000ULL),
+    BitBoard(0x0520040470104290ULL),
+    BitBoard(0x1004040051500081ULL),
+    BitBoard(0x2002081833080021ULL),
+    BitBoard(0x000400c00c010142ULL),
+    BitBoard(0x941408200c002000ULL),
+    BitBoard(0x0658810000806011ULL),
+    BitBoard(0x0188071040440a00ULL),
+    BitBoard(0x4800404002011c00ULL),
+    BitBoard(0x0104442040404200ULL),
+    BitBoard(0x0511080202091021ULL),
+    BitBoard(0x0004022401120400ULL),
+    BitBoard(0x80c0040400080120ULL),
+    BitBoard(0x8040010040820802ULL),
+    BitBoard(0x0480810700020090ULL),
+    BitBoard(0x0102008e00040242ULL),
+    BitBoard(0x0809005202050100ULL),
+    BitBoard(0x8002024220104080ULL),
+    BitBoard(0x0431008804142000ULL),
+    BitBoard(0x0019001802081400ULL),
+    BitBoard(0x0200014208040080ULL),
+    BitBoard(0x3308082008200100ULL),
+    BitBoard(0x041010500040c020ULL),
+    BitBoard(0x4012020c04210308ULL),
+    BitBoard(0x208220a202004080ULL),
+    BitBoard(0x0111040120082000ULL),
+    BitBoard(0x6803040141280a00ULL),
+    BitBoard(0x2101004202410000ULL),
+    BitBoard(0x8200000041108022ULL),
+    BitBoard(0x0000021082088000ULL),
+    BitBoard(0x0002410204010040ULL),
+    BitBoard(0x0040100400809000ULL),
+    BitBoard(0x0822088220820214ULL),
+    BitBoard(0x0040808090012004ULL),
+    BitBoard(0x00910224040218c9ULL),
+    BitBoard(0x0402814422015008ULL),
+    BitBoard(0x0090014004842410ULL),
+    BitBoard(0x0001000042304105ULL),
+    BitBoard(0x0010008830412a00ULL),
+    BitBoard(0x2520081090008908ULL),
+    BitBoard(0x40102000a0a60140ULL),
+};
+
+constexpr std::array<unsigned int, 64> rook_magic_indexes = {
+    // clang-format off
+12, 11, 11, 11, 11, 11, 11, 12,
+11, 10, 10, 10, 10, 10, 10, 11,
+11, 10, 10, 10, 10, 10, 10, 11,
+11, 10, 10, 10, 10, 10, 10, 11,
+11, 10, 10, 10, 10, 10, 10, 11,
+11, 10, 10, 10, 10, 10, 10, 11,
+11, 10, 10, 10, 10, 10, 10, 11,
+12, 11, 11, 11, 11, 11, 11, 12,
+    // clang-format on
+};
+
+constexpr std::array<unsigned int, 64> bishop_magic_indexes = {
+    // clang-format off
+6, 5, 5, 5, 5, 5, 5, 6,
+5, 5, 5, 5, 5, 5, 5, 5,
+5, 5, 7, 7, 7, 7, 5, 5,
+5, 5, 7, 9, 9, 7, 5, 5,
+5, 5, 7, 9, 9, 7, 5, 5,
+5, 5, 7, 7, 7, 7, 5, 5,
+5, 5, 5, 5, 5, 5, 5, 5,
+6, 5, 5, 5, 5, 5, 5, 6,
+    // clang-format on
+};
+
+enum Direction : u_int8_t {
+    North,
+    NorthEast,
+    East,
+    SouthEast,
+    South,
+    SouthWest,
+    West,
+    NorthWest,
+};
+
+constexpr std::array<Direction, 8> directions = {
+    Direction::North,
+    Direction::NorthEast,
+    Direction::East,
+    Direction::SouthEast,
+    Direction::South,
+    Direction::SouthWest,
+    Direction::West,
+    Direction::NorthWest,
+};
+
+constexpr std::array<std::tuple<Location::FileShift, Location::RankShift>, 8> directionSteps = {
+    std::make_tuple(Location::FileShift {}, Location::Up),
+    std::make_tuple(Location::Right, Location::Up),
+    std::make_tuple(Location::Right, Location::RankShift {}),
+    std::make_tuple(Location::Right, Location::Down),
+    std::make_tuple(Location::FileShift {}, Location::Down),
+    std::make_tuple(Location::Left, Location::Down),
+    std::make_tuple(Location::Left, Location::RankShift {}),
+    std::make_tuple(Location::Left, Location::Up),
+};
+
+constexpr BitBoard compute_ray(Location location, Location::FileShift fs, Location::RankShift rs)
+{
+    BitBoard bb;
+    std::optional<Location> lprime = location;
+    while ((lprime = lprime->offset_by(fs, rs))) {
+        bb.set(*lprime);
+    }
+
+    return bb;
+}
+
+constexpr std::array<std::array<BitBoard, 8>, 64> compute_all_rays()
+{
+    std::array<std::array<BitBoard, 8>, 64> rays { {} };
+    for (auto i = 0; i < 64; i++) {
+        Location location(i);
+        for (const auto& direction : directions) {
+            const auto& steps = directionSteps[direction];
+            rays[i][direction] = compute_ray(location, std::get<0>(steps), std::get<1>(steps));
+        }
+    }
+
+    return rays;
+}
+
+constexpr std::array<std::array<BitBoard, 8>, 64> rays = compute_all_rays();
+
+constexpr std::array<BitBoard, 64> compute_rook_slide_masks()
+{
+    std::array<BitBoard, 64> masks {};
+    for (auto i = 0; i < 64; i++) {
+        Location l(i);
+
+        masks[i] |= rays[i][Direction::West] & ~File('A').mask();
+        masks[i] |= rays[i][Direction::East] & ~File('H').mask();
+        masks[i] |= rays[i][Direction::North] & ~Rank(8).mask();
+        masks[i] |= rays[i][Direction::South] & ~Rank(1).mask();
+    }
+
+    return masks;
+}
+
+constexpr std::array<BitBoard, 64> compute_bishop_slide_masks()
+{
+    std::array<BitBoard, 64> masks {};
+    for (auto i = 0; i < 64; i++) {
+        Location l(i);
+
+        masks[i] |= rays[i][Direction::NorthWest] & ~(File('A').mask() | Rank(8).mask());
+        masks[i] |= rays[i][Direction::SouthWest] & ~(File('A').mask() | Rank(1).mask());
+        masks[i] |= rays[i][Direction::NorthEast] & ~(File('H').mask() | Rank(8).mask());
+        masks[i] |= rays[i][Direction::SouthEast] & ~(File('H').mask() | Rank(1).mask());
+    }
+
+    return masks;
+}
+
+constexpr BitBoard compute_rook_attacks_unoptimized(Location location, BitBoard blockers)
+{
+    BitBoard bb;
+
+    auto up_ray = rays[location.offset][Direction::North];
+    auto down_ray = rays[location.offset][Direction::South];
+    auto right_ray = rays[location.offset][Direction::East];
+    auto left_ray = rays[location.offset][Direction::West];
+
+    // Up
+    bb |= up_ray;
+    if ((up_ray & blockers) != BitBoard::empty()) {
+        bb &= ~(rays[Location((up_ray & blockers).lsb().value()).offset][Direction::North]);
+    }
+
+    // Down
+    bb |= down_ray;
+    if ((down_ray & blockers) != BitBoard::empty()) {
+        bb &= ~(rays[Location((down_ray & blockers).msb().value()).offset][Direction::South]);
+    }
+
+    // Right
+    bb |= right_ray;
+    if ((right_ray & blockers) != BitBoard::empty()) {
+        bb &= ~(rays[Location((right_ray & blockers).lsb().value()).offset][Direction::East]);
+    }
+
+    // Left
+    bb |= left_ray;
+    if ((left_ray & blockers) != BitBoard::empty()) {
+        bb &= ~(rays[Location((left_ray & blockers).msb().value()).offset][Direction::West]);
+    }
+
+    return bb;
+}
+
+constexpr BitBoard compute_bishop_attacks_unoptimized(Location location, BitBoard blockers)
+{
+    BitBoard bb;
+
+    auto up_right_ray = rays[location.offset][Direction::NorthEast];
+    auto down_right_ray = rays[location.offset][Direction::SouthEast];
+    auto down_left_ray = rays[location.offset][Direction::SouthWest];
+    auto up_left_ray = rays[location.offset][Direction::NorthWest];
+
+    // Up Right
+    bb |= up_right_ray;
+    if ((up_right_ray & blockers) != BitBoard::empty()) {
+        bb &= ~(rays[Location((up_right_ray & blockers).lsb().value()).offset][Direction::NorthEast]);
+    }
+
+    // Down Right
+    bb |= down_right_ray;
+    if ((down_right_ray & blockers) != BitBoard::empty()) {
+        bb &= ~(rays[Location((down_right_ray & blockers).msb().value()).offset][Direction::SouthEast]);
+    }
+
+    // Down Left
+    bb |= down_left_ray;
+    if ((down_left_ray & blockers) != BitBoard::empty()) {
+        bb &= ~(rays[Location((down_left_ray & blockers).msb().value()).offset][Direction::SouthWest]);
+    }
+
+    // Up Left
+    bb |= up_left_ray;
+    if ((up_left_ray & blockers) != BitBoard::empty()) {
+        bb &= ~(rays[Location((up_left_ray & blockers).lsb().value()).offset][Direction::NorthWest]);
+    }
+
+    return bb;
+}
+
+// Every square gets a slice of one shared attack table sized for exactly the number of
+// blocker configurations it can see ("fancy" magics), rather than the worst case size
+struct SliderEntry {
+    BitBoard mask;
+    BitBoard magic;
+    unsigned int shift;
+    size_t offset;
+};
+
+constexpr size_t compute_table_size(const std::array<unsigned int, 64>& magic_indexes)
+{
+    size_t size = 0;
+    for (const auto& bits : magic_indexes)
+        size += 1ULL << bits;
+
+    return size;
+}
+
+constexpr size_t rook_table_size = compute_table_size(rook_magic_indexes);
+constexpr size_t bishop_table_size = compute_table_size(bishop_magic_indexes);
+
+using SliderEntries = std::array<SliderEntry, 64>;
+using SliderTable = std::array<BitBoard, rook_table_size + bishop_table_size>;
+
+constexpr SliderEntries compute_slider_entries(const std::array<BitBoard, 64>& masks,
+    const std::array<BitBoard, 64>& magics,
+    const std::array<unsigned int, 64>& magic_indexes,
+    size_t offset)
+{
+    SliderEntries entries {};
+    for (auto i = 0; i < 64; i++) {
+        entries[i] = SliderEntry {
+            .mask = masks[i],
+            .magic = magics[i],
+            .shift = 64 - magic_indexes[i],
+            .offset = offset,
+        };
+
+        offset += 1ULL << magic_indexes[i];
+    }
+
+    return entries;
+}
+
+constexpr SliderEntries k_rook_entries
+    = compute_slider_entries(compute_rook_slide_masks(), rook_magics, rook_magic_indexes, 0);
+constexpr SliderEntries k_bishop_entries
+    = compute_slider_entries(compute_bishop_slide_masks(), bishop_magics, bishop_magic_indexes, rook_table_size);
+
+constexpr size_t magic_index(const SliderEntry& entry, BitBoard blockers)
+{
+    return ((blockers & entry.mask).data() * entry.magic.data()) >> entry.shift;
+}
+
+template <typename F>
+constexpr void fill_slider_table(
+    SliderTable& table, const SliderEntries& entries, SliderBackend backend, F compute_attacks)
+{
+    for (auto i = 0; i < 64; i++) {
+        const auto& entry = entries[i];
+
+        // Walk every subset of the mask in increasing order (the "Carry-Rippler" trick), which is
+        // also the order of the pext index, so the n'th subset is stored at n for that backend
+        size_t n = 0;
+        BitBoard::Data blockers = 0;
+        do {
+            auto index = backend == SliderBackend::Pext ? n : magic_index(entry, blockers);
+            table[entry.offset + index] = compute_attacks(Location(i), blockers);
+
+            blockers = (blockers - entry.mask.data()) & entry.mask.data();
+            n++;
+        } while (blockers != 0);
+    }
+}
+
+inline void fill_slider_table(SliderTable& table, SliderBackend backend)
+{
+    fill_slider_table(table, k_rook_entries, backend, compute_rook_attacks_unoptimized);
+    fill_slider_table(table, k_bishop_entries, backend, compute_bishop_attacks_unoptimized);
+}
+
+}
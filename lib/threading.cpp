@@ -1,7 +1,33 @@
+#include <algorithm>
+
 #include <weechess/threading.h>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 namespace weechess::threading {
 
+namespace {
+
+    // Which pool (if any) the current thread is a worker of, so tasks submitted from inside a
+    // task go onto that worker's own deque
+    thread_local const ThreadPool* current_pool = nullptr;
+    thread_local size_t current_worker_index = 0;
+
+    void pin_to_cpu([[maybe_unused]] std::thread& thread, [[maybe_unused]] size_t cpu)
+    {
+#ifdef __linux__
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(cpu % CPU_SETSIZE, &cpu_set);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set), &cpu_set);
+#endif
+    }
+
+}
+
 Token::Token()
     : m_invalidated(false)
 {
@@ -12,4 +38,113 @@ bool Token::invalidated() const { return m_invalidated.load(); }
 
 bool Token::reset() { return m_invalidated.exchange(false); }
 
+size_t ThreadPool::default_thread_count() { return std::max(1U, std::thread::hardware_concurrency()); }
+
+ThreadPool::ThreadPool(size_t thread_count, bool pin_threads)
+{
+    thread_count = std::max(thread_count, size_t(1));
+    for (size_t i = 0; i < thread_count; i++)
+        m_workers.push_back(std::make_unique<Worker>());
+
+    // Workers steal from each other, so they can only start once all the deques exist
+    auto cpu_count = default_thread_count();
+    for (size_t i = 0; i < thread_count; i++) {
+        m_workers[i]->thread = std::thread(&ThreadPool::run_worker, this, i);
+        if (pin_threads)
+            pin_to_cpu(m_workers[i]->thread, i % cpu_count);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_condition.notify_all();
+    for (auto& worker : m_workers)
+        worker->thread.join();
+}
+
+size_t ThreadPool::size() const { return m_workers.size(); }
+
+void ThreadPool::push(Task task)
+{
+    auto index = current_pool == this ? current_worker_index
+                                      : m_next_worker.fetch_add(1, std::memory_order_relaxed) % m_workers.size();
+
+    {
+        std::lock_guard lock(m_workers[index]->mutex);
+        m_workers[index]->tasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_pending_tasks++;
+    }
+
+    m_condition.notify_one();
+}
+
+std::optional<ThreadPool::Task> ThreadPool::take(std::optional<size_t> worker_index)
+{
+    std::optional<Task> task;
+
+    if (worker_index.has_value()) {
+        auto& worker = *m_workers[*worker_index];
+        std::lock_guard lock(worker.mutex);
+        if (!worker.tasks.empty()) {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+        }
+    }
+
+    auto first_victim = worker_index.value_or(0) + 1;
+    for (size_t i = 0; i < m_workers.size() && !task.has_value(); i++) {
+        auto& victim = *m_workers[(first_victim + i) % m_workers.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+
+    if (task.has_value()) {
+        std::lock_guard lock(m_mutex);
+        m_pending_tasks--;
+    }
+
+    return task;
+}
+
+bool ThreadPool::run_pending_task()
+{
+    auto worker_index = current_pool == this ? std::optional(current_worker_index) : std::nullopt;
+    if (auto task = take(worker_index)) {
+        (*task)();
+        return true;
+    }
+
+    return false;
+}
+
+void ThreadPool::run_worker(size_t worker_index)
+{
+    current_pool = this;
+    current_worker_index = worker_index;
+
+    for (;;) {
+        if (auto task = take(worker_index)) {
+            (*task)();
+            continue;
+        }
+
+        std::unique_lock lock(m_mutex);
+        m_condition.wait(lock, [&] { return m_stopping || m_pending_tasks > 0; });
+        if (m_stopping && m_pending_tasks == 0)
+            return;
+    }
+}
+
 }
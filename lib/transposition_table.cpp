@@ -1,18 +1,54 @@
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+
+#include <weechess/game_state.h>
 #include <weechess/transposition_table.h>
 
 namespace weechess {
 
-void TranspositionTable::insert(const GameSnapshot& snapshot, const TranspositionTable::Value& entry)
+TranspositionTable::TranspositionTable(size_t size_in_bytes)
+    : m_entries(std::bit_floor(std::max(size_in_bytes / sizeof(Value), size_t(1))))
 {
-    m_table.insert_or_assign(snapshot.zobrist_hash(), entry);
 }
 
-std::optional<TranspositionTable::Value> TranspositionTable::find(const GameSnapshot& snapshot) const
+void TranspositionTable::insert(const GameSnapshot& snapshot,
+    Value::Type type,
+    const Move& move,
+    size_t depth,
+    Evaluation evaluation,
+    size_t ply)
+{
+    auto hash = snapshot.zobrist_hash();
+    auto score = evaluation.relative_to_ply(ply).score;
+    assert(score >= INT16_MIN && score <= INT16_MAX);
+
+    m_entries[index_of(hash)] = Value {
+        .key = key_of(hash),
+        .move = CompactMove(move),
+        .score = static_cast<int16_t>(score),
+        .depth = static_cast<uint8_t>(std::min(depth, size_t(UINT8_MAX))),
+        .type = type,
+    };
+}
+
+std::optional<TranspositionTable::Value> TranspositionTable::find(const GameSnapshot& snapshot, size_t ply) const
 {
-    auto itr = m_table.find(snapshot.zobrist_hash());
-    if (itr == m_table.end())
+    auto hash = snapshot.zobrist_hash();
+    auto entry = m_entries[index_of(hash)];
+    if (entry.is_empty() || entry.key != key_of(hash))
         return {};
-    return itr->second;
+
+    entry.score = static_cast<int16_t>(entry.evaluation().relative_to_root(ply).score);
+    return entry;
 }
 
+size_t TranspositionTable::capacity() const { return m_entries.size(); }
+
+void TranspositionTable::clear() { std::fill(m_entries.begin(), m_entries.end(), Value {}); }
+
+uint16_t TranspositionTable::key_of(Key hash) { return static_cast<uint16_t>(hash >> 48); }
+size_t TranspositionTable::index_of(Key hash) const { return hash & (m_entries.size() - 1); }
+
 }
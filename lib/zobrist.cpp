@@ -35,7 +35,8 @@ namespace {
     }
 }
 
-const Hasher Hasher::default_instance = generate_zobrist_hasher();
+// Hashing happens constantly during search, and the keys never change, so they're baked in at compile time
+constinit const Hasher Hasher::default_instance = generate_zobrist_hasher();
 
 Hash Hasher::hash(const GameSnapshot& snapshot) const
 {
@@ -42,6 +42,12 @@ int main(int argc, char* argv[])
     uci_parser.add_argument("--help").default_value(false).implicit_value(true);
     parser.add_subparser(uci_parser);
 
+    argparse::ArgumentParser bench_parser(BENCH_CMD_NAME, UCI_CMD_VERSION, argparse::default_arguments::none);
+    bench_parser.add_description(BENCH_CMD_DESCRIPTION);
+    bench_parser.add_argument("--help").default_value(false).implicit_value(true);
+    bench_parser.add_argument("depth").help("How deep to search each position").remaining();
+    parser.add_subparser(bench_parser);
+
     try {
         parser.parse_args(argc, argv);
     } catch (const std::runtime_error& err) {
@@ -55,6 +61,20 @@ int main(int argc, char* argv[])
         return run_subcommand(argc, argv, parser, play_parser);
     } else if (parser.is_subcommand_used(UCI_CMD_NAME)) {
         return run_subcommand(argc, argv, parser, uci_parser);
+    } else if (parser.is_subcommand_used(BENCH_CMD_NAME)) {
+        if (bench_parser.get<bool>("--help")) {
+            std::cout << bench_parser;
+            return 0;
+        }
+
+        // The benchmark is one of the UCI engine's commands, so the arguments go to it as they are
+        std::string cmd = std::string(argv[0]) + "-" UCI_CMD_NAME;
+        for (int i = 1; i < argc; ++i) {
+            cmd += " ";
+            cmd += argv[i];
+        }
+
+        return std::system(cmd.c_str());
     }
 
     std::cerr << parser;
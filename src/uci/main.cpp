@@ -1,12 +1,23 @@
+#include <algorithm>
+#include <charconv>
+#include <condition_variable>
+#include <deque>
+#include <future>
 #include <iostream>
+#include <mutex>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <argparse/argparse.h>
+#include <weechess/analysis_cache.h>
+#include <weechess/bench.h>
+#include <weechess/book.h>
 #include <weechess/engine.h>
 #include <weechess/game_state.h>
+#include <weechess/polyglot_book.h>
 #include <weechess/threading.h>
 
 #include "log.h"
@@ -29,8 +40,97 @@ std::string pop_token(std::istream& is)
 }
 
 std::string consume(std::istream& is) { return std::string(std::istreambuf_iterator<char>(is), {}); }
+
+std::string first_token(const std::string& line)
+{
+    std::istringstream iss(line);
+    return pop_token(iss);
 }
 
+int parse_integer(const std::string& value, int fallback)
+{
+    int result = fallback;
+    std::from_chars(value.data(), value.data() + value.size(), result);
+    return result;
+}
+}
+
+// Every line of output goes through here, so that lines written by the search thread and the
+// command thread can't interleave. A line is buffered and written in one go when it goes out of scope
+class UCIWriter {
+public:
+    class Line {
+    public:
+        explicit Line(UCIWriter& writer)
+            : m_writer(writer)
+        {
+        }
+
+        Line(const Line&) = delete;
+        Line(Line&&) = delete;
+        Line& operator=(const Line&) = delete;
+        Line& operator=(Line&&) = delete;
+
+        ~Line() { m_writer.write_line(m_buffer.str()); }
+
+        template <typename T> Line& operator<<(const T& value)
+        {
+            m_buffer << value;
+            return *this;
+        }
+
+    private:
+        UCIWriter& m_writer;
+        std::ostringstream m_buffer;
+    };
+
+    explicit UCIWriter(std::ostream& out)
+        : m_out(out)
+    {
+    }
+
+    Line line() { return Line(*this); }
+
+    void write_line(std::string_view line)
+    {
+        std::lock_guard lock(m_mutex);
+        m_out << line << std::endl;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::ostream& m_out;
+};
+
+// Lines read from the input thread, waiting to be handled by the command thread
+class CommandQueue {
+public:
+    void push(std::string line)
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_lines.push_back(std::move(line));
+        }
+
+        m_condition.notify_one();
+    }
+
+    std::string pop()
+    {
+        std::unique_lock lock(m_mutex);
+        m_condition.wait(lock, [&] { return !m_lines.empty(); });
+
+        auto line = std::move(m_lines.front());
+        m_lines.pop_front();
+        return line;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<std::string> m_lines;
+};
+
 struct UCIMove {
     weechess::Location from;
     weechess::Location to;
@@ -77,32 +177,35 @@ std::ostream& operator<<(std::ostream& os, const UCIMove& move)
 
 class UCISearchDelegate : public weechess::SearchDelegate {
 private:
-    std::ostream& m_out;
+    UCIWriter& m_out;
 
 public:
-    UCISearchDelegate(std::ostream& out)
+    UCISearchDelegate(UCIWriter& out)
         : m_out(out)
     {
     }
 
     void on_evaluation_event(const weechess::EvaluationEvent& event) override
     {
-        m_out << "info score cp " << event.evaluation.score;
-        m_out << " pv";
-        for (const auto& move : event.best_line) {
-            m_out << ' ' << UCIMove::from_move(move);
+        auto line = m_out.line();
+        if (event.evaluation.is_mate()) {
+            line << "info score mate " << event.evaluation.moves_until_mate();
+        } else {
+            line << "info score cp " << event.evaluation.score;
         }
 
-        m_out << std::endl;
+        line << " pv";
+        for (const auto& move : event.best_line) {
+            line << ' ' << UCIMove::from_move(move);
+        }
     }
 
     void on_performance_event(const weechess::PerformanceEvent& event) override
     {
-        m_out << "info nodes " << event.nodes_searched;
-        m_out << " depth " << event.current_depth;
-        m_out << " nps " << event.nodes_per_second;
-        m_out << " time " << event.elapsed_time.count();
-        m_out << std::endl;
+        m_out.line() << "info nodes " << event.nodes_searched << " depth " << event.current_depth << " nps "
+                     << event.nodes_per_second << " time " << event.elapsed_time.count();
+
+        logger::debug("Quiescence nodes: {} of {}", event.quiescence_nodes_searched, event.nodes_searched);
     }
 };
 
@@ -179,46 +282,187 @@ public:
 struct UCI {
     bool in_debug_mode { false };
     weechess::GameState game_state { weechess::GameState::new_game() };
-    weechess::threading::ThreadDispatcher dispatcher {};
+    weechess::Book book { weechess::Book::default_instance };
+    weechess::Book::Selection book_selection {};
+    size_t book_depth { 100 };
+
+    // Polyglot books are consulted before the weechess book. They're keyed by the table from
+    // the specification unless another one is given
+    std::string polyglot_book_path {};
+    std::string polyglot_keys_path {};
+    std::optional<weechess::PolyglotBook> polyglot_book {};
+
+    // Shared by every search, so each one can pick up where the last left off
+    std::string analysis_cache_path {};
+    size_t analysis_cache_size_mb { weechess::AnalysisCache::default_size_in_bytes / (1024 * 1024) };
+    std::shared_ptr<weechess::AnalysisCache> analysis_cache {};
+
+    // Shared by every search of a game, and only made once the first one starts, so that short lived
+    // sessions (a single `bench`, say) don't pay for it
+    size_t hash_size_mb { weechess::TranspositionTable::default_size_in_bytes / (1024 * 1024) };
+    std::shared_ptr<weechess::TranspositionTable> transposition_table {};
+
+    // At most one search runs at a time, on a worker that's reused from one `go` to the next. The
+    // command thread only ever asks it to stop, and only waits for it when a new search is started
+    // or the engine quits, so commands like `isready` are still answered straight away while it's running
+    weechess::threading::ThreadPool search_pool { 1 };
+    std::future<void> search {};
+    weechess::threading::Token search_stop {};
+
+    void stop_search() { search_stop.invalidate(); }
+
+    void wait_for_search()
+    {
+        if (search.valid())
+            search.get();
+    }
+
+    void set_book_file(const std::string& path, UCIWriter& out)
+    {
+        // The embedded book is used whenever there isn't a usable book file
+        book = weechess::Book::default_instance;
+        if (path.empty())
+            return;
+
+        if (auto book_file = weechess::Book::open(path)) {
+            book = *book_file;
+        } else {
+            logger::error("Unable to open book file: {}", path);
+            out.line() << "info string Unable to open book file " << path << ", using the built in book";
+        }
+    }
+
+    void open_analysis_cache(UCIWriter& out)
+    {
+        if (analysis_cache != nullptr && !analysis_cache->flush())
+            logger::error("Unable to write analysis cache");
+
+        analysis_cache.reset();
+        if (analysis_cache_path.empty())
+            return;
+
+        analysis_cache = weechess::AnalysisCache::open(analysis_cache_path, analysis_cache_size_mb * 1024 * 1024);
+        if (analysis_cache == nullptr) {
+            logger::error("Unable to open analysis cache: {}", analysis_cache_path);
+            out.line() << "info string Unable to open analysis cache " << analysis_cache_path;
+        }
+    }
+
+    void open_polyglot_book(UCIWriter& out)
+    {
+        polyglot_book.reset();
+        if (polyglot_book_path.empty())
+            return;
+
+        std::optional<weechess::polyglot::Hasher> hasher { std::in_place };
+        if (!polyglot_keys_path.empty()) {
+            hasher = weechess::polyglot::Hasher::load(polyglot_keys_path);
+            if (!hasher) {
+                logger::error("Unable to load polyglot keys: {}", polyglot_keys_path);
+                out.line() << "info string Unable to load polyglot keys " << polyglot_keys_path;
+                return;
+            }
+        }
+
+        polyglot_book = weechess::PolyglotBook::open(polyglot_book_path, *hasher);
+        if (!polyglot_book) {
+            logger::error("Unable to open polyglot book: {}", polyglot_book_path);
+            out.line() << "info string Unable to open polyglot book " << polyglot_book_path;
+        }
+    }
 
     void loop(std::istream& in, std::ostream& out);
 };
 
 struct UCICommand {
     std::string_view command;
-    std::function<void(UCI&, std::istream&, std::ostream&)> handler;
+    std::function<void(UCI&, std::istream&, UCIWriter&)> handler;
 };
 
 const std::vector<UCICommand> commands = {
     UCICommand { "uci",
-        [](UCI&, std::istream&, std::ostream& out) {
-            out << "id name weechess " << WEECHESS_PROJECT_VERSION << std::endl;
-            out << "id author " WEECHESS_PROJECT_AUTHOR << std::endl;
-            out << "uciok" << std::endl;
+        [](UCI& uci, std::istream&, UCIWriter& out) {
+            out.line() << "id name weechess " << WEECHESS_PROJECT_VERSION;
+            out.line() << "id author " WEECHESS_PROJECT_AUTHOR;
+            out.line() << "option name Hash type spin default " << uci.hash_size_mb << " min 1 max 65536";
+            out.line() << "option name BookFile type string default <empty>";
+            out.line() << "option name PolyglotBook type string default <empty>";
+            out.line() << "option name PolyglotKeys type string default <empty>";
+            out.line() << "option name BookPolicy type combo default Weighted var Weighted var BestScore";
+            out.line() << "option name BookMinCount type spin default 1 min 1 max 1000000";
+            out.line() << "option name BookDepth type spin default 100 min 0 max 1000";
+            out.line() << "option name AnalysisCache type string default <empty>";
+            out.line() << "option name AnalysisCacheSize type spin default " << uci.analysis_cache_size_mb
+                       << " min 1 max 65536";
+            out.line() << "uciok";
         } },
     UCICommand { "debug",
-        [](UCI& uci, std::istream& in, std::ostream& out) {
+        [](UCI& uci, std::istream& in, UCIWriter&) {
             auto token = utils::pop_token(in);
             uci.in_debug_mode = token == "on";
         } },
-    UCICommand { "isready",
-        [](UCI&, std::istream&, std::ostream& out) {
-            out << "readyok" << std::endl;
-            ;
+    UCICommand { "isready", [](UCI&, std::istream&, UCIWriter& out) { out.line() << "readyok"; } },
+    UCICommand { "setoption",
+        [](UCI& uci, std::istream& in, UCIWriter& out) {
+            // Names and values can both be more than one token, so gather everything up to (and after) "value"
+            std::string name;
+            std::string value;
+            std::string* current = nullptr;
+            for (std::string token; in >> token;) {
+                if (token == "name" && current == nullptr) {
+                    current = &name;
+                } else if (token == "value" && current == &name) {
+                    current = &value;
+                } else if (current != nullptr) {
+                    *current += current->empty() ? token : " " + token;
+                }
+            }
+
+            if (value == "<empty>")
+                value.clear();
+
+            if (name == "Hash") {
+                uci.hash_size_mb = static_cast<size_t>(std::clamp(utils::parse_integer(value, 64), 1, 65536));
+                uci.transposition_table.reset();
+            } else if (name == "BookFile") {
+                uci.set_book_file(value, out);
+            } else if (name == "PolyglotBook") {
+                uci.polyglot_book_path = value;
+                uci.open_polyglot_book(out);
+            } else if (name == "PolyglotKeys") {
+                uci.polyglot_keys_path = value;
+                uci.open_polyglot_book(out);
+            } else if (name == "BookPolicy") {
+                uci.book_selection.policy
+                    = value == "BestScore" ? weechess::Book::Policy::BestScore : weechess::Book::Policy::Weighted;
+            } else if (name == "BookMinCount") {
+                auto min_count = std::clamp(utils::parse_integer(value, 1), 1, 1000000);
+                uci.book_selection.min_count = static_cast<uint32_t>(min_count);
+            } else if (name == "BookDepth") {
+                uci.book_depth = static_cast<size_t>(std::clamp(utils::parse_integer(value, 100), 0, 1000));
+            } else if (name == "AnalysisCache") {
+                uci.analysis_cache_path = value;
+                uci.open_analysis_cache(out);
+            } else if (name == "AnalysisCacheSize") {
+                uci.analysis_cache_size_mb = static_cast<size_t>(std::clamp(utils::parse_integer(value, 64), 1, 65536));
+                uci.open_analysis_cache(out);
+            } else {
+                logger::warn("Unsupported option: {}", name);
+            }
         } },
     UCICommand { "position",
-        [](UCI& uci, std::istream& in, std::ostream& out) {
+        [](UCI& uci, std::istream& in, UCIWriter&) {
             auto first_token = utils::pop_token(in);
             if (first_token != "startpos") {
-                // Fen string
-                std::string fen = first_token;
+                // Fen string, which should come after "fen" but is also accepted on its own
+                std::string fen = first_token == "fen" ? "" : first_token;
                 for (;;) {
                     auto token = utils::pop_token(in);
                     if (token == "moves" || token.empty()) {
                         break;
                     }
 
-                    fen += " " + token;
+                    fen += fen.empty() ? token : " " + token;
                 }
 
                 if (auto new_gs = weechess::GameState::from_fen(fen)) {
@@ -254,68 +498,160 @@ const std::vector<UCICommand> commands = {
             logger::debug("Position set to: {}", uci.game_state.to_fen());
         } },
     UCICommand { "go",
-        [](UCI& uci, std::istream& in, std::ostream& out) {
+        [](UCI& uci, std::istream& in, UCIWriter& out) {
             weechess::SearchParameters parameters;
+            weechess::ColorMap<std::optional<size_t>> time_remaining {};
+            weechess::ColorMap<size_t> increment { 0, 0 };
+            std::optional<size_t> moves_to_go;
+            bool has_fixed_time = false;
 
             {
                 std::string token;
                 while (in >> token) {
-                    if (token == "depth") {
+                    if (token == "wtime" || token == "btime") {
+                        size_t time;
+                        if (in >> time)
+                            time_remaining[token == "wtime" ? weechess::Color::White : weechess::Color::Black] = time;
+                    } else if (token == "winc" || token == "binc") {
+                        in >> increment[token == "winc" ? weechess::Color::White : weechess::Color::Black];
+                    } else if (token == "movestogo") {
+                        size_t moves;
+                        if (in >> moves)
+                            moves_to_go = moves;
+                    } else if (token == "depth") {
                         in >> parameters.max_depth;
                     } else if (token == "nodes") {
                         in >> parameters.max_nodes;
                     } else if (token == "infinite") {
                         parameters.max_search_time = {};
+                        has_fixed_time = true;
                     } else if (token == "movetime") {
                         size_t time;
                         in >> time;
                         if (time > 0) {
                             parameters.max_search_time = std::chrono::milliseconds(time);
+                            has_fixed_time = true;
                         }
                     }
                 }
             }
 
-            uci.dispatcher.dispatch([&out, parameters, gs = uci.game_state](auto token) {
+            // Playing on a clock, so the time for this move comes out of what's left of it
+            auto turn_to_move = uci.game_state.turn_to_move();
+            if (!has_fixed_time && time_remaining[turn_to_move].has_value()) {
+                using Milliseconds = std::chrono::duration<size_t, std::milli>;
+                parameters.max_search_time = weechess::time_for_move(
+                    Milliseconds(*time_remaining[turn_to_move]), Milliseconds(increment[turn_to_move]), moves_to_go);
+            }
+
+            // GUIs shouldn't send `go` while a search is running, but don't leave two of them writing moves
+            uci.stop_search();
+            uci.wait_for_search();
+            uci.search_stop.reset();
+
+            if (uci.transposition_table == nullptr) {
+                auto size_in_bytes = uci.hash_size_mb * 1024 * 1024;
+                uci.transposition_table = std::make_shared<weechess::TranspositionTable>(size_in_bytes);
+            }
+
+            auto search = [&out, parameters, gs = uci.game_state, book = uci.book, book_selection = uci.book_selection,
+                              book_depth = uci.book_depth, polyglot_book = uci.polyglot_book,
+                              analysis_cache = uci.analysis_cache,
+                              transposition_table = uci.transposition_table](const weechess::threading::Token& stop) {
                 UCISearchDelegate delegate(out);
                 weechess::Engine engine;
-                auto result = engine.calculate(gs, parameters, *token, delegate);
+                engine.settings().book = book;
+                engine.settings().book_selection = book_selection;
+                engine.settings().book_depth = book_depth;
+                engine.settings().polyglot_book = polyglot_book;
+                engine.settings().analysis_cache = analysis_cache;
+                engine.settings().transposition_table = transposition_table;
+                auto result = engine.calculate(gs, parameters, stop, delegate);
 
                 if (result.is_book_move) {
-                    out << "info string Using book move" << std::endl;
+                    out.line() << "info string Using book move";
                 }
 
                 if (result.best_line.size() > 0) {
-                    out << "bestmove " << UCIMove::from_move(result.best_line[0]) << std::endl;
+                    out.line() << "bestmove " << UCIMove::from_move(result.best_line[0]);
                 } else {
-                    out << "bestmove 0000" << std::endl;
+                    out.line() << "bestmove 0000";
                 }
-            });
+            };
+
+            uci.search = uci.search_pool.submit(uci.search_stop, std::move(search));
+        } },
+    UCICommand { "stop", [](UCI& uci, std::istream&, UCIWriter&) { uci.stop_search(); } },
+    UCICommand { "ucinewgame",
+        [](UCI& uci, std::istream&, UCIWriter&) {
+            // Nothing from the last game is worth keeping, and a search left running would be writing to the table
+            uci.stop_search();
+            uci.wait_for_search();
+            if (uci.transposition_table != nullptr)
+                uci.transposition_table->clear();
         } },
-    UCICommand { "stop",
-        [](UCI& uci, std::istream& in, std::ostream& out) {
-            uci.dispatcher.invalidate_all();
-            uci.dispatcher.join_all();
+    UCICommand { "bench",
+        [](UCI& uci, std::istream& in, UCIWriter& out) {
+            // Runs on the command thread rather than the search worker, so nothing else is competing for time
+            uci.stop_search();
+            uci.wait_for_search();
+
+            using weechess::bench::PositionResult;
+
+            auto default_depth = static_cast<int>(weechess::bench::default_depth);
+            auto depth = std::clamp(utils::parse_integer(utils::pop_token(in), default_depth), 1, 64);
+            auto position_count = weechess::bench::positions().size();
+
+            auto report = [&](size_t index, const PositionResult& position) {
+                auto line = out.line();
+                line << "info string bench position " << index + 1 << "/" << position_count << " nodes "
+                     << position.nodes_searched << " time " << position.elapsed_time.count() << " bestmove ";
+
+                if (position.best_move.has_value()) {
+                    line << UCIMove::from_move(*position.best_move);
+                } else {
+                    line << "0000";
+                }
+            };
+
+            auto result = weechess::bench::run(static_cast<size_t>(depth), report);
+
+            out.line() << "Total time (ms) : " << result.elapsed_time.count();
+            out.line() << "Nodes searched  : " << result.nodes_searched;
+            out.line() << "Nodes/second    : " << result.nodes_per_second();
         } },
 };
 
 const std::vector<std::string> ignored_commands = {
-    "ucinewgame",
-    "setoption",
     "register",
 };
 
 void UCI::loop(std::istream& in, std::ostream& out)
 {
-    std::string line;
-    std::string token;
-    while (std::getline(in, line)) {
+    UCIWriter writer(out);
+    CommandQueue queue;
+
+    // Reading is done on its own thread so the command thread never sits blocked on input. Running
+    // out of input is treated the same as being asked to quit
+    std::thread reader([&in, &queue]() {
+        std::string line;
+        while (std::getline(in, line)) {
+            queue.push(line);
+            if (utils::first_token(line) == "quit")
+                return;
+        }
+
+        queue.push("quit");
+    });
+
+    for (;;) {
+        auto line = queue.pop();
         std::istringstream iss(line);
-        iss >> token;
+        auto token = utils::pop_token(iss);
 
         if (token == "quit") {
-            dispatcher.invalidate_all();
-            dispatcher.join_all();
+            stop_search();
+            wait_for_search();
             break;
         }
 
@@ -323,7 +659,11 @@ void UCI::loop(std::istream& in, std::ostream& out)
             commands.begin(), commands.end(), [&](const UCICommand& cmd) { return cmd.command == token; });
 
         if (cmd != commands.end()) {
-            cmd->handler(*this, iss, out);
+            cmd->handler(*this, iss, writer);
+            continue;
+        }
+
+        if (token.empty()) {
             continue;
         }
 
@@ -333,6 +673,8 @@ void UCI::loop(std::istream& in, std::ostream& out)
 
         logger::error("Unsupported command: {}", token);
     }
+
+    reader.join();
 }
 
 int main(int argc, char* argv[])
@@ -341,6 +683,7 @@ int main(int argc, char* argv[])
     argparse::ArgumentParser parser("weechess " UCI_CMD_NAME, UCI_CMD_VERSION, argparse::default_arguments::none);
     parser.add_description(UCI_CMD_DESCRIPTION);
     parser.add_argument("--help").default_value(false).implicit_value(true);
+    parser.add_argument("command").help("A command to run instead of reading from stdin, such as `bench`").remaining();
 
     try {
         parser.parse_args(argc, argv);
@@ -357,5 +700,22 @@ int main(int argc, char* argv[])
 
     std::cerr << "weechess-" UCI_CMD_NAME " v" UCI_CMD_VERSION << " by Ryan Webber..." << std::endl;
 
+    // A command given on the command line is run on its own, and the engine quits once it's done
+    std::vector<std::string> command;
+    try {
+        command = parser.get<std::vector<std::string>>("command");
+    } catch (std::logic_error&) {
+    }
+
+    if (!command.empty()) {
+        std::string line;
+        for (const auto& token : command)
+            line += line.empty() ? token : " " + token;
+
+        std::istringstream in(line + "\nquit\n");
+        UCI().loop(in, std::cout);
+        return 0;
+    }
+
     UCI().loop(std::cin, std::cout);
 }
@@ -3,3 +3,7 @@
 #define UCI_CMD_VERSION WEECHESS_PROJECT_VERSION
 #define UCI_CMD_NAME "uci"
 #define UCI_CMD_DESCRIPTION "Start a weechess UCI server"
+
+// Run from the entrypoint as `weechess bench [depth]`, which passes the command on to the UCI engine
+#define BENCH_CMD_NAME "bench"
+#define BENCH_CMD_DESCRIPTION "Search a fixed set of positions and report the nodes searched and the node rate"
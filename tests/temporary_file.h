@@ -0,0 +1,33 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+// A path in the temporary directory for a test to write to. Whatever is left there is removed when this goes out of
+// scope, even when a failed REQUIRE ends the test early
+class TemporaryFile {
+public:
+    explicit TemporaryFile(std::string_view name)
+        : m_path(std::filesystem::temp_directory_path() / ("weechess-" + std::string(name)))
+    {
+        // Left over from a run that crashed
+        std::error_code error;
+        std::filesystem::remove(m_path, error);
+    }
+
+    TemporaryFile(const TemporaryFile&) = delete;
+    TemporaryFile& operator=(const TemporaryFile&) = delete;
+
+    ~TemporaryFile()
+    {
+        std::error_code error;
+        std::filesystem::remove(m_path, error);
+    }
+
+    const std::filesystem::path& path() const { return m_path; }
+
+private:
+    std::filesystem::path m_path;
+};
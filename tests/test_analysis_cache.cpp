@@ -0,0 +1,316 @@
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <weechess/analysis_cache.h>
+#include <weechess/game_state.h>
+#include <weechess/move_query.h>
+#include <weechess/searcher.h>
+
+#include "temporary_file.h"
+
+namespace {
+
+struct Position {
+    weechess::GameSnapshot snapshot;
+    weechess::Move move;
+};
+
+// Positions after white's first move, each with a legal move to store alongside it
+std::vector<Position> some_positions()
+{
+    using namespace weechess;
+
+    std::vector<Position> positions;
+    auto initial = GameState::new_game();
+    for (const auto& first : initial.move_set().legal_moves()) {
+        GameState state(first.snapshot());
+        positions.push_back({ state.snapshot(), state.move_set().legal_moves()[0].move() });
+    }
+
+    return positions;
+}
+}
+
+TEST_CASE("Analysis caches survive being reopened", "[analysis_cache]")
+{
+    using namespace weechess;
+
+    TemporaryFile file("reopen.cache");
+    const auto& path = file.path();
+    auto positions = some_positions();
+    const auto& position = positions[0];
+    auto snapshot = position.snapshot;
+
+    {
+        auto cache = AnalysisCache::open(path);
+        REQUIRE(cache != nullptr);
+        CHECK(cache->size() == 0);
+
+        cache->insert(snapshot, TranspositionEntry::Type::Exact, position.move, 12, Evaluation::mate_in(7), 3);
+        cache->insert(positions[1].snapshot, TranspositionEntry::Type::LowerBound, positions[1].move, 8,
+            Evaluation { 40 }, 2);
+        REQUIRE(cache->flush());
+    }
+
+    auto cache = AnalysisCache::open(path);
+    REQUIRE(cache != nullptr);
+    CHECK(cache->size() == 2);
+
+    // Mate scores are relative to the position, so they come back relative to whichever ply it's found at
+    auto entry = cache->find(snapshot, 1);
+    REQUIRE(entry.has_value());
+    CHECK(entry->move.decode(snapshot) == position.move);
+    CHECK(entry->depth == 12);
+    CHECK(entry->type == TranspositionEntry::Type::Exact);
+    CHECK(entry->evaluation() == Evaluation::mate_in(5));
+
+    entry = cache->find(positions[1].snapshot, 2);
+    REQUIRE(entry.has_value());
+    CHECK(entry->type == TranspositionEntry::Type::LowerBound);
+    CHECK(entry->evaluation() == Evaluation { 40 });
+
+    CHECK_FALSE(cache->find(GameSnapshot::initial_position(), 0).has_value());
+}
+
+TEST_CASE("Analysis caches keep the deepest results", "[analysis_cache]")
+{
+    using namespace weechess;
+
+    TemporaryFile file("depth.cache");
+    const auto& path = file.path();
+    auto positions = some_positions();
+    auto snapshot = positions[0].snapshot;
+    auto move = positions[0].move;
+
+    {
+        auto cache = AnalysisCache::open(path);
+        REQUIRE(cache != nullptr);
+
+        cache->insert(snapshot, TranspositionEntry::Type::Exact, move, 10, Evaluation { 10 }, 0);
+        cache->insert(snapshot, TranspositionEntry::Type::Exact, move, 6, Evaluation { 20 }, 0);
+        CHECK(cache->find(snapshot, 0)->evaluation() == Evaluation { 10 });
+
+        cache->insert(snapshot, TranspositionEntry::Type::Exact, move, 14, Evaluation { 30 }, 0);
+        CHECK(cache->find(snapshot, 0)->evaluation() == Evaluation { 30 });
+        REQUIRE(cache->flush());
+    }
+
+    // Once there are more positions than fit, the shallowest go first, in memory and in the file
+    constexpr size_t capacity = 8;
+    {
+        auto cache = AnalysisCache::open(path, capacity * 24);
+        REQUIRE(cache != nullptr);
+        REQUIRE(cache->capacity() == capacity);
+
+        for (size_t i = 1; i < positions.size(); i++) {
+            cache->insert(positions[i].snapshot, TranspositionEntry::Type::Exact, positions[i].move, i % 5,
+                Evaluation { 0 }, 0);
+            CHECK(cache->size() <= capacity + capacity / 4);
+        }
+
+        REQUIRE(cache->compact());
+        CHECK(std::filesystem::file_size(path) <= 24 * (1 + capacity + capacity / 4));
+    }
+
+    auto cache = AnalysisCache::open(path, capacity * 24);
+    REQUIRE(cache != nullptr);
+    CHECK(cache->size() <= capacity);
+    CHECK(cache->find(snapshot, 0)->depth == 14);
+}
+
+TEST_CASE("Analysis caches combine the table with newer results", "[analysis_cache]")
+{
+    using namespace weechess;
+
+    TemporaryFile file("table.cache");
+    const auto& path = file.path();
+    auto positions = some_positions();
+
+    {
+        auto cache = AnalysisCache::open(path);
+        REQUIRE(cache != nullptr);
+        for (size_t i = 0; i < 10; i++)
+            cache->insert(positions[i].snapshot, TranspositionEntry::Type::Exact, positions[i].move, 6,
+                Evaluation { 0 }, 0);
+        REQUIRE(cache->compact());
+    }
+
+    // Newer results go after the table, whether they're deeper results for positions in it or new positions
+    {
+        auto cache = AnalysisCache::open(path);
+        REQUIRE(cache != nullptr);
+        CHECK(cache->size() == 10);
+
+        cache->insert(positions[0].snapshot, TranspositionEntry::Type::Exact, positions[0].move, 4,
+            Evaluation { 0 }, 0);
+        cache->insert(positions[1].snapshot, TranspositionEntry::Type::Exact, positions[1].move, 9,
+            Evaluation { 0 }, 0);
+        cache->insert(positions[10].snapshot, TranspositionEntry::Type::Exact, positions[10].move, 3,
+            Evaluation { 0 }, 0);
+        REQUIRE(cache->flush());
+        CHECK(std::filesystem::file_size(path) == 24 * (1 + 10 + 2));
+    }
+
+    auto cache = AnalysisCache::open(path);
+    REQUIRE(cache != nullptr);
+    CHECK(cache->size() == 11);
+    CHECK(cache->find(positions[0].snapshot, 0)->depth == 6);
+    CHECK(cache->find(positions[1].snapshot, 0)->depth == 9);
+    CHECK(cache->find(positions[2].snapshot, 0)->depth == 6);
+    CHECK(cache->find(positions[10].snapshot, 0)->depth == 3);
+
+    // Merging them keeps the newer results
+    REQUIRE(cache->compact());
+    CHECK(std::filesystem::file_size(path) == 24 * (1 + 11));
+    CHECK(cache->find(positions[1].snapshot, 0)->depth == 9);
+}
+
+TEST_CASE("Analysis caches recover from interrupted writes", "[analysis_cache]")
+{
+    using namespace weechess;
+
+    TemporaryFile file("interrupted.cache");
+    const auto& path = file.path();
+    auto positions = some_positions();
+
+    {
+        auto cache = AnalysisCache::open(path);
+        REQUIRE(cache != nullptr);
+        for (size_t i = 0; i < 4; i++)
+            cache->insert(positions[i].snapshot, TranspositionEntry::Type::Exact, positions[i].move, 5,
+                Evaluation { 0 }, 0);
+        REQUIRE(cache->flush());
+    }
+
+    // Half of a fifth record, as if the engine died while writing it
+    auto intact_size = std::filesystem::file_size(path);
+    {
+        std::ofstream stream(path, std::ios::binary | std::ios::app);
+        stream << "half a record";
+    }
+
+    {
+        auto cache = AnalysisCache::open(path);
+        REQUIRE(cache != nullptr);
+        CHECK(cache->size() == 4);
+        CHECK(std::filesystem::file_size(path) == intact_size);
+
+        // New results go after the last intact one, where they can be read back
+        cache->insert(positions[4].snapshot, TranspositionEntry::Type::Exact, positions[4].move, 5,
+            Evaluation { 0 }, 0);
+        REQUIRE(cache->flush());
+    }
+
+    auto cache = AnalysisCache::open(path);
+    REQUIRE(cache != nullptr);
+    CHECK(cache->size() == 5);
+
+    // Files that aren't caches are left alone
+    TemporaryFile other_file("not-a-cache.cache");
+    const auto& other_path = other_file.path();
+    {
+        std::ofstream stream(other_path, std::ios::binary);
+        stream << "This is not an analysis cache";
+    }
+    CHECK(AnalysisCache::open(other_path) == nullptr);
+    CHECK(std::filesystem::file_size(other_path) > 0);
+}
+
+TEST_CASE("Analysis caches drop a zero filled tail", "[analysis_cache]")
+{
+    using namespace weechess;
+
+    TemporaryFile file("zero-tail.cache");
+    const auto& path = file.path();
+    auto positions = some_positions();
+
+    {
+        auto cache = AnalysisCache::open(path);
+        REQUIRE(cache != nullptr);
+        cache->insert(
+            positions[0].snapshot, TranspositionEntry::Type::Exact, positions[0].move, 5, Evaluation { 0 }, 0);
+        REQUIRE(cache->flush());
+    }
+
+    // A record's worth of zeroes, as if the file grew but the engine died before writing to it
+    auto intact_size = std::filesystem::file_size(path);
+    {
+        std::ofstream stream(path, std::ios::binary | std::ios::app);
+        const std::array<char, 24> zeroes {};
+        stream.write(zeroes.data(), zeroes.size());
+    }
+
+    auto cache = AnalysisCache::open(path);
+    REQUIRE(cache != nullptr);
+    CHECK(cache->size() == 1);
+    CHECK(std::filesystem::file_size(path) == intact_size);
+}
+
+TEST_CASE("Searches start from cached analysis", "[analysis_cache][search]")
+{
+    using namespace weechess;
+
+    TemporaryFile file("search.cache");
+    const auto& path = file.path();
+    auto game_state = GameState::from_fen("r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3").value();
+    constexpr size_t depth = 5;
+
+    auto search = [&](std::shared_ptr<AnalysisCache> cache) {
+        Searcher searcher({}, std::move(cache));
+        std::optional<SearchProgress> result;
+        searcher.search(game_state, depth, [&](const SearchProgress& progress, SearchControl&) { result = progress; });
+        REQUIRE(result.has_value());
+        return *result;
+    };
+
+    auto uncached = search(nullptr);
+    {
+        auto cache = std::shared_ptr<AnalysisCache>(AnalysisCache::open(path));
+        REQUIRE(cache != nullptr);
+        auto first_run = search(cache);
+        CHECK(first_run.best_line().front() == uncached.best_line().front());
+        REQUIRE(cache->flush());
+    }
+
+    // A later run, with the analysis read back from the file, does a fraction of the work
+    auto cache = std::shared_ptr<AnalysisCache>(AnalysisCache::open(path));
+    REQUIRE(cache != nullptr);
+    auto second_run = search(cache);
+    CHECK(second_run.best_line().front() == uncached.best_line().front());
+    CHECK(second_run.evaluation() == uncached.evaluation());
+    CHECK(second_run.nodes_searched() * 4 < uncached.nodes_searched());
+}
+
+TEST_CASE("Searches play their own move over a deeper cached bound", "[analysis_cache][search]")
+{
+    using namespace weechess;
+
+    TemporaryFile file("bound.cache");
+    auto game_state = GameState::from_fen("r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3").value();
+    constexpr size_t depth = 4;
+
+    auto best_move = [&](std::shared_ptr<AnalysisCache> cache) {
+        std::vector<Move> best_line;
+        Searcher({}, std::move(cache)).search(game_state, depth, [&](const SearchProgress& progress, SearchControl&) {
+            best_line = progress.best_line();
+        });
+
+        REQUIRE_FALSE(best_line.empty());
+        return best_line.front();
+    };
+
+    // An upper bound says no move raised alpha, so the move stored with it is just the first one tried
+    auto weak_move = game_state.move_set().find_first(LocationMoveQuery(Location::A2, Location::A3)).value().move();
+
+    auto cache = std::shared_ptr<AnalysisCache>(AnalysisCache::open(file.path()));
+    REQUIRE(cache != nullptr);
+    cache->insert(game_state.snapshot(), AnalysisCache::Value::Type::UpperBound, weak_move, 20, Evaluation::zero(), 0);
+
+    auto cached = best_move(cache);
+    CHECK(cached != weak_move);
+    CHECK(cached == best_move(nullptr));
+}
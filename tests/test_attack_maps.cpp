@@ -0,0 +1,106 @@
+#include <array>
+#include <random>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <weechess/attack_maps.h>
+
+namespace {
+
+using namespace weechess;
+
+constexpr std::array<attack_maps::SliderBackend, 2> backends = {
+    attack_maps::SliderBackend::Magic,
+    attack_maps::SliderBackend::Pext,
+};
+
+BitBoard walk_rays(Location origin, BitBoard blockers, std::span<const std::pair<int, int>> directions)
+{
+    BitBoard attacks;
+    for (const auto& [file_step, rank_step] : directions) {
+        int file = origin.file() + file_step;
+        int rank = origin.rank() + rank_step;
+        while (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+            auto location = Location::from_rank_and_file(rank, file);
+            attacks.set(location);
+            if (blockers[location])
+                break;
+
+            file += file_step;
+            rank += rank_step;
+        }
+    }
+
+    return attacks;
+}
+
+std::vector<BitBoard> random_blockers(size_t count)
+{
+    std::mt19937_64 rng(0x5eed);
+    std::vector<BitBoard> blockers;
+    for (size_t i = 0; i < count; i++) {
+        // Sparse boards look more like real positions than uniformly random ones
+        blockers.emplace_back(rng() & rng());
+    }
+
+    return blockers;
+}
+
+}
+
+TEST_CASE("Slider attacks match a ray walk for every backend", "[attack_maps]")
+{
+    constexpr std::array<std::pair<int, int>, 4> rook_directions = { { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } } };
+    constexpr std::array<std::pair<int, int>, 4> bishop_directions
+        = { { { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } } };
+
+    auto initial_backend = attack_maps::slider_backend();
+    auto blockers = random_blockers(256);
+
+    for (const auto& backend : backends) {
+        if (!attack_maps::set_slider_backend(backend))
+            continue;
+
+        for (uint8_t i = 0; i < 64; i++) {
+            Location origin(i);
+            for (const auto& bb : blockers) {
+                CHECK(attack_maps::generate_rook_attacks(origin, bb) == walk_rays(origin, bb, rook_directions));
+                CHECK(attack_maps::generate_bishop_attacks(origin, bb) == walk_rays(origin, bb, bishop_directions));
+            }
+        }
+    }
+
+    attack_maps::set_slider_backend(initial_backend);
+    CHECK(attack_maps::slider_backend() == initial_backend);
+}
+
+TEST_CASE("Slider attack backend benchmarks", "[.][benchmark]")
+{
+    auto initial_backend = attack_maps::slider_backend();
+    auto blockers = random_blockers(64);
+
+    for (const auto& backend : backends) {
+        if (!attack_maps::set_slider_backend(backend))
+            continue;
+
+        // 8192 lookups per run (64 squares x 64 boards x rook and bishop)
+        BENCHMARK(backend == attack_maps::SliderBackend::Magic ? "Magic slider lookups" : "Pext slider lookups")
+        {
+            BitBoard result;
+            for (uint8_t i = 0; i < 64; i++) {
+                for (const auto& bb : blockers) {
+                    result |= attack_maps::generate_rook_attacks(Location(i), bb);
+                    result |= attack_maps::generate_bishop_attacks(Location(i), bb);
+                }
+            }
+
+            return result;
+        };
+    }
+
+    attack_maps::set_slider_backend(initial_backend);
+}
@@ -1,4 +1,5 @@
 #include <array>
+#include <string_view>
 
 #include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
@@ -92,3 +93,99 @@ TEST_CASE("Stalemate detection")
     auto game_state = weechess::GameState::from_fen("7k/Q7/8/8/8/8/8/5KR1 b - - 0 1").value();
     CHECK(game_state.is_stalemate());
 }
+
+TEST_CASE("Board piece lookup stays in sync with occupancy")
+{
+    using namespace weechess;
+
+    // Between them, these cover castling, en passant and promotions
+    std::array<std::string_view, 2> fens = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/Pp2P3/2N2Q1p/1PPBBPPP/R3K2R b KQkq a3 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    };
+
+    for (const auto& fen : fens) {
+        auto game_state = GameState::from_fen(fen).value();
+        for (const auto& legal_move : game_state.move_set().legal_moves()) {
+            const auto& board = legal_move.snapshot().board;
+            for (uint8_t i = 0; i < Board::cell_count; i++) {
+                auto location = Location(i);
+                auto expected_piece = Piece::none();
+                for (const auto& piece : Piece::all_valid_pieces) {
+                    if (board.occupancy_for(piece)[location])
+                        expected_piece = piece;
+                }
+
+                CHECK(board.piece_at(location) == expected_piece);
+            }
+        }
+    }
+}
+
+TEST_CASE("Incremental attack tables match a full rebuild")
+{
+    using namespace weechess;
+
+    std::array<std::string_view, 3> fens = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/Pp2P3/2N2Q1p/1PPBBPPP/R3K2R b KQkq a3 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    };
+
+    for (const auto& fen : fens) {
+        auto game_state = GameState::from_fen(fen).value();
+        auto table = AttackTable(game_state.board());
+        for (const auto& legal_move : game_state.move_set().legal_moves()) {
+            const auto& move = legal_move.move();
+            const auto& board = legal_move.snapshot().board;
+
+            auto changed = BitBoard::from(std::array<Location, 2> { move.start_location(), move.end_location() });
+            changed |= game_state.board().shared_occupancy() & ~board.shared_occupancy();
+            changed |= board.shared_occupancy() & ~game_state.board().shared_occupancy();
+
+            auto updated = table.updated(board, changed);
+            auto rebuilt = AttackTable(board);
+            for (const auto& color : { Color::White, Color::Black }) {
+                CHECK(updated.attacks(color) == rebuilt.attacks(color));
+                CHECK(updated.pawn_attacks(color) == rebuilt.pawn_attacks(color));
+                CHECK((updated.attacks(color) & ~board.color_occupancy()[color]) == board.attacks(color));
+            }
+        }
+    }
+}
+
+TEST_CASE("Attack map benchmarks", "[.][benchmark]")
+{
+    using namespace weechess;
+
+    auto game_state
+        = GameState::from_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1pP1P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1").value();
+    auto table = AttackTable(game_state.board());
+    auto legal_moves = game_state.move_set().legal_moves();
+
+    BENCHMARK("Lazy rebuild")
+    {
+        BitBoard attacks;
+        for (const auto& legal_move : legal_moves) {
+            auto board = Board(legal_move.snapshot().board.piece_buffer());
+            attacks |= board.attacks(Color::White);
+        }
+
+        return attacks;
+    };
+
+    BENCHMARK("Incremental update")
+    {
+        BitBoard attacks;
+        for (const auto& legal_move : legal_moves) {
+            const auto& board = legal_move.snapshot().board;
+            auto changed = game_state.board().shared_occupancy() & ~board.shared_occupancy();
+            changed |= board.shared_occupancy() & ~game_state.board().shared_occupancy();
+            changed.set(legal_move->start_location());
+            changed.set(legal_move->end_location());
+            attacks |= table.updated(board, changed).attacks(Color::White);
+        }
+
+        return attacks;
+    };
+}
@@ -1,7 +1,16 @@
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
 
 #include <weechess/book.h>
 
+#include "temporary_file.h"
+
 TEST_CASE("Searching position in a book", "[search]")
 {
     using namespace weechess;
@@ -12,5 +21,127 @@ TEST_CASE("Searching position in a book", "[search]")
 
     auto moves = Book::default_instance.lookup(hash);
     REQUIRE(moves.size() == expected_move_count);
-    REQUIRE(moves[0] == Move(Move::Data(268447058UL)));
+    REQUIRE(std::find_if(moves.begin(), moves.end(),
+                [](const auto& entry) { return entry.move == CompactMove(Move(Move::Data(268447058UL))); })
+        != moves.end());
+
+    // Most played first
+    REQUIRE(std::is_sorted(
+        moves.begin(), moves.end(), [](const auto& lhs, const auto& rhs) { return lhs.count > rhs.count; }));
+}
+
+TEST_CASE("Book moves are selected by how they were played", "[book]")
+{
+    using namespace weechess;
+
+    auto game_state = GameState::new_game();
+    auto snapshot = game_state.snapshot();
+    auto legal_moves = game_state.move_set().legal_moves();
+    REQUIRE(legal_moves.size() >= 3);
+
+    auto popular = legal_moves[0].move();
+    auto rare = legal_moves[1].move();
+    auto lucky = legal_moves[2].move();
+
+    const std::array<Book::Entry, 1> entries = { { { snapshot.zobrist_hash(), 0, 3 } } };
+    const std::array<Book::MoveEntry, 3> moves = { {
+        { CompactMove(popular), 2700, 30, 12, 14, 4 },
+        { CompactMove(rare), 2500, 10, 2, 4, 4 },
+        { CompactMove(lucky), 2400, 1, 1, 0, 0 },
+    } };
+
+    Book book({ entries, moves });
+    std::default_random_engine random_engine(0);
+
+    // Weighted by play count
+    size_t popular_count = 0;
+    constexpr size_t samples = 4100;
+    for (size_t i = 0; i < samples; i++)
+        popular_count += book.select(snapshot, {}, random_engine) == popular;
+
+    CHECK(popular_count > samples * 70 / 100);
+    CHECK(popular_count < samples * 76 / 100);
+
+    // Moves below the minimum count are never picked
+    Book::Selection selection { .policy = Book::Policy::Weighted, .min_count = 2 };
+    for (size_t i = 0; i < 100; i++)
+        CHECK(book.select(snapshot, selection, random_engine) != lucky);
+
+    selection.min_count = 100;
+    CHECK_FALSE(book.select(snapshot, selection, random_engine).has_value());
+
+    // A single win is promising, but not as convincing as scoring 63% over thirty games
+    selection = { .policy = Book::Policy::BestScore, .min_count = 1 };
+    CHECK(book.select(snapshot, selection, random_engine) == popular);
+    CHECK(moves[0].score(Color::White) > moves[2].score(Color::White));
+    CHECK(moves[1].score(Color::Black) > moves[1].score(Color::White));
+    CHECK(moves[0].score(Color::White) < 0.633);
+}
+
+TEST_CASE("Book files can be saved and opened", "[book]")
+{
+    using namespace weechess;
+
+    TemporaryFile file("round-trip.book");
+    const auto& path = file.path();
+    REQUIRE(Book::default_instance.save(path));
+
+    auto book = Book::open(path);
+    REQUIRE(book.has_value());
+    REQUIRE(book->data().entries.size() == Book::default_instance.data().entries.size());
+    REQUIRE(book->data().moves.size() == Book::default_instance.data().moves.size());
+
+    for (const auto& entry : Book::default_instance.data().entries) {
+        auto expected = Book::default_instance.lookup(entry.hash);
+        auto actual = book->lookup(entry.hash);
+        REQUIRE(std::equal(expected.begin(), expected.end(), actual.begin(), actual.end()));
+    }
+
+    auto snapshot = GameSnapshot::initial_position();
+    CHECK(book->lookup(snapshot) == Book::default_instance.lookup(snapshot));
+
+    // Copies share the mapping, which has to outlive the book that opened it
+    auto copy = *book;
+    book.reset();
+    CHECK(copy.lookup(snapshot).size() > 0);
+}
+
+TEST_CASE("Files that aren't books are rejected", "[book]")
+{
+    using namespace weechess;
+
+    CHECK_FALSE(Book::open(TemporaryFile("missing.book").path()).has_value());
+
+    TemporaryFile file("invalid.book");
+    const auto& path = file.path();
+    {
+        std::ofstream stream(path, std::ios::binary);
+        stream << "This is not a book";
+    }
+    CHECK_FALSE(Book::open(path).has_value());
+
+    // A valid book with its last move cut off
+    REQUIRE(Book::default_instance.save(path));
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    CHECK_FALSE(Book::open(path).has_value());
+}
+
+TEST_CASE("Book benchmarks", "[.][benchmark]")
+{
+    using namespace weechess;
+
+    TemporaryFile file("benchmark.book");
+    const auto& path = file.path();
+    REQUIRE(Book::default_instance.save(path));
+
+    auto book = Book::open(path).value();
+    auto snapshot = GameSnapshot::initial_position();
+    auto hash = snapshot.zobrist_hash();
+
+    // The embedded book costs nothing to open, but it's part of every build of the engine
+    BENCHMARK("Open a book file") { return Book::open(path); };
+    BENCHMARK("Look up a hash in the embedded book") { return Book::default_instance.lookup(hash).size(); };
+    BENCHMARK("Look up a hash in a book file") { return book.lookup(hash).size(); };
+    BENCHMARK("Look up a position in the embedded book") { return Book::default_instance.lookup(snapshot); };
+    BENCHMARK("Look up a position in a book file") { return book.lookup(snapshot); };
 }
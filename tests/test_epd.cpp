@@ -0,0 +1,88 @@
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <weechess/epd.h>
+
+TEST_CASE("EPD records are parsed into a position and operations", "[epd]")
+{
+    using namespace weechess;
+
+    // WAC.001, with an avoid move added
+    constexpr std::string_view line
+        = R"(2rr3k/pp3pp1/1nnqbN1p/3pN3/2pP4/2P3Q1/PPB4P/R4RK1 w - - bm Qg6; am Qh4; id "WAC.001";)";
+
+    auto record = epd::from_epd(line);
+    REQUIRE(record.has_value());
+    CHECK(record->snapshot.to_fen() == "2rr3k/pp3pp1/1nnqbN1p/3pN3/2pP4/2P3Q1/PPB4P/R4RK1 w - - 0 1");
+    CHECK(record->operations.size() == 3);
+    CHECK(record->id() == "WAC.001");
+
+    auto best_moves = record->moves("bm");
+    REQUIRE(best_moves.has_value());
+    REQUIRE(best_moves->size() == 1);
+    CHECK((*best_moves)[0].start_location() == Location::G3);
+    CHECK((*best_moves)[0].end_location() == Location::G6);
+
+    auto avoid_moves = record->moves("am");
+    REQUIRE(avoid_moves.has_value());
+    REQUIRE(avoid_moves->size() == 1);
+    CHECK((*avoid_moves)[0].end_location() == Location::H4);
+
+    CHECK_FALSE(record->moves("pv").has_value());
+}
+
+TEST_CASE("EPD operations can have several operands and clocks", "[epd]")
+{
+    using namespace weechess;
+
+    SECTION("Several best moves, annotated")
+    {
+        auto record = epd::from_epd("4k3/8/8/8/8/8/8/R3K2R w KQ - bm O-O Rh8+!; c0 \"two; ways\";");
+        REQUIRE(record.has_value());
+        CHECK(record->find("c0")->operands == std::vector<std::string> { "two; ways" });
+
+        auto best_moves = record->moves("bm");
+        REQUIRE(best_moves.has_value());
+        REQUIRE(best_moves->size() == 2);
+        CHECK((*best_moves)[0].is_castle());
+        CHECK((*best_moves)[1].end_location() == Location::H8);
+    }
+
+    SECTION("Clocks from operations")
+    {
+        auto record = epd::from_epd("4k3/8/8/8/8/8/8/4K3 b - - hmvc 12; fmvn 40;");
+        REQUIRE(record.has_value());
+        CHECK(record->snapshot.halfmove_clock == 12);
+        CHECK(record->snapshot.fullmove_number == 40);
+    }
+
+    SECTION("Clocks from a whole FEN, and a missing final semicolon")
+    {
+        auto record = epd::from_epd("4k3/8/8/8/8/8/8/4K3 b - - 3 17 bm Kd7");
+        REQUIRE(record.has_value());
+        CHECK(record->snapshot.halfmove_clock == 3);
+        CHECK(record->snapshot.fullmove_number == 17);
+        CHECK(record->moves("bm").has_value());
+    }
+}
+
+TEST_CASE("Bad EPD records are rejected with a reason", "[epd]")
+{
+    using namespace weechess;
+
+    epd::ParseError error;
+    CHECK_FALSE(epd::from_epd("4k3/8/8/8/8/8/8/4K3 w", &error).has_value());
+    CHECK_FALSE(error.reason.empty());
+
+    CHECK_FALSE(epd::from_epd("4k3/8/8/8/8/8/8/4K3 w - - id \"unterminated;", &error).has_value());
+    CHECK(error.position == 29);
+
+    CHECK_FALSE(epd::from_epd("4k3/8/8/8/8/8/8/4K3 w - - hmvc x;", &error).has_value());
+
+    auto record = epd::from_epd("4k3/8/8/8/8/8/8/4K3 w - - bm Qh5;");
+    REQUIRE(record.has_value());
+    CHECK_FALSE(record->moves("bm").has_value());
+}
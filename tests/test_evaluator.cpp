@@ -1,3 +1,4 @@
+#include <array>
 #include <span>
 
 #include <catch2/benchmark/catch_benchmark.hpp>
@@ -13,3 +14,31 @@ TEST_CASE("Game state evaluation")
     auto evaluation = Evaluator::default_instance.evaluate(game_state);
     CHECK(evaluation.score > 1400);
 }
+
+TEST_CASE("Batch evaluation matches single evaluation")
+{
+    using namespace weechess;
+    std::array<GameSnapshot, 3> snapshots = {
+        GameSnapshot::initial_position(),
+        GameSnapshot::from_fen("2kq3n/7p/7p/7p/8/8/8/2K5 b - - 0 8").value(),
+        GameSnapshot::from_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1").value(),
+    };
+
+    std::array<Evaluation, 3> evaluations {};
+    Evaluator::default_instance.evaluate(snapshots, evaluations);
+
+    for (size_t i = 0; i < snapshots.size(); i++) {
+        CHECK(evaluations[i] == Evaluator::default_instance.evaluate(GameState(snapshots[i])));
+    }
+}
+
+TEST_CASE("Evaluation with custom weights")
+{
+    using namespace weechess;
+    auto weights = Evaluator::default_instance.weights();
+    weights.material[static_cast<int>(Piece::Type::Queen)] += 100;
+
+    auto snapshot = GameSnapshot::from_fen("2kq3n/7p/7p/7p/8/8/8/2K5 b - - 0 8").value();
+    auto evaluation = Evaluator(weights).evaluate(snapshot);
+    CHECK(evaluation.score == Evaluator::default_instance.evaluate(snapshot).score + 100);
+}
@@ -1,5 +1,12 @@
+#include <array>
+#include <chrono>
+#include <string_view>
+#include <utility>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
 
+#include <weechess/fen.h>
 #include <weechess/game_state.h>
 
 TEST_CASE("Basic fen string parsing", "[fen]")
@@ -15,3 +22,97 @@ TEST_CASE("Basic fen string parsing", "[fen]")
 
     REQUIRE(gs->board().occupancy_for(Piece(Piece::Type::Pawn, Color::White)) != BitBoard::empty());
 }
+
+TEST_CASE("Fen strings survive a round trip", "[fen]")
+{
+    using namespace weechess;
+
+    const std::array<std::string_view, 5> fens = {
+        fen::initial_position,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR w Kq d6 0 3",
+        "8/8/8/8/8/8/8/K6k b - - 65535 65535",
+    };
+
+    for (const auto& fen : fens) {
+        auto snapshot = fen::from_fen(fen);
+        REQUIRE(snapshot.has_value());
+        CHECK(fen::to_fen(*snapshot) == fen);
+
+        fen::Buffer buffer;
+        CHECK(fen::write_fen(*snapshot, buffer) == fen);
+    }
+}
+
+TEST_CASE("Invalid fen strings report where they went wrong", "[fen]")
+{
+    using namespace weechess;
+
+    const std::array<std::pair<std::string_view, size_t>, 12> invalid_fens = { {
+        { "", 0 },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP w KQkq - 0 1", 34 },
+        { "rnbqkbnr/pppppppp/9/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 18 },
+        { "rnbqkbnr/pppppppp/54/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 19 },
+        { "rnbqkbnr/ppppxppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 13 },
+        { "rnbqkbnr/ppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 16 },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1", 44 },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkK - 0 1", 49 },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq e9 0 1", 52 },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 65536 1", 57 },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0", 54 },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 ", 56 },
+    } };
+
+    for (const auto& [fen, position] : invalid_fens) {
+        fen::ParseError error;
+        CHECK_FALSE(fen::from_fen(fen, &error).has_value());
+        CHECK(error.position == position);
+        CHECK_FALSE(error.reason.empty());
+    }
+}
+
+TEST_CASE("Fen benchmarks", "[.][benchmark]")
+{
+    using namespace weechess;
+
+    const std::array<std::string_view, 4> fens = {
+        fen::initial_position,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    };
+
+    std::array<GameSnapshot, fens.size()> snapshots;
+    for (size_t i = 0; i < fens.size(); i++)
+        snapshots[i] = fen::from_fen(fens[i]).value();
+
+    // Rates are easier to compare against loading a file of FENs than Catch's per call timings
+    constexpr size_t count = 100000;
+    auto fens_per_second = [&](auto&& f) {
+        auto start = std::chrono::steady_clock::now();
+        size_t checksum = 0;
+        for (size_t i = 0; i < count; i++)
+            checksum += f(i % fens.size());
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        REQUIRE(checksum > 0);
+        return static_cast<size_t>(static_cast<double>(count) / elapsed.count());
+    };
+
+    WARN("Parsing: " << fens_per_second([&](size_t i) { return fen::from_fen(fens[i])->fullmove_number; })
+                     << " FENs/sec");
+    WARN("Writing to a string: " << fens_per_second([&](size_t i) { return fen::to_fen(snapshots[i]).size(); })
+                                 << " FENs/sec");
+    WARN("Writing to a buffer: " << fens_per_second([&](size_t i) {
+        fen::Buffer buffer;
+        return fen::write_fen(snapshots[i], buffer).size();
+    }) << " FENs/sec");
+
+    BENCHMARK("Parse a FEN") { return fen::from_fen(fens[1]); };
+    BENCHMARK("Write a FEN to a buffer")
+    {
+        fen::Buffer buffer;
+        return fen::write_fen(snapshots[1], buffer).size();
+    };
+}
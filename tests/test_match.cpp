@@ -0,0 +1,212 @@
+#include <cmath>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <weechess/fen.h>
+#include <weechess/game_state.h>
+#include <weechess/move_query.h>
+
+#include "game.h"
+#include "sprt.h"
+
+namespace {
+
+// Plays a fixed line for both sides, with an evaluation for each move (from the point of view of the side
+// that moved) when there is one
+class ScriptedPlayer : public Player {
+public:
+    using Script = std::vector<std::pair<std::string_view, std::optional<int>>>;
+
+    explicit ScriptedPlayer(Script script, Milliseconds delay = Milliseconds(0))
+        : m_script(std::move(script))
+        , m_delay(delay)
+    {
+    }
+
+    Reply play(const weechess::GameSnapshot&,
+        const std::vector<weechess::Move>& moves,
+        const weechess::GameState& game_state,
+        const TimeControl&,
+        const Clock&,
+        const weechess::threading::Token&) override
+    {
+        using namespace weechess;
+
+        std::this_thread::sleep_for(m_delay);
+
+        const auto& [notation, score] = m_script[moves.size() % m_script.size()];
+        auto query = LocationMoveQuery(
+            Location::from_string(notation.substr(0, 2)).value(), Location::from_string(notation.substr(2, 2)).value());
+        auto legal_move = game_state.move_set().find_first(query);
+        if (!legal_move.has_value())
+            return {};
+
+        if (!score.has_value())
+            return { legal_move->move(), {} };
+
+        return { legal_move->move(), Evaluation { *score } };
+    }
+
+private:
+    Script m_script;
+    Milliseconds m_delay;
+};
+
+// Adjudication that stays out of the way, for the tests that aren't about it
+constexpr Adjudication no_adjudication {
+    .max_plies = 400,
+    .resign_score = 10000,
+    .resign_moves = 100,
+    .draw_score = 0,
+    .draw_moves = 0,
+    .draw_move_number = 0,
+};
+
+const TimeControl fixed_nodes { .nodes = 1000 };
+
+GameRecord play(Player& player, std::string_view fen, const TimeControl& time_control, const Adjudication& adjudication)
+{
+    auto start = weechess::fen::from_fen(fen).value();
+    weechess::threading::Token token;
+    auto record = play_game({ 1, "White", player, "Black", player }, { start, {} }, time_control, adjudication, token);
+    REQUIRE(record.has_value());
+    return *record;
+}
+
+// Both knights out and back again, which repeats the starting position every four plies
+const ScriptedPlayer::Script knight_shuffle = {
+    { "g1f3", 0 },
+    { "g8f6", 0 },
+    { "f3g1", 0 },
+    { "f6g8", 0 },
+};
+
+}
+
+TEST_CASE("Match scores give the expected Elo and SPRT values", "[match]")
+{
+    // Against values worked out by hand from the formulas
+    auto estimate = EloEstimate::from({ .wins = 60, .draws = 80, .losses = 40 });
+    CHECK(std::abs(estimate.elo - 38.764) < 0.001);
+    CHECK(std::abs(estimate.margin - 38.033) < 0.001);
+    CHECK(std::abs(estimate.los - 0.97725) < 0.00001);
+
+    estimate = EloEstimate::from({ .wins = 400, .draws = 1200, .losses = 400 });
+    CHECK(estimate.elo == 0);
+    CHECK(std::abs(estimate.margin - 9.633) < 0.001);
+    CHECK(estimate.los == 0.5);
+
+    // A clean sweep can't be put into a finite number
+    CHECK(std::isinf(EloEstimate::from({ .wins = 10 }).elo));
+
+    SPRT sprt { .elo0 = 0, .elo1 = 5, .alpha = 0.05, .beta = 0.05 };
+    CHECK(std::abs(sprt.lower_bound() + 2.9444) < 0.0001);
+    CHECK(std::abs(sprt.upper_bound() - 2.9444) < 0.0001);
+
+    CHECK(std::abs(sprt.llr({ .wins = 60, .draws = 80, .losses = 40 }) - 0.4955) < 0.0001);
+    CHECK(std::abs(sprt.llr({ .wins = 400, .draws = 1200, .losses = 400 }) + 0.5177) < 0.0001);
+    CHECK(std::abs(sprt.llr({ .wins = 900, .draws = 2000, .losses = 1100 }) + 6.6175) < 0.0001);
+
+    CHECK(sprt.decide({ .wins = 1030, .draws = 2000, .losses = 970 }) == SPRT::Decision::Continue);
+    CHECK(sprt.decide({ .wins = 900, .draws = 2000, .losses = 1100 }) == SPRT::Decision::AcceptH0);
+    CHECK(sprt.decide({ .wins = 1200, .draws = 2000, .losses = 800 }) == SPRT::Decision::AcceptH1);
+
+    // Nothing to go on yet
+    CHECK(sprt.llr({}) == 0);
+}
+
+TEST_CASE("Games end by the rules", "[match]")
+{
+    SECTION("Threefold repetition")
+    {
+        ScriptedPlayer player(knight_shuffle);
+        auto record = play(player, weechess::fen::initial_position, fixed_nodes, no_adjudication);
+        CHECK(record.result == Result::Draw);
+        CHECK(record.reason == "Draw by threefold repetition");
+        CHECK(record.san_moves.size() == 8);
+    }
+
+    SECTION("Insufficient material")
+    {
+        ScriptedPlayer player(knight_shuffle);
+
+        // Bishops that all run on the same color can't mate, however many there are
+        for (auto fen : { "4k3/8/8/8/8/8/8/4KB2 w - - 0 1", "4k3/8/8/8/8/8/8/4KN2 w - - 0 1",
+                 "2b1k3/8/8/8/8/8/8/4KB2 w - - 0 1", "4k3/8/8/8/8/8/8/B1B1K3 w - - 0 1" }) {
+            auto record = play(player, fen, fixed_nodes, no_adjudication);
+            CHECK(record.reason == "Draw by insufficient material");
+            CHECK(record.san_moves.empty());
+        }
+
+        // But bishops on both colors, two knights, or a pawn can
+        for (auto fen : { "2b1k3/8/8/8/8/8/8/2B1K3 w - - 0 1", "4k3/8/8/8/8/8/8/1N2KN2 w - - 0 1",
+                 "4k3/p7/8/8/8/8/8/4K3 w - - 0 1" }) {
+            auto record = play(player, fen, fixed_nodes, { .max_plies = 0 });
+            CHECK(record.reason == "Draw by adjudication, the game went on too long");
+        }
+    }
+
+    SECTION("Time forfeit")
+    {
+        ScriptedPlayer player(knight_shuffle, Milliseconds(50));
+        TimeControl clock { .base = Milliseconds(10) };
+        auto record = play(player, weechess::fen::initial_position, clock, no_adjudication);
+        CHECK(record.result == Result::BlackWins);
+        CHECK(record.termination == "time forfeit");
+        CHECK(record.reason == "White loses on time");
+    }
+}
+
+TEST_CASE("Games are adjudicated once both players agree", "[match]")
+{
+    using namespace weechess;
+
+    auto adjudication = no_adjudication;
+    adjudication.resign_score = 500;
+    adjudication.resign_moves = 2;
+
+    SECTION("Resigning after both players see a side losing for long enough")
+    {
+        // Both players score it as good for black
+        ScriptedPlayer player({ { "g1f3", -600 }, { "g8f6", 600 }, { "f3g1", -600 }, { "f6g8", 600 } });
+        auto record = play(player, fen::initial_position, fixed_nodes, adjudication);
+        CHECK(record.result == Result::BlackWins);
+        CHECK(record.termination == "adjudication");
+        CHECK(record.reason == "White resigns by adjudication");
+        CHECK(record.san_moves.size() == 4);
+    }
+
+    SECTION("A move without a score starts the count again")
+    {
+        ScriptedPlayer player({ { "g1f3", -600 }, { "g8f6", 600 }, { "f3g1", {} }, { "f6g8", 600 },
+            { "g1f3", -600 }, { "g8f6", 600 }, { "f3g1", -600 }, { "f6g8", 600 } });
+        auto record = play(player, fen::initial_position, fixed_nodes, adjudication);
+        CHECK(record.reason == "White resigns by adjudication");
+        CHECK(record.san_moves.size() == 7);
+    }
+
+    SECTION("A disagreement starts the count again")
+    {
+        ScriptedPlayer player({ { "g1f3", -600 }, { "g8f6", 600 }, { "f3g1", 0 }, { "f6g8", 600 } });
+        auto record = play(player, fen::initial_position, fixed_nodes, adjudication);
+        CHECK(record.reason == "Draw by threefold repetition");
+    }
+
+    SECTION("Drawing once both players see it level, from the given move on")
+    {
+        adjudication.draw_score = 10;
+        adjudication.draw_moves = 2;
+        adjudication.draw_move_number = 2;
+
+        ScriptedPlayer player({ { "b1c3", 0 }, { "b8c6", 0 }, { "c3b1", 5 }, { "c6b8", -5 } });
+        auto record = play(player, fen::initial_position, fixed_nodes, adjudication);
+        CHECK(record.result == Result::Draw);
+        CHECK(record.termination == "adjudication");
+        CHECK(record.reason == "Draw by adjudication");
+        CHECK(record.san_moves.size() == 6);
+    }
+}
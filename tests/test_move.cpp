@@ -1,10 +1,13 @@
+#include <array>
 #include <span>
+#include <string_view>
 
 #include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
 
 #include <weechess/game_state.h>
 #include <weechess/move.h>
+#include <weechess/move_query.h>
 
 TEST_CASE("Move binary packing")
 {
@@ -27,6 +30,18 @@ TEST_CASE("Move binary packing")
         CHECK(move.moving_piece() == Piece(Piece::Type::Pawn, Color::White));
         CHECK(move.resulting_piece() == Piece(Piece::Type::Queen, Color::White));
     }
+
+    SECTION("Compile time moves")
+    {
+        constexpr auto piece = Piece(Piece::Type::King, Color::Black);
+        constexpr auto move = Move::by_castling(piece, CastleSide::Queenside);
+        STATIC_REQUIRE(move.is_castle());
+        STATIC_REQUIRE(move.castle_side() == CastleSide::Queenside);
+        STATIC_REQUIRE(move.start_location() == Location::from_rank_and_file(7, 4));
+        STATIC_REQUIRE(move.end_location() == Location::from_rank_and_file(7, 2));
+        STATIC_REQUIRE(move == Move(move.data()));
+        STATIC_REQUIRE(CompactMove(move).end_location() == move.end_location());
+    }
 }
 
 TEST_CASE("Move short algebraic notation")
@@ -45,4 +60,48 @@ TEST_CASE("Move short algebraic notation")
 
     CHECK(left_capture->move().san_notation(game_state) == "dxc6");
     CHECK(right_capture->move().san_notation(game_state) == "bxc6");
+
+    auto san_of = [](std::string_view fen, Location from, Location to) {
+        auto game_state = GameState::from_fen(fen).value();
+        auto legal_move = game_state.move_set().find_first(LocationMoveQuery(from, to));
+        REQUIRE(legal_move.has_value());
+        return legal_move->move().san_notation(game_state);
+    };
+
+    CHECK(san_of("4k3/8/8/8/8/8/4P3/4K2R w K - 0 1", Location::E2, Location::E4) == "e4");
+    CHECK(san_of("4k3/8/8/8/8/8/4P3/4K2R w K - 0 1", Location::E1, Location::G1) == "O-O");
+    CHECK(san_of("4k3/1P6/8/8/8/8/8/4K3 w - - 0 1", Location::B7, Location::B8) == "b8=Q+");
+    CHECK(san_of("6k1/5ppp/8/8/8/8/8/R3K3 w - - 0 1", Location::A1, Location::A8) == "Ra8#");
+    CHECK(san_of("4k3/8/8/8/8/8/4K3/R6R w - - 0 1", Location::A1, Location::D1) == "Rad1");
+    CHECK(san_of("4k3/8/8/R7/8/8/8/R3K3 w - - 0 1", Location::A1, Location::A3) == "R1a3");
+}
+
+TEST_CASE("Compact move encoding")
+{
+    using namespace weechess;
+
+    // Positions covering castling, en passant, promotions and captures
+    constexpr std::array<std::string_view, 4> fens = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 b kq c3 0 1",
+    };
+
+    for (const auto& fen : fens) {
+        auto game_state = GameState::from_fen(fen).value();
+        for (const auto& legal_move : game_state.move_set().legal_moves()) {
+            auto decoded_move = CompactMove(legal_move.move()).decode(game_state.snapshot());
+            REQUIRE(decoded_move.has_value());
+            CHECK(*decoded_move == legal_move.move());
+        }
+    }
+
+    SECTION("Decoding against the wrong position")
+    {
+        auto game_state = GameState::new_game();
+        auto move = Move::by_moving(Piece(Piece::Type::Knight, Color::White), Location::D4, Location::E6);
+        CHECK_FALSE(CompactMove(move).decode(game_state.snapshot()).has_value());
+        CHECK_FALSE(CompactMove().decode(game_state.snapshot()).has_value());
+    }
 }
@@ -0,0 +1,134 @@
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <weechess/pgn.h>
+
+namespace {
+
+constexpr std::string_view sample_archive = R"([Event "Example"]
+[White "Caruana,F"]
+[Black "Anand,V"]
+[Result "1-0"]
+
+1. e4 e5 2. Nf3 Nc6 3. Bb5 a6 4. Ba4 Nf6 5. O-O Be7 1-0
+
+[Event "Example"]
+[Result "1/2-1/2"]
+
+1.d4 d5 2.c4 e6 1/2-1/2
+)";
+
+std::vector<std::string_view> moves_of(std::string_view text)
+{
+    weechess::pgn::Reader reader(text);
+    auto game = reader.next();
+    REQUIRE(game.has_value());
+    return game->moves;
+}
+
+}
+
+TEST_CASE("PGN archives are read a game at a time", "[pgn]")
+{
+    using namespace weechess;
+
+    pgn::Reader reader(sample_archive);
+
+    auto first = reader.next();
+    REQUIRE(first.has_value());
+    CHECK(first->tags.size() == 4);
+    CHECK(first->tag("White") == "Caruana,F");
+    CHECK_FALSE(first->tag("Round").has_value());
+    CHECK(first->moves
+        == std::vector<std::string_view> { "e4", "e5", "Nf3", "Nc6", "Bb5", "a6", "Ba4", "Nf6", "O-O", "Be7" });
+    CHECK(first->result == "1-0");
+
+    auto second = reader.next();
+    REQUIRE(second.has_value());
+    CHECK(second->moves == std::vector<std::string_view> { "d4", "d5", "c4", "e6" });
+    CHECK(second->result == "1/2-1/2");
+
+    CHECK_FALSE(reader.next().has_value());
+}
+
+TEST_CASE("PGN commentary is skipped", "[pgn]")
+{
+    using namespace weechess;
+
+    // Comments, including ones with brackets in them, and nested variations
+    CHECK(moves_of("1. e4 {Best by test (apparently)} e5 (1... c5 2. Nf3 (2. c3) {a comment)} d6) 2. Nf3 *")
+        == std::vector<std::string_view> { "e4", "e5", "Nf3" });
+
+    // Numeric annotation glyphs, suffix annotations, check marks and black's move numbers
+    CHECK(moves_of("1. e4! $1 e5?! 2. Qh5 $2 Nc6 3. Bc4 Nf6?? 4. Qxf7# 1... e5 1-0")
+        == std::vector<std::string_view> { "e4", "e5", "Qh5", "Nc6", "Bc4", "Nf6", "Qxf7#", "e5" });
+
+    // Rest of line comments and escaped lines
+    CHECK(moves_of("%escaped 1. d4\n1. e4 ; d4 is fine too\ne5 0-1") == std::vector<std::string_view> { "e4", "e5" });
+
+    // Promotions are kept intact
+    CHECK(moves_of("[FEN \"8/P7/8/8/8/8/8/k6K w - - 0 1\"]\n\n1. a8=Q+ Kb2 *") == std::vector<std::string_view> {
+              "a8=Q+", "Kb2" });
+}
+
+TEST_CASE("PGN games without results are still read", "[pgn]")
+{
+    using namespace weechess;
+
+    // A game that runs straight into the next one's tags, and a final game that runs into the end of the file
+    pgn::Reader reader("[Event \"A\"]\n1. e4 e5\n[Event \"B\"]\n1. d4 d5");
+
+    auto first = reader.next();
+    REQUIRE(first.has_value());
+    CHECK(first->tag("Event") == "A");
+    CHECK(first->moves.size() == 2);
+    CHECK(first->result.empty());
+
+    auto second = reader.next();
+    REQUIRE(second.has_value());
+    CHECK(second->tag("Event") == "B");
+    CHECK(second->moves == std::vector<std::string_view> { "d4", "d5" });
+
+    CHECK_FALSE(reader.next().has_value());
+
+    // Headings between games are skipped
+    pgn::Reader with_headings("Biel\n----\n\n[Event \"A\"]\n1. e4 1-0\n\nLake Sevan\n----------\n\n1. d4 *");
+    CHECK(with_headings.next()->moves == std::vector<std::string_view> { "e4" });
+    CHECK(with_headings.next()->moves == std::vector<std::string_view> { "d4" });
+    CHECK_FALSE(with_headings.next().has_value());
+
+    // Escaped quotes don't end a tag's value
+    auto escaped = pgn::Reader(R"([Annotator "Someone \"quoted\""] *)").next();
+    REQUIRE(escaped.has_value());
+    CHECK(escaped->tag("Annotator") == R"(Someone \"quoted\")");
+}
+
+TEST_CASE("PGN benchmarks", "[.][benchmark]")
+{
+    using namespace weechess;
+
+    std::string archive;
+    constexpr size_t count = 20000;
+    for (size_t i = 0; i < count; i++)
+        archive += sample_archive;
+
+    auto start = std::chrono::steady_clock::now();
+    size_t games = 0;
+    size_t moves = 0;
+    pgn::Reader reader(archive);
+    while (auto game = reader.next()) {
+        games++;
+        moves += game->moves.size();
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    REQUIRE(games == count * 2);
+    REQUIRE(moves == count * 14);
+
+    WARN("Reading: " << static_cast<size_t>(static_cast<double>(archive.size()) / elapsed.count() / 1e6) << " MB/sec, "
+                     << static_cast<size_t>(static_cast<double>(games) / elapsed.count()) << " games/sec");
+}
@@ -0,0 +1,184 @@
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <random>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <weechess/fen.h>
+#include <weechess/game_state.h>
+#include <weechess/polyglot_book.h>
+
+#include "temporary_file.h"
+
+namespace {
+
+// Stand-in keys, since the tests only care about how the table is used rather than its values
+weechess::polyglot::Keys test_keys()
+{
+    weechess::polyglot::Keys keys {};
+    std::mt19937_64 random_engine(781);
+    for (auto& key : keys)
+        key = random_engine();
+
+    return keys;
+}
+
+weechess::GameSnapshot snapshot_from_fen(std::string_view fen) { return weechess::fen::from_fen(fen).value(); }
+
+}
+
+TEST_CASE("Polyglot keys are loaded from text", "[polyglot]")
+{
+    using namespace weechess;
+
+    auto keys = test_keys();
+    TemporaryFile file("polyglot-keys.txt");
+    const auto& path = file.path();
+    {
+        std::ofstream stream(path);
+        for (size_t i = 0; i < keys.size(); i++)
+            stream << "0x" << std::hex << std::uppercase << std::setw(16) << std::setfill('0') << keys[i] << "ULL,"
+                   << (i % 4 == 3 ? "\n" : " ");
+    }
+
+    auto snapshot = GameSnapshot::initial_position();
+    auto hasher = polyglot::Hasher::load(path);
+    REQUIRE(hasher.has_value());
+    CHECK(hasher->hash(snapshot) == polyglot::Hasher(keys).hash(snapshot));
+
+    // Too few keys
+    {
+        std::ofstream stream(path);
+        stream << "0x9D39247E33776D41 0x2AF7398005AAA5C7";
+    }
+    CHECK_FALSE(polyglot::Hasher::load(path).has_value());
+}
+
+TEST_CASE("Polyglot hashes follow the specification's layout", "[polyglot]")
+{
+    using namespace weechess;
+
+    auto keys = test_keys();
+    polyglot::Hasher hasher(keys);
+
+    // Moving the white pawn from e2 to e4 swaps its keys (piece kind 1) and flips the side to move. There's
+    // no black pawn that could capture en passant, so the en passant file isn't part of the key
+    auto initial = hasher.hash(snapshot_from_fen(fen::initial_position));
+    auto after_e4 = hasher.hash(snapshot_from_fen("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1"));
+    CHECK((initial ^ after_e4) == (keys[64 * 1 + 12] ^ keys[64 * 1 + 28] ^ keys[780]));
+
+    // With a black pawn on d4 it could, so the key for the e file is included
+    auto with_capture = hasher.hash(snapshot_from_fen("4k3/8/8/8/3pP3/8/8/4K3 b - e3 0 1"));
+    auto without_capture = hasher.hash(snapshot_from_fen("4k3/8/8/8/3pP3/8/8/4K3 b - - 0 1"));
+    CHECK((with_capture ^ without_capture) == keys[772 + 4]);
+
+    // Castle rights are in the order white kingside, white queenside, black kingside, black queenside
+    auto all_rights = hasher.hash(snapshot_from_fen("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1"));
+    auto white_queenside = hasher.hash(snapshot_from_fen("r3k2r/8/8/8/8/8/8/R3K2R w Kkq - 0 1"));
+    CHECK((all_rights ^ white_queenside) == keys[769]);
+}
+
+TEST_CASE("Polyglot hashes match the specification's examples", "[polyglot]")
+{
+    using namespace weechess;
+
+    polyglot::Hasher hasher;
+    auto hash = [&](std::string_view fen) { return hasher.hash(snapshot_from_fen(fen)); };
+
+    CHECK(hash(fen::initial_position) == 0x463b96181691fc9cULL);
+    CHECK(hash("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1") == 0x823c9b50fd114196ULL);
+    CHECK(hash("rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2") == 0x0756b94461c50fb0ULL);
+    CHECK(hash("rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2") == 0x662fafb965db29d4ULL);
+    CHECK(hash("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3") == 0x22a48b5a8e47ff78ULL);
+    CHECK(hash("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3") == 0x652a607ca3f242c1ULL);
+    CHECK(hash("rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4") == 0x00fdd303c946bdd9ULL);
+    CHECK(hash("rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3") == 0x3c8123ea7b067637ULL);
+    CHECK(hash("rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4") == 0x5c3f9b829b279560ULL);
+}
+
+TEST_CASE("Polyglot moves are encoded as in the specification", "[polyglot]")
+{
+    using namespace weechess;
+
+    auto check_round_trip = [](std::string_view fen, std::string_view from, std::string_view to, uint16_t data) {
+        auto snapshot = snapshot_from_fen(fen);
+        auto origin = Location::from_string(from).value();
+        auto destination = Location::from_string(to).value();
+
+        std::optional<Move> move;
+        GameState state(snapshot);
+        for (const auto& legal_move : state.move_set().legal_moves()) {
+            if (legal_move.move().start_location() == origin && legal_move.move().end_location() == destination)
+                move = legal_move.move();
+        }
+
+        REQUIRE(move.has_value());
+        CHECK(polyglot::encode_move(*move) == data);
+        CHECK(polyglot::decode_move(data, snapshot) == move);
+    };
+
+    check_round_trip(fen::initial_position, "e2", "e4", 4 | (3 << 3) | (4 << 6) | (1 << 9));
+
+    // Castling is written as the king taking its own rook
+    check_round_trip("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1", "e1", "g1", 7 | (4 << 6));
+    check_round_trip("r3k2r/8/8/8/8/8/8/R3K2R b KQkq - 0 1", "e8", "c8", (7 << 3) | (4 << 6) | (7 << 9));
+
+    // Illegal moves don't decode
+    CHECK_FALSE(polyglot::decode_move(4 | (4 << 3) | (4 << 6) | (1 << 9), GameSnapshot::initial_position()));
+}
+
+TEST_CASE("Polyglot books are written, searched and sampled by weight", "[polyglot]")
+{
+    using namespace weechess;
+
+    polyglot::Hasher hasher(test_keys());
+    auto initial = GameSnapshot::initial_position();
+    GameState state(initial);
+    auto first_move = polyglot::encode_move(state.move_set().legal_moves()[0].move());
+
+    std::vector<polyglot::Entry> entries;
+    std::vector<Move> moves;
+    for (const auto& legal_move : state.move_set().legal_moves()) {
+        moves.push_back(legal_move.move());
+        entries.push_back({ hasher.hash(initial), polyglot::encode_move(legal_move.move()), 0, 0 });
+    }
+
+    // Only two moves carry any weight, one three times as much as the other
+    entries[0].weight = 3;
+    entries[1].weight = 1;
+
+    // Some other positions, so the search has to find the right run of entries
+    for (const auto& legal_move : state.move_set().legal_moves())
+        entries.push_back({ hasher.hash(legal_move.snapshot()), first_move, 1, 0 });
+
+    TemporaryFile file("polyglot-book.bin");
+    const auto& path = file.path();
+    REQUIRE(polyglot::write_book(path, entries));
+    REQUIRE(std::filesystem::file_size(path) == entries.size() * 16);
+
+    auto book = PolyglotBook::open(path, hasher);
+    REQUIRE(book.has_value());
+    CHECK(book->size() == entries.size());
+
+    auto found = book->lookup(initial);
+    REQUIRE(found.size() == moves.size());
+    CHECK(found[0].move == moves[0]);
+    CHECK(found[0].weight == 3);
+    CHECK(found[1].move == moves[1]);
+
+    std::default_random_engine random_engine(0);
+    size_t first_move_count = 0;
+    constexpr size_t samples = 4000;
+    for (size_t i = 0; i < samples; i++) {
+        auto move = book->select(initial, random_engine);
+        REQUIRE(move.has_value());
+        REQUIRE((*move == moves[0] || *move == moves[1]));
+        first_move_count += *move == moves[0];
+    }
+
+    CHECK(first_move_count > samples * 7 / 10);
+    CHECK(first_move_count < samples * 8 / 10);
+
+    CHECK(book->lookup(snapshot_from_fen("4k3/8/8/8/8/8/8/4K3 w - - 0 1")).empty());
+}
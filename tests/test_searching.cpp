@@ -1,7 +1,16 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <string_view>
+#include <thread>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
 
 #include <weechess/engine.h>
 #include <weechess/game_state.h>
+#include <weechess/searcher.h>
+#include <weechess/threading.h>
 
 TEST_CASE("Searching for obviously good moves", "[search]")
 {
@@ -13,6 +22,233 @@ TEST_CASE("Searching for obviously good moves", "[search]")
         REQUIRE(result.best_line.size() > 0);
         CHECK(result.best_line[0].start_location() == Location::C4);
         CHECK(result.best_line[0].end_location() == Location::B5);
-        CHECK(result.evaluation == Evaluation::mate_in(6));
+        CHECK(result.evaluation == Evaluation::mate_in(5));
+        CHECK(result.evaluation.moves_until_mate() == 3);
     }
 }
+
+TEST_CASE("Quiescence nodes are reported separately", "[search]")
+{
+    using namespace weechess;
+
+    // White's queen can take a defended pawn, which only the quiescence search will see through
+    auto game_state = GameState::from_fen("4k3/8/3p4/4p3/8/8/4Q3/4K3 w - - 0 1").value();
+
+    size_t nodes_searched = 0;
+    size_t quiescence_nodes_searched = 0;
+    Searcher().search(game_state, 3, [&](const SearchProgress& progress, SearchControl&) {
+        nodes_searched = progress.nodes_searched();
+        quiescence_nodes_searched = progress.quiescence_nodes_searched();
+    });
+
+    CHECK(quiescence_nodes_searched > 0);
+    CHECK(quiescence_nodes_searched < nodes_searched);
+}
+
+TEST_CASE("Stopping a search keeps the last completed iteration", "[search]")
+{
+    using namespace weechess;
+
+    auto game_state = GameState::from_fen("2rr3k/pp3pp1/1nnqbN1p/3pN3/2pP4/2P3Q1/PPB4P/R4RK1 w - - 0 1").value();
+
+    threading::Token stop;
+    size_t completed_depth = 0;
+    std::vector<Move> best_line;
+    Searcher().search(game_state, 64, [&](const SearchProgress& progress, SearchControl&) {
+        completed_depth = progress.max_depth();
+        best_line = progress.best_line();
+        if (completed_depth == 2)
+            stop.invalidate();
+    }, stop);
+
+    CHECK(completed_depth == 2);
+    CHECK_FALSE(best_line.empty());
+}
+
+TEST_CASE("Searches stop at the node limit", "[search]")
+{
+    using namespace weechess;
+
+    auto game_state = GameState::from_fen("2rr3k/pp3pp1/1nnqbN1p/3pN3/2pP4/2P3Q1/PPB4P/R4RK1 w - - 0 1").value();
+
+    threading::Token stop;
+    constexpr size_t max_nodes = 10000;
+    Searcher searcher;
+    searcher.search(game_state, 64, [](const SearchProgress&, SearchControl&) { }, stop, max_nodes);
+
+    // The limit is only checked every so often, so allow for some overshoot
+    CHECK(searcher.nodes_searched() >= max_nodes);
+    CHECK(searcher.nodes_searched() < max_nodes * 2);
+}
+
+TEST_CASE("Searches keep the transposition table from one to the next", "[search]")
+{
+    using namespace weechess;
+
+    auto game_state = GameState::from_fen("2rr3k/pp3pp1/1nnqbN1p/3pN3/2pP4/2P3Q1/PPB4P/R4RK1 w - - 0 1").value();
+    auto nodes_searched = [&](Searcher& searcher) {
+        searcher.search(game_state, 4, [](const SearchProgress&, SearchControl&) { });
+        return searcher.nodes_searched();
+    };
+
+    auto transposition_table = std::make_shared<TranspositionTable>(1024 * 1024);
+    Searcher searcher({}, {}, transposition_table);
+    auto first = nodes_searched(searcher);
+    auto second = nodes_searched(searcher);
+    CHECK(second < first);
+
+    // Clearing the table, as a new game does, starts over
+    transposition_table->clear();
+    CHECK(nodes_searched(searcher) == first);
+}
+
+TEST_CASE("Check extensions find mates at shallower depths", "[search]")
+{
+    using namespace weechess;
+
+    // Every move of the mate in 3 is a check, so extending them finds it with only two plies to go
+    auto game_state = GameState::from_fen("r3k2r/ppp2Npp/1b5n/4p2b/2B1P2q/BQP2P2/P5PP/RN5K w kq - 1 1").value();
+    auto evaluation = [&](const SearchFeatures& features) {
+        std::optional<SearchProgress> result;
+        Searcher(features).search(game_state, 2, [&](const SearchProgress& progress, SearchControl&) {
+            result = progress;
+        });
+
+        REQUIRE(result.has_value());
+        return result->evaluation();
+    };
+
+    CHECK(evaluation({}) == Evaluation::mate_in(5));
+    CHECK_FALSE(evaluation({ .check_extensions = false }).is_mate());
+}
+
+TEST_CASE("Search features change the work done but not the move", "[search]")
+{
+    using namespace weechess;
+
+    auto game_state = GameState::from_fen("7k/p7/1R5K/6r1/6p1/6P1/8/8 w - - 0 1").value();
+    auto search = [&](const SearchFeatures& features) {
+        std::optional<SearchProgress> result;
+        Searcher(features).search(game_state, 6, [&](const SearchProgress& progress, SearchControl&) {
+            result = progress;
+        });
+
+        REQUIRE(result.has_value());
+        REQUIRE_FALSE(result->best_line().empty());
+        return std::make_pair(result->best_line().front(), result->nodes_searched());
+    };
+
+    auto [best_move, nodes_searched] = search({});
+    for (const auto& features : { SearchFeatures { .check_extensions = false },
+             SearchFeatures { .singular_extensions = false },
+             SearchFeatures { .internal_iterative_reductions = false } }) {
+        auto [move, nodes] = search(features);
+        CHECK(move == best_move);
+        CHECK(nodes != nodes_searched);
+    }
+}
+
+TEST_CASE("Time for a move on a clock", "[search]")
+{
+    using namespace weechess;
+    using Milliseconds = std::chrono::duration<size_t, std::milli>;
+
+    // A share of what's left, plus most of the increment
+    CHECK(time_for_move(Milliseconds(60000), Milliseconds(0)) == Milliseconds(1999));
+    CHECK(time_for_move(Milliseconds(60000), Milliseconds(1000)) == Milliseconds(2749));
+    CHECK(time_for_move(Milliseconds(60000), Milliseconds(0), 1) == Milliseconds(59980));
+
+    // Never more than is left on the clock
+    CHECK(time_for_move(Milliseconds(100), Milliseconds(5000)) <= Milliseconds(100));
+    CHECK(time_for_move(Milliseconds(0), Milliseconds(0)) == Milliseconds(1));
+}
+
+namespace {
+
+// The first positions of the Win at Chess test suite, all tactical
+constexpr std::array<std::string_view, 6> benchmark_positions = {
+    "2rr3k/pp3pp1/1nnqbN1p/3pN3/2pP4/2P3Q1/PPB4P/R4RK1 w - - 0 1",
+    "8/7p/5k2/5p2/p1p2P2/Pr1pPK2/1P1R3P/8 b - - 0 1",
+    "5rk1/1ppb3p/p1pb4/6q1/3P1p1r/2P1R2P/PP1BQ1P1/5RK1 b - - 0 1",
+    "r1bq2rk/pp3pbp/2p1p1pQ/7P/3P4/2PB1N2/PP3PPR/2KR4 w - - 0 1",
+    "5k2/6pp/p1qN4/1p1p4/3P4/2PKP2Q/PP3r2/3R4 b - - 0 1",
+    "7k/p7/1R5K/6r1/6p1/6P1/8/8 w - - 0 1",
+};
+
+size_t search_benchmark_positions(const weechess::SearchFeatures& features, size_t depth)
+{
+    using namespace weechess;
+
+    size_t nodes_searched = 0;
+    for (const auto& fen : benchmark_positions) {
+        auto game_state = GameState::from_fen(fen).value();
+        size_t position_nodes_searched = 0;
+        Searcher(features).search(game_state, depth, [&](const SearchProgress& progress, SearchControl&) {
+            position_nodes_searched = progress.nodes_searched();
+        });
+
+        nodes_searched += position_nodes_searched;
+    }
+
+    return nodes_searched;
+}
+
+}
+
+TEST_CASE("Search feature benchmarks", "[.][benchmark]")
+{
+    using namespace weechess;
+
+    constexpr size_t depth = 4;
+    const std::array<std::pair<std::string_view, SearchFeatures>, 5> configurations = { {
+        { "All search features", {} },
+        { "Without check extensions", { .check_extensions = false } },
+        { "Without singular extensions", { .singular_extensions = false } },
+        { "Without internal iterative reductions", { .internal_iterative_reductions = false } },
+        { "Without any depth adjustments",
+            { .check_extensions = false, .singular_extensions = false, .internal_iterative_reductions = false } },
+    } };
+
+    for (const auto& [name, features] : configurations) {
+        WARN(name << ": " << search_benchmark_positions(features, depth) << " nodes");
+        BENCHMARK(std::string(name)) { return search_benchmark_positions(features, depth); };
+    }
+}
+
+TEST_CASE("Search stop latency", "[.][benchmark]")
+{
+    using namespace weechess;
+
+    // A single stop can't be repeated by Catch's benchmark runner, so time a handful of them by hand.
+    // This covers everything up to the search returning. The transposition table belongs to the searcher
+    // rather than the search, so releasing it isn't part of stopping
+    constexpr size_t samples = 16;
+    std::chrono::nanoseconds total_latency { 0 };
+    std::chrono::nanoseconds worst_latency { 0 };
+
+    for (size_t i = 0; i < samples; i++) {
+        auto game_state = GameState::from_fen(benchmark_positions[i % benchmark_positions.size()]).value();
+
+        threading::Token stop;
+        Searcher searcher;
+        std::thread thread([&]() {
+            searcher.search(game_state, 64, [](const SearchProgress&, SearchControl&) { }, stop);
+        });
+
+        // Let the search get past the shallow iterations before asking it to stop
+        while (searcher.current_depth() < 4)
+            std::this_thread::yield();
+
+        auto start = std::chrono::steady_clock::now();
+        stop.invalidate();
+        thread.join();
+        auto latency = std::chrono::steady_clock::now() - start;
+
+        total_latency += latency;
+        worst_latency = std::max(worst_latency, std::chrono::duration_cast<std::chrono::nanoseconds>(latency));
+    }
+
+    using microseconds = std::chrono::duration<double, std::micro>;
+    WARN("Mean stop latency: " << microseconds(total_latency / samples).count() << "us");
+    WARN("Worst stop latency: " << microseconds(worst_latency).count() << "us");
+}
@@ -0,0 +1,21 @@
+#include <cstdlib>
+#include <string>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+
+// Batch jobs spawn lots of short lived engine processes, so it matters how long one takes to get
+// going. This covers everything from process launch and static initialization through to the engine
+// answering `isready`, since the attack tables and hash keys should all be baked into the binary.
+TEST_CASE("Engine startup benchmarks", "[.][benchmark]")
+{
+    const std::string command = "printf 'uci\\nisready\\nquit\\n' | \"" WEECHESS_UCI_PATH "\" > /dev/null";
+
+    REQUIRE(std::system(command.c_str()) == 0);
+
+    BENCHMARK("Start the UCI engine and quit once it's ready") { return std::system(command.c_str()); };
+}
+
+}
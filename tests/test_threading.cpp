@@ -0,0 +1,137 @@
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <weechess/game_state.h>
+#include <weechess/threading.h>
+
+namespace {
+
+uint64_t perft(const weechess::GameState& game_state, int depth)
+{
+    if (depth == 0)
+        return 1;
+
+    uint64_t nodes = 0;
+    for (const auto& legal_move : game_state.move_set().legal_moves())
+        nodes += perft(weechess::GameState(legal_move.snapshot()), depth - 1);
+
+    return nodes;
+}
+
+// Splits every move at the top `split_depth` plies into its own task
+uint64_t parallel_perft(weechess::threading::ThreadPool& pool,
+    const weechess::GameState& game_state,
+    int depth,
+    int split_depth)
+{
+    if (split_depth == 0 || depth == 0)
+        return perft(game_state, depth);
+
+    std::vector<std::future<uint64_t>> children;
+    for (const auto& legal_move : game_state.move_set().legal_moves()) {
+        children.push_back(pool.submit([&pool, snapshot = legal_move.snapshot(), depth, split_depth]() {
+            return parallel_perft(pool, weechess::GameState(snapshot), depth - 1, split_depth - 1);
+        }));
+    }
+
+    uint64_t nodes = 0;
+    for (auto& child : children)
+        nodes += pool.get(child);
+
+    return nodes;
+}
+
+}
+
+TEST_CASE("Thread pools run tasks and return their results", "[threading]")
+{
+    using namespace weechess;
+
+    threading::ThreadPool pool(4);
+    REQUIRE(pool.size() == 4);
+
+    std::vector<std::future<size_t>> results;
+    for (size_t i = 0; i < 100; i++)
+        results.push_back(pool.submit([i]() { return i * i; }));
+
+    for (size_t i = 0; i < results.size(); i++)
+        CHECK(results[i].get() == i * i);
+}
+
+TEST_CASE("Thread pool tasks can wait on tasks they submit", "[threading]")
+{
+    using namespace weechess;
+
+    // A single worker would deadlock here if waiting on a child didn't run the child itself
+    for (size_t thread_count : { 1, 4 }) {
+        threading::ThreadPool pool(thread_count);
+
+        auto game_state = GameState::new_game();
+        auto root = pool.submit([&]() { return parallel_perft(pool, game_state, 3, 2); });
+        CHECK(root.get() == 8902);
+    }
+}
+
+TEST_CASE("Thread pool tasks see their token being invalidated", "[threading]")
+{
+    using namespace weechess;
+
+    threading::ThreadPool pool(2);
+    threading::Token token;
+
+    std::atomic<bool> started { false };
+    std::atomic<bool> stopped_by_token { false };
+    auto task = pool.submit(token, [&](const threading::Token& token) {
+        started = true;
+        while (!token.invalidated())
+            std::this_thread::yield();
+
+        stopped_by_token = true;
+    });
+
+    while (!started)
+        std::this_thread::yield();
+
+    // The task keeps going until it sees the token it was handed being invalidated
+    CHECK_FALSE(stopped_by_token);
+    token.invalidate();
+    task.get();
+    CHECK(stopped_by_token);
+}
+
+TEST_CASE("Thread pools finish submitted tasks before shutting down", "[threading]")
+{
+    using namespace weechess;
+
+    std::atomic<size_t> completed { 0 };
+    {
+        threading::ThreadPool pool(2);
+        for (size_t i = 0; i < 64; i++)
+            pool.submit([&]() { completed++; });
+    }
+
+    CHECK(completed == 64);
+}
+
+TEST_CASE("Thread pool benchmarks", "[.][benchmark]")
+{
+    using namespace weechess;
+
+    threading::ThreadPool pool;
+    auto game_state = GameState::new_game();
+
+    BENCHMARK("Submit and wait for an empty task") { return pool.submit([]() { return 0; }).get(); };
+    BENCHMARK("Spawn and join an empty thread")
+    {
+        std::thread thread([]() { });
+        thread.join();
+    };
+
+    BENCHMARK("Perft 4 on one thread") { return perft(game_state, 4); };
+    BENCHMARK("Perft 4 split across the pool") { return parallel_perft(pool, game_state, 4, 2); };
+}
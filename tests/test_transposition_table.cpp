@@ -0,0 +1,56 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <weechess/game_state.h>
+#include <weechess/transposition_table.h>
+
+TEST_CASE("Transposition table storage", "[search]")
+{
+    using namespace weechess;
+
+    TranspositionTable table(1024);
+    REQUIRE(table.capacity() == 1024 / sizeof(TranspositionEntry));
+
+    auto game_state = GameState::new_game();
+    const auto& legal_move = game_state.move_set().legal_moves().front();
+
+    SECTION("Empty table")
+    {
+        CHECK_FALSE(table.find(game_state.snapshot(), 0).has_value());
+    }
+
+    SECTION("Stored entries")
+    {
+        table.insert(game_state.snapshot(),
+            TranspositionEntry::Type::LowerBound,
+            legal_move.move(),
+            4,
+            Evaluation { Evaluation::pawns(1) },
+            0);
+
+        auto entry = table.find(game_state.snapshot(), 0);
+        REQUIRE(entry.has_value());
+        CHECK(entry->type == TranspositionEntry::Type::LowerBound);
+        CHECK(entry->depth == 4);
+        CHECK(entry->evaluation().score == Evaluation::pawns(1));
+        CHECK(entry->move.decode(game_state.snapshot()) == legal_move.move());
+
+        CHECK_FALSE(table.find(legal_move.snapshot(), 0).has_value());
+
+        table.clear();
+        CHECK_FALSE(table.find(game_state.snapshot(), 0).has_value());
+    }
+
+    SECTION("Mate scores are relative to the ply they're found at")
+    {
+        // A mate 5 plies from the root, found at ply 2, is 3 plies from the stored position
+        table.insert(game_state.snapshot(),
+            TranspositionEntry::Type::Exact,
+            legal_move.move(),
+            4,
+            Evaluation::mate_in(5),
+            2);
+        CHECK(table.find(game_state.snapshot(), 2)->evaluation() == Evaluation::mate_in(5));
+        CHECK(table.find(game_state.snapshot(), 4)->evaluation() == Evaluation::mate_in(7));
+        CHECK(table.find(game_state.snapshot(), 0)->evaluation() == Evaluation::mate_in(3));
+    }
+}
@@ -0,0 +1,124 @@
+#include <cstdio>
+#include <string>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+
+// Runs the engine on whatever the given shell command prints
+std::string run_uci_engine_on(const std::string& input_command)
+{
+    const std::string command = input_command + " | \"" WEECHESS_UCI_PATH "\" 2> /dev/null";
+
+    std::string output;
+    auto* pipe = popen(command.c_str(), "r");
+    REQUIRE(pipe != nullptr);
+
+    char buffer[256];
+    while (std::fgets(buffer, sizeof(buffer), pipe) != nullptr)
+        output += buffer;
+
+    REQUIRE(pclose(pipe) == 0);
+    return output;
+}
+
+std::string run_uci_engine(const std::string& input) { return run_uci_engine_on("printf '" + input + "'"); }
+
+}
+
+TEST_CASE("The UCI engine answers isready while searching", "[uci]")
+{
+    // A position that isn't in the opening book, so the engine really has to search
+    auto output = run_uci_engine("uci\\n"
+                                 "position fen 4k3/8/3p4/4p3/8/8/4Q3/4K3 w - - 0 1\\n"
+                                 "go infinite\\n"
+                                 "isready\\n"
+                                 "stop\\n"
+                                 "quit\\n");
+
+    auto ready = output.find("readyok\n");
+    auto best_move = output.find("bestmove ");
+
+    REQUIRE(ready != std::string::npos);
+    REQUIRE(best_move != std::string::npos);
+    CHECK(ready < best_move);
+    CHECK(output.find("bestmove 0000") == std::string::npos);
+}
+
+TEST_CASE("The UCI engine still reports a move when input runs out mid search", "[uci]")
+{
+    // Running out of input is the same as quitting, which stops the search
+    auto output = run_uci_engine("position fen 4k3/8/3p4/4p3/8/8/4Q3/4K3 w - - 0 1\\n"
+                                 "go infinite\\n");
+
+    CHECK(output.find("bestmove ") != std::string::npos);
+}
+
+TEST_CASE("The UCI engine falls back to its built in book", "[uci]")
+{
+    auto output = run_uci_engine("setoption name BookFile value /nonexistent/weechess.book\\n"
+                                 "position startpos\\n"
+                                 "go\\n"
+                                 "quit\\n");
+
+    CHECK(output.find("info string Unable to open book file") != std::string::npos);
+    CHECK(output.find("info string Using book move") != std::string::npos);
+}
+
+TEST_CASE("The UCI engine stops using its book past the book depth", "[uci]")
+{
+    auto output = run_uci_engine("setoption name BookPolicy value BestScore\\n"
+                                 "setoption name BookDepth value 0\\n"
+                                 "position startpos\\n"
+                                 "go depth 1\\n"
+                                 "quit\\n");
+
+    CHECK(output.find("info string Using book move") == std::string::npos);
+    CHECK(output.find("bestmove ") != std::string::npos);
+}
+
+TEST_CASE("The UCI engine plays on a clock", "[uci]")
+{
+    // Input stays open for well past the engine's budget, so only its clock can stop the search before
+    // isready is answered. Left to itself the engine would search this position for ten seconds
+    auto output = run_uci_engine_on("(printf 'position fen 4k3/8/3p4/4p3/8/8/4Q3/4K3 w - - 0 1\\n"
+                                    "go wtime 600 btime 600 winc 0 binc 0\\n'; "
+                                    "sleep 2; "
+                                    "printf 'isready\\nquit\\n')");
+
+    auto ready = output.find("readyok\n");
+    auto best_move = output.find("bestmove ");
+
+    REQUIRE(ready != std::string::npos);
+    REQUIRE(best_move != std::string::npos);
+    CHECK(best_move < ready);
+    CHECK(output.find("bestmove 0000") == std::string::npos);
+}
+
+TEST_CASE("The UCI engine has a Hash option", "[uci]")
+{
+    auto output = run_uci_engine("uci\\n"
+                                 "setoption name Hash value 1\\n"
+                                 "position fen 4k3/8/3p4/4p3/8/8/4Q3/4K3 w - - 0 1\\n"
+                                 "go depth 4\\n"
+                                 "quit\\n");
+
+    CHECK(output.find("option name Hash type spin") != std::string::npos);
+    CHECK(output.find("bestmove ") != std::string::npos);
+}
+
+TEST_CASE("The UCI bench command gives the same node count every time", "[uci]")
+{
+    auto nodes_searched = [](const std::string& output) {
+        auto line = output.find("Nodes searched  : ");
+        REQUIRE(line != std::string::npos);
+        return output.substr(line, output.find('\n', line) - line);
+    };
+
+    auto first = run_uci_engine("bench 2\\nquit\\n");
+    auto second = run_uci_engine("bench 2\\nquit\\n");
+
+    CHECK(first.find("info string bench position 50/50 ") != std::string::npos);
+    CHECK(first.find("Nodes/second    : ") != std::string::npos);
+    CHECK(nodes_searched(first) == nodes_searched(second));
+}
@@ -1,94 +1,241 @@
 #include <algorithm>
-#include <fstream>
+#include <charconv>
+#include <future>
 #include <iostream>
+#include <limits>
 #include <map>
-#include <set>
+#include <span>
+#include <unordered_map>
 
 #include <argparse/argparse.h>
+#include <weechess/book.h>
+#include <weechess/color_map.h>
 #include <weechess/game_state.h>
 #include <weechess/move.h>
 #include <weechess/move_query.h>
+#include <weechess/pgn.h>
+#include <weechess/polyglot_book.h>
+#include <weechess/threading.h>
 #include <weechess/zobrist.h>
 
 using namespace weechess;
 
 constexpr size_t max_opening_moves = 16;
 
-struct MoveEntry {
-    std::string string;
-    PGNMoveQuery query;
+struct MoveCompare {
+    bool operator()(const Move& a, const Move& b) const { return a.data() < b.data(); }
 };
 
-struct MoveCompare {
-    bool operator()(const Move& a, const Move& b) const { return a.data().to_ulong() < b.data().to_ulong(); }
+struct PolyglotKeyHash {
+    // Polyglot keys are already random, so they only need mixing with the move
+    size_t operator()(const std::pair<polyglot::Hash, uint16_t>& key) const
+    {
+        return static_cast<size_t>(key.first ^ (static_cast<uint64_t>(key.second) << 48));
+    }
 };
 
-void add_moves(const std::vector<MoveEntry>& entries, std::map<zobrist::Hash, std::set<Move, MoveCompare>>& dict)
-{
-    auto game_state = GameState::new_game();
-    for (size_t i = 0; i < std::min(entries.size(), max_opening_moves); ++i) {
-        const auto& entry = entries[i];
-        auto possible_moves = game_state.move_set().find(entry.query);
-        if (possible_moves.empty()) {
-            std::cout << "Failed to find move: " << entry.string << " at position: " << game_state.to_fen()
-                      << std::endl;
-            exit(1);
-        } else if (possible_moves.size() > 1) {
-            std::cout << "Ambiguous move: " << entry.string << " at position: " << game_state.to_fen() << std::endl;
-            exit(1);
+// What's known about a game from its tags and result
+struct GameInfo {
+    std::optional<Color> winner;
+    bool is_draw { false };
+
+    // Zero when a player's rating isn't known
+    ColorMap<uint16_t> elo { 0 };
+
+    static GameInfo from(const pgn::Game& game)
+    {
+        GameInfo info;
+
+        auto result = game.tag("Result").value_or(game.result);
+        if (result == "1-0") {
+            info.winner = Color::White;
+        } else if (result == "0-1") {
+            info.winner = Color::Black;
+        } else if (result == "1/2-1/2") {
+            info.is_draw = true;
         }
 
-        auto move = possible_moves[0].move();
-        auto hash = game_state.snapshot().zobrist_hash();
-        dict[hash].insert(move);
+        auto parse_elo = [&](std::string_view tag) -> uint16_t {
+            auto value = game.tag(tag).value_or("");
+            uint16_t elo = 0;
+            std::from_chars(value.data(), value.data() + value.size(), elo);
+            return elo;
+        };
 
-        game_state = GameState(possible_moves[0].snapshot());
+        info.elo = ColorMap<uint16_t>(parse_elo("WhiteElo"), parse_elo("BlackElo"));
+        return info;
     }
-}
+};
 
-std::vector<MoveEntry> parse_moves(std::string input)
-{
-    std::istringstream is(input);
+struct MoveStats {
+    uint32_t count { 0 };
+    uint32_t white_wins { 0 };
+    uint32_t draws { 0 };
+    uint32_t black_wins { 0 };
+    uint64_t elo_total { 0 };
+    uint32_t rated_count { 0 };
+
+    void add(const GameInfo& game, Color mover)
+    {
+        count++;
+        if (game.winner == Color::White) {
+            white_wins++;
+        } else if (game.winner == Color::Black) {
+            black_wins++;
+        } else if (game.is_draw) {
+            draws++;
+        }
 
-    std::string token;
-    std::vector<std::string> move_strings;
+        if (game.elo[mover] > 0) {
+            elo_total += game.elo[mover];
+            rated_count++;
+        }
+    }
 
-    while (is.good()) {
-        is >> token;
+    void merge(const MoveStats& other)
+    {
+        count += other.count;
+        white_wins += other.white_wins;
+        draws += other.draws;
+        black_wins += other.black_wins;
+        elo_total += other.elo_total;
+        rated_count += other.rated_count;
+    }
 
-        if (token.empty()) {
-            continue;
-        } else if (token.back() == '.') {
-            continue;
-        } else if (token.find('.') != std::string::npos) {
-            token.erase(0, token.find('.') + 1);
+    Book::MoveEntry entry(const Move& move) const
+    {
+        return Book::MoveEntry {
+            .move = CompactMove(move),
+            .average_elo = static_cast<uint16_t>(rated_count > 0 ? elo_total / rated_count : 0),
+            .count = count,
+            .white_wins = white_wins,
+            .draws = draws,
+            .black_wins = black_wins,
+        };
+    }
+};
+
+// Positions and moves seen in one shard of the games. Each worker fills its own builder, and they're
+// merged together once every game has been replayed
+struct BookBuilder {
+    std::unordered_map<zobrist::Hash, std::map<Move, MoveStats, MoveCompare>> book;
+
+    // Only set when exporting a Polyglot book, weighting each move by how often it was played
+    const polyglot::Hasher* polyglot_hasher { nullptr };
+    std::unordered_map<std::pair<polyglot::Hash, uint16_t>, size_t, PolyglotKeyHash> polyglot_counts;
+
+    void add(const GameSnapshot& snapshot, const Move& move, const GameInfo& game)
+    {
+        book[snapshot.zobrist_hash()][move].add(game, snapshot.turn_to_move);
+
+        if (polyglot_hasher != nullptr)
+            polyglot_counts[{ polyglot_hasher->hash(snapshot), polyglot::encode_move(move) }]++;
+    }
+
+    void merge(BookBuilder&& other)
+    {
+        for (const auto& [hash, moves] : other.book) {
+            auto& merged_moves = book[hash];
+            for (const auto& [move, stats] : moves)
+                merged_moves[move].merge(stats);
         }
 
-        move_strings.push_back(token);
+        for (const auto& [key, count] : other.polyglot_counts)
+            polyglot_counts[key] += count;
+    }
+
+    // The moves from a position, most played first
+    std::vector<Book::MoveEntry> move_entries(const zobrist::Hash& hash) const
+    {
+        std::vector<Book::MoveEntry> entries;
+        for (const auto& [move, stats] : book.at(hash))
+            entries.push_back(stats.entry(move));
+
+        std::stable_sort(entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.count > rhs.count;
+        });
+
+        return entries;
+    }
 
-        if (token == "1/2-1/2" || token == "1-0" || token == "0-1") {
-            break;
+    std::vector<polyglot::Entry> polyglot_entries() const
+    {
+        std::vector<polyglot::Entry> entries;
+        for (const auto& [key, count] : polyglot_counts) {
+            auto weight = static_cast<uint16_t>(std::min(count, size_t(std::numeric_limits<uint16_t>::max())));
+            entries.push_back({ key.first, key.second, weight, 0 });
         }
+
+        return entries;
     }
+};
+
+// Replays the opening of a game into the builder, describing the problem if one of its moves can't be played
+std::optional<std::string> add_game(const pgn::Game& game, BookBuilder& builder)
+{
+    auto info = GameInfo::from(game);
+    auto game_state = GameState::new_game();
+    for (size_t i = 0; i < std::min(game.moves.size(), max_opening_moves); ++i) {
+        auto move_string = std::string(game.moves[i]);
+        auto query = PGNMoveQuery::from(move_string);
+        if (!query.has_value())
+            return "Failed to parse move: " + move_string;
 
-    if (move_strings.size() > 0) {
-        // Skip over the last move, which is actually the result of the game
-        move_strings.pop_back();
+        auto possible_moves = game_state.move_set().find(*query);
+        if (possible_moves.empty()) {
+            return "Failed to find move: " + move_string + " at position: " + game_state.to_fen();
+        } else if (possible_moves.size() > 1) {
+            return "Ambiguous move: " + move_string + " at position: " + game_state.to_fen();
+        }
+
+        builder.add(game_state.snapshot(), possible_moves[0].move(), info);
+
+        game_state = GameState(possible_moves[0].snapshot());
     }
 
-    std::vector<MoveEntry> moves;
+    return {};
+}
 
-    for (const auto& move_string : move_strings) {
-        auto move_query = PGNMoveQuery::from(move_string);
-        if (!move_query.has_value()) {
-            std::cout << "Failed to parse move: " << move_string << std::endl;
+// Replays the games across the pool in contiguous runs, one builder per run
+BookBuilder build_book(
+    std::span<const pgn::Game> games, const polyglot::Hasher* polyglot_hasher, threading::ThreadPool& pool)
+{
+    struct Shard {
+        BookBuilder builder;
+        std::optional<std::string> error;
+    };
+
+    // A few runs per thread, so that one slow run doesn't leave the other threads idle at the end
+    auto shard_count = std::max(static_cast<size_t>(1), std::min(games.size(), pool.size() * 4));
+    auto chunk_size = (games.size() + shard_count - 1) / shard_count;
+
+    std::vector<Shard> shards(shard_count);
+    std::vector<std::future<void>> tasks;
+    for (size_t i = 0; i < shard_count; i++) {
+        auto begin = std::min(games.size(), i * chunk_size);
+        auto end = std::min(games.size(), begin + chunk_size);
+        tasks.push_back(pool.submit([&shard = shards[i], polyglot_hasher, chunk = games.subspan(begin, end - begin)]() {
+            shard.builder.polyglot_hasher = polyglot_hasher;
+            for (const auto& game : chunk) {
+                shard.error = add_game(game, shard.builder);
+                if (shard.error.has_value())
+                    return;
+            }
+        }));
+    }
+
+    BookBuilder builder;
+    for (size_t i = 0; i < shard_count; i++) {
+        tasks[i].get();
+        if (shards[i].error.has_value()) {
+            std::cout << *shards[i].error << std::endl;
             exit(1);
         }
 
-        moves.push_back({ move_string, *move_query });
+        builder.merge(std::move(shards[i].builder));
     }
 
-    return moves;
+    return builder;
 }
 
 int main(int argc, const char* argv[])
@@ -96,6 +243,20 @@ int main(int argc, const char* argv[])
     argparse::ArgumentParser parser("bookc", WEECHESS_PROJECT_VERSION, argparse::default_arguments::none);
     parser.add_description("Compile book files for weechess from PGN archives");
     parser.add_argument("--help").default_value(false).implicit_value(true);
+    parser.add_argument("-o", "--output")
+        .metavar("FILE")
+        .help("Write a binary book file that the engine can load at runtime, instead of printing C++ source to "
+              "embed in the library");
+    parser.add_argument("--polyglot")
+        .metavar("FILE")
+        .help("Write a Polyglot (.bin) book instead, weighting moves by how often they were played");
+    parser.add_argument("--polyglot-keys")
+        .metavar("FILE")
+        .help("A table of 781 Polyglot random numbers to use instead of the one from the specification");
+    parser.add_argument("--threads")
+        .help("Number of worker threads")
+        .default_value(threading::ThreadPool::default_thread_count())
+        .scan<'u', size_t>();
     parser.add_argument("archives").remaining();
 
     try {
@@ -120,58 +281,94 @@ int main(int argc, const char* argv[])
         std::exit(0);
     }
 
-    std::map<zobrist::Hash, std::set<Move, MoveCompare>> book;
+    auto polyglot_output = parser.present<std::string>("--polyglot");
+    std::optional<polyglot::Hasher> polyglot_hasher;
+    if (polyglot_output.has_value()) {
+        polyglot_hasher.emplace();
+        if (auto keys = parser.present<std::string>("--polyglot-keys"); keys.has_value()) {
+            polyglot_hasher = polyglot::Hasher::load(*keys);
+            if (!polyglot_hasher.has_value()) {
+                std::cerr << "Unable to read Polyglot keys from: " << *keys << std::endl;
+                std::exit(1);
+            }
+        }
+    }
 
+    // The archives stay mapped until the end, since the games only hold views into them
+    std::vector<pgn::Archive> archives;
+    std::vector<pgn::Game> games;
     for (const auto& filename : input_files) {
         std::cerr << "Processing file: " << filename << std::endl;
-        std::ifstream file(filename);
-        if (!file.is_open()) {
+        auto archive = pgn::Archive::open(filename);
+        if (!archive.has_value()) {
             std::cerr << "Could not open file: " << filename << std::endl;
             std::exit(1);
         }
 
-        std::string line;
-        std::string move_list_section;
-        while (std::getline(file, line)) {
-            if (line.empty())
-                continue;
-
-            if (line[0] == '[') {
-                if (move_list_section.empty()) {
-                    continue;
-                } else {
-                    auto move_entries = parse_moves(move_list_section);
-                    add_moves(move_entries, book);
-                    move_list_section.clear();
-                }
-            } else {
-                move_list_section += " " + line;
-            }
+        auto reader = archive->reader();
+        while (auto game = reader.next())
+            games.push_back(std::move(*game));
+
+        archives.push_back(std::move(*archive));
+    }
+
+    threading::ThreadPool pool(std::max(static_cast<size_t>(1), parser.get<size_t>("--threads")));
+    auto builder = build_book(games, polyglot_hasher.has_value() ? &*polyglot_hasher : nullptr, pool);
+
+    if (polyglot_output.has_value()) {
+        auto entries = builder.polyglot_entries();
+        if (!polyglot::write_book(*polyglot_output, entries)) {
+            std::cerr << "Failed to write Polyglot book: " << *polyglot_output << std::endl;
+            std::exit(1);
         }
+
+        std::cerr << "Wrote " << entries.size() << " Polyglot entries to " << *polyglot_output << std::endl;
+        return 0;
+    }
+
+    std::vector<Book::Entry> entries;
+    std::vector<Book::MoveEntry> moves;
+
+    // Books are searched by hash, so the positions have to be written in order
+    std::vector<zobrist::Hash> hashes;
+    hashes.reserve(builder.book.size());
+    for (const auto& [hash, _] : builder.book)
+        hashes.push_back(hash);
+    std::sort(hashes.begin(), hashes.end());
+
+    for (auto hash : hashes) {
+        auto move_entries = builder.move_entries(hash);
+        entries.push_back({ hash, static_cast<uint32_t>(moves.size()), static_cast<uint32_t>(move_entries.size()) });
+        moves.insert(moves.end(), move_entries.begin(), move_entries.end());
     }
 
-    std::vector<Move> moves;
+    if (auto output = parser.present<std::string>("--output")) {
+        if (!Book({ entries, moves }).save(*output)) {
+            std::cerr << "Failed to write book file: " << *output << std::endl;
+            std::exit(1);
+        }
+
+        std::cerr << "Wrote " << entries.size() << " positions to " << *output << std::endl;
+        return 0;
+    }
 
     std::cout << "#include \"book_data.h\"" << std::endl;
     std::cout << std::endl;
 
     std::cout << "namespace weechess::generated {" << std::endl;
-    std::cout << "constexpr std::array<Book::Entry, " << book.size() << "> entries = { {" << std::endl;
-
-    size_t offset = 0;
-    for (const auto& [key, value] : book) {
-        std::cout << "    { " << key << "ULL, " << offset << ", " << value.size() << " }," << std::endl;
-        offset += value.size();
-        moves.insert(moves.end(), value.begin(), value.end());
+    std::cout << "constexpr std::array<Book::Entry, " << entries.size() << "> entries = { {" << std::endl;
+    for (const auto& entry : entries) {
+        std::cout << "    { " << entry.hash << "ULL, " << entry.offset << ", " << entry.count << " }," << std::endl;
     }
     std::cout << "} };" << std::endl;
     std::cout << std::endl;
 
-    std::cout << "constexpr std::array<Move, " << moves.size() << "> moves = {" << std::endl;
+    std::cout << "constexpr std::array<Book::MoveEntry, " << moves.size() << "> moves = { {" << std::endl;
     for (const auto& move : moves) {
-        std::cout << "    Move(Move::Data(" << move.data().to_ulong() << "UL))," << std::endl;
+        std::cout << "    { CompactMove(" << move.move.data() << "), " << move.average_elo << ", " << move.count << ", "
+                  << move.white_wins << ", " << move.draws << ", " << move.black_wins << " }," << std::endl;
     }
-    std::cout << "};" << std::endl;
+    std::cout << "} };" << std::endl;
 
     std::cout << std::endl;
     std::cout << "const Book::Data book_data = { entries, moves };" << std::endl;
@@ -0,0 +1,435 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <argparse/argparse.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+#include <weechess/engine.h>
+#include <weechess/epd.h>
+#include <weechess/game_state.h>
+#include <weechess/threading.h>
+
+using namespace weechess;
+
+using Milliseconds = std::chrono::duration<size_t, std::milli>;
+
+enum class Format { Text, CSV, JSON };
+
+struct Limits {
+    std::optional<size_t> depth;
+    std::optional<size_t> nodes;
+    std::optional<Milliseconds> time;
+};
+
+// A position from a suite, with the moves that solve it already resolved
+struct Problem {
+    std::string name;
+    epd::Record record;
+    std::vector<Move> best_moves;
+    std::vector<Move> avoid_moves;
+
+    bool is_solved_by(const Move& move) const
+    {
+        if (!best_moves.empty() && std::find(best_moves.begin(), best_moves.end(), move) == best_moves.end())
+            return false;
+
+        return std::find(avoid_moves.begin(), avoid_moves.end(), move) == avoid_moves.end();
+    }
+
+    std::string expected() const
+    {
+        std::string text;
+        for (auto opcode : { "bm", "am" }) {
+            const auto* operation = record.find(opcode);
+            if (operation == nullptr)
+                continue;
+
+            text += text.empty() ? "" : "; ";
+            text += opcode;
+            for (const auto& operand : operation->operands)
+                text += " " + operand;
+        }
+
+        return text;
+    }
+};
+
+struct Outcome {
+    std::optional<std::string> move;
+    bool solved { false };
+    PerformanceEvent performance {};
+
+    // The iteration from which the engine settled on a solving move, and didn't change its mind after
+    std::optional<PerformanceEvent> solution {};
+};
+
+struct Summary {
+    size_t positions { 0 };
+    size_t solved { 0 };
+    size_t nodes { 0 };
+    Milliseconds time { 0 };
+    Milliseconds solution_time { 0 };
+
+    void add(const Outcome& outcome)
+    {
+        positions++;
+        nodes += outcome.performance.nodes_searched;
+        time += outcome.performance.elapsed_time;
+        if (outcome.solved) {
+            solved++;
+            solution_time += outcome.solution->elapsed_time;
+        }
+    }
+
+    size_t nodes_per_second() const { return time.count() != 0 ? (1000 * nodes) / time.count() : 0; }
+    size_t average_solution_time() const { return solved != 0 ? solution_time.count() / solved : 0; }
+};
+
+class ProblemDelegate : public SearchDelegate {
+public:
+    explicit ProblemDelegate(const Problem& problem)
+        : m_problem(problem)
+    {
+    }
+
+    void on_performance_event(const PerformanceEvent& event) override { m_performance = event; }
+
+    void on_evaluation_event(const EvaluationEvent& event) override
+    {
+        if (event.best_line.empty() || !m_problem.is_solved_by(event.best_line[0])) {
+            m_solution.reset();
+        } else if (!m_solution.has_value()) {
+            // Evaluation events come straight after the performance event for the same iteration
+            m_solution = m_performance;
+        }
+    }
+
+    const PerformanceEvent& performance() const { return m_performance; }
+    const std::optional<PerformanceEvent>& solution() const { return m_solution; }
+
+private:
+    const Problem& m_problem;
+    PerformanceEvent m_performance {};
+    std::optional<PerformanceEvent> m_solution {};
+};
+
+Outcome solve(const Problem& problem, const Limits& limits)
+{
+    // Every position is searched from scratch, without the book, so the results don't depend on the order or
+    // the number of threads
+    Engine engine;
+    engine.settings().book_depth = 0;
+
+    SearchParameters parameters;
+    parameters.max_depth = limits.depth;
+    parameters.max_nodes = limits.nodes;
+    parameters.max_search_time = limits.time;
+
+    threading::Token token;
+    ProblemDelegate delegate(problem);
+    auto result = engine.calculate(GameState(problem.record.snapshot), parameters, token, delegate);
+
+    Outcome outcome;
+    outcome.performance = delegate.performance();
+    if (!result.best_line.empty()) {
+        GameState game_state(problem.record.snapshot);
+        outcome.move = result.best_line[0].san_notation(game_state);
+        outcome.solved = problem.is_solved_by(result.best_line[0]) && delegate.solution().has_value();
+        outcome.solution = delegate.solution();
+    }
+
+    return outcome;
+}
+
+std::vector<Problem> load_problems(const std::vector<std::string>& paths)
+{
+    std::vector<Problem> problems;
+    for (const auto& path : paths) {
+        epd::LoadError error;
+        auto records = epd::load(path, &error);
+        if (!records.has_value()) {
+            std::cerr << path << ":" << error.line << ":" << error.error.position + 1 << ": " << error.error.reason
+                      << std::endl;
+            std::exit(1);
+        }
+
+        for (size_t i = 0; i < records->size(); i++) {
+            auto& record = (*records)[i];
+
+            Problem problem;
+            auto id = record.id();
+            problem.name = id.has_value() ? std::string(*id) : path + "#" + std::to_string(i + 1);
+
+            if (record.find("bm") == nullptr && record.find("am") == nullptr) {
+                std::cerr << "Skipping " << problem.name << ", which has no best or avoid moves" << std::endl;
+                continue;
+            }
+
+            auto best_moves = record.find("bm") != nullptr ? record.moves("bm") : std::vector<Move>();
+            auto avoid_moves = record.find("am") != nullptr ? record.moves("am") : std::vector<Move>();
+            if (!best_moves.has_value() || !avoid_moves.has_value()) {
+                std::cerr << "Skipping " << problem.name << ", which names moves that aren't legal" << std::endl;
+                continue;
+            }
+
+            problem.best_moves = std::move(*best_moves);
+            problem.avoid_moves = std::move(*avoid_moves);
+            problem.record = std::move(record);
+            problems.push_back(std::move(problem));
+        }
+    }
+
+    return problems;
+}
+
+std::string csv_field(std::string_view text)
+{
+    if (text.find_first_of(",\"\n") == std::string_view::npos)
+        return std::string(text);
+
+    std::string field = "\"";
+    for (char c : text)
+        field += c == '"' ? std::string("\"\"") : std::string(1, c);
+
+    return field + "\"";
+}
+
+std::string json_string(std::string_view text)
+{
+    std::ostringstream os;
+    os << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            os << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        } else {
+            os << c;
+        }
+    }
+
+    os << '"';
+    return os.str();
+}
+
+std::string json_optional(const std::optional<size_t>& value)
+{
+    return value.has_value() ? std::to_string(*value) : "null";
+}
+
+void write_text(std::ostream& os, const std::vector<Problem>& problems, const std::vector<Outcome>& outcomes)
+{
+    os << std::left << std::setw(20) << "id" << std::setw(8) << "result" << std::setw(10) << "move"
+       << std::setw(24) << "expected" << std::right << std::setw(6) << "depth" << std::setw(12) << "nodes"
+       << std::setw(10) << "time" << std::setw(10) << "solved at" << std::setw(10) << "nps" << std::endl;
+
+    for (size_t i = 0; i < problems.size(); i++) {
+        const auto& outcome = outcomes[i];
+        os << std::left << std::setw(20) << problems[i].name << std::setw(8) << (outcome.solved ? "ok" : "FAIL")
+           << std::setw(10) << outcome.move.value_or("-") << std::setw(24) << problems[i].expected() << std::right
+           << std::setw(6) << outcome.performance.current_depth << std::setw(12)
+           << outcome.performance.nodes_searched << std::setw(10) << outcome.performance.elapsed_time.count()
+           << std::setw(10)
+           << (outcome.solved ? std::to_string(outcome.solution->elapsed_time.count()) : std::string("-"))
+           << std::setw(10) << outcome.performance.nodes_per_second << std::endl;
+    }
+}
+
+void write_summary(std::ostream& os, const Summary& summary)
+{
+    auto percentage = summary.positions != 0 ? 100.0 * summary.solved / summary.positions : 0.0;
+    os << "Solved " << summary.solved << " of " << summary.positions << " (" << std::fixed << std::setprecision(1)
+       << percentage << "%)" << std::endl;
+    os << "Nodes: " << summary.nodes << ", time: " << summary.time.count() << " ms, nps: " << summary.nodes_per_second()
+       << std::endl;
+    os << "Average time to solution: " << summary.average_solution_time() << " ms" << std::endl;
+}
+
+void write_csv(std::ostream& os, const std::vector<Problem>& problems, const std::vector<Outcome>& outcomes)
+{
+    os << "id,fen,expected,move,solved,depth,nodes,time_ms,nps,solution_time_ms,solution_nodes,solution_depth"
+       << std::endl;
+
+    for (size_t i = 0; i < problems.size(); i++) {
+        const auto& outcome = outcomes[i];
+        const auto& solution = outcome.solved ? outcome.solution : std::nullopt;
+        os << csv_field(problems[i].name) << ',' << problems[i].record.snapshot.to_fen() << ','
+           << csv_field(problems[i].expected()) << ',' << outcome.move.value_or("") << ','
+           << (outcome.solved ? 1 : 0) << ',' << outcome.performance.current_depth << ','
+           << outcome.performance.nodes_searched << ',' << outcome.performance.elapsed_time.count() << ','
+           << outcome.performance.nodes_per_second << ','
+           << (solution ? std::to_string(solution->elapsed_time.count()) : "") << ','
+           << (solution ? std::to_string(solution->nodes_searched) : "") << ','
+           << (solution ? std::to_string(solution->current_depth) : "") << std::endl;
+    }
+}
+
+void write_json(std::ostream& os,
+    const Limits& limits,
+    const std::vector<Problem>& problems,
+    const std::vector<Outcome>& outcomes,
+    const Summary& summary)
+{
+    os << "{" << std::endl;
+    os << "  \"limits\": { \"depth\": " << json_optional(limits.depth)
+       << ", \"nodes\": " << json_optional(limits.nodes) << ", \"time_ms\": "
+       << json_optional(limits.time.has_value() ? std::optional(limits.time->count()) : std::nullopt) << " },"
+       << std::endl;
+
+    os << "  \"positions\": [" << std::endl;
+    for (size_t i = 0; i < problems.size(); i++) {
+        const auto& outcome = outcomes[i];
+        const auto& solution = outcome.solved ? outcome.solution : std::nullopt;
+        os << "    { \"id\": " << json_string(problems[i].name)
+           << ", \"fen\": " << json_string(problems[i].record.snapshot.to_fen())
+           << ", \"expected\": " << json_string(problems[i].expected())
+           << ", \"move\": " << (outcome.move ? json_string(*outcome.move) : "null")
+           << ", \"solved\": " << (outcome.solved ? "true" : "false")
+           << ", \"depth\": " << outcome.performance.current_depth
+           << ", \"nodes\": " << outcome.performance.nodes_searched
+           << ", \"time_ms\": " << outcome.performance.elapsed_time.count()
+           << ", \"nps\": " << outcome.performance.nodes_per_second
+           << ", \"solution_time_ms\": "
+           << json_optional(solution ? std::optional(solution->elapsed_time.count()) : std::nullopt)
+           << ", \"solution_nodes\": "
+           << json_optional(solution ? std::optional(solution->nodes_searched) : std::nullopt)
+           << ", \"solution_depth\": "
+           << json_optional(solution ? std::optional(solution->current_depth) : std::nullopt) << " }"
+           << (i + 1 < problems.size() ? "," : "") << std::endl;
+    }
+    os << "  ]," << std::endl;
+
+    os << "  \"summary\": { \"positions\": " << summary.positions << ", \"solved\": " << summary.solved
+       << ", \"nodes\": " << summary.nodes << ", \"time_ms\": " << summary.time.count()
+       << ", \"nps\": " << summary.nodes_per_second()
+       << ", \"average_solution_time_ms\": " << summary.average_solution_time() << " }" << std::endl;
+    os << "}" << std::endl;
+}
+
+int main(int argc, const char* argv[])
+{
+    argparse::ArgumentParser parser("epd", WEECHESS_PROJECT_VERSION, argparse::default_arguments::none);
+    parser.add_description("Run the engine over EPD test suites, scoring its moves against their bm and am opcodes");
+    parser.add_argument("--help").default_value(false).implicit_value(true);
+    parser.add_argument("--depth").help("Search each position to this depth").scan<'u', size_t>();
+    parser.add_argument("--nodes").help("Search each position for at most this many nodes").scan<'u', size_t>();
+    parser.add_argument("--time")
+        .help("Search each position for at most this many milliseconds, which is 1000 if no limit is given")
+        .scan<'u', size_t>();
+    parser.add_argument("--threads")
+        .help("Number of positions to search at once. Node rates are per position, so they drop as threads "
+              "compete for cores")
+        .default_value(static_cast<size_t>(1))
+        .scan<'u', size_t>();
+    parser.add_argument("--format").help("One of text, csv or json").default_value(std::string("text"));
+    parser.add_argument("-o", "--output").metavar("FILE").help("Write the results here instead of to stdout");
+    parser.add_argument("suites").remaining();
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::runtime_error& err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+
+    if (parser.get<bool>("--help")) {
+        std::cout << parser;
+        std::exit(0);
+    }
+
+    std::vector<std::string> suites;
+    try {
+        suites = parser.get<std::vector<std::string>>("suites");
+    } catch (std::logic_error& e) {
+        std::cout << "No EPD files provided." << std::endl;
+        std::cout << parser;
+        std::exit(1);
+    }
+
+    Format format;
+    auto format_name = parser.get<std::string>("--format");
+    if (format_name == "text") {
+        format = Format::Text;
+    } else if (format_name == "csv") {
+        format = Format::CSV;
+    } else if (format_name == "json") {
+        format = Format::JSON;
+    } else {
+        std::cerr << "Unknown format: " << format_name << std::endl;
+        std::exit(1);
+    }
+
+    Limits limits;
+    limits.depth = parser.present<size_t>("--depth");
+    limits.nodes = parser.present<size_t>("--nodes");
+    if (auto time = parser.present<size_t>("--time"))
+        limits.time = Milliseconds(*time);
+
+    if (!limits.depth && !limits.nodes && !limits.time)
+        limits.time = Milliseconds(1000);
+
+    // The library logs every iteration of the search, which would drown out the results
+    auto lib_logger = spdlog::stderr_color_mt("weechess");
+    lib_logger->set_level(spdlog::level::warn);
+
+    auto problems = load_problems(suites);
+
+    std::vector<Outcome> outcomes;
+    {
+        threading::ThreadPool pool(std::max(static_cast<size_t>(1), parser.get<size_t>("--threads")));
+        std::vector<std::future<Outcome>> tasks;
+        for (const auto& problem : problems)
+            tasks.push_back(pool.submit([&]() { return solve(problem, limits); }));
+
+        for (size_t i = 0; i < tasks.size(); i++) {
+            outcomes.push_back(tasks[i].get());
+            std::cerr << "[" << i + 1 << "/" << problems.size() << "] " << problems[i].name << ": "
+                      << (outcomes.back().solved ? "solved" : "failed") << std::endl;
+        }
+    }
+
+    Summary summary;
+    for (const auto& outcome : outcomes)
+        summary.add(outcome);
+
+    std::ofstream file;
+    auto output_path = parser.present<std::string>("--output");
+    if (output_path.has_value()) {
+        file.open(*output_path);
+        if (!file) {
+            std::cerr << "Unable to open output file: " << *output_path << std::endl;
+            std::exit(1);
+        }
+    }
+
+    auto& os = output_path.has_value() ? static_cast<std::ostream&>(file) : std::cout;
+    switch (format) {
+    case Format::Text:
+        write_text(os, problems, outcomes);
+        os << std::endl;
+        write_summary(os, summary);
+        break;
+    case Format::CSV:
+        write_csv(os, problems, outcomes);
+        write_summary(std::cerr, summary);
+        break;
+    case Format::JSON:
+        write_json(os, limits, problems, outcomes, summary);
+        write_summary(std::cerr, summary);
+        break;
+    }
+
+    if (!os) {
+        std::cerr << "Failed to write results" << std::endl;
+        std::exit(1);
+    }
+}
@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+#include <weechess/book.h>
+#include <weechess/epd.h>
+
+#include "game.h"
+
+using namespace weechess;
+
+namespace {
+
+    bool is_insufficient_material(const Board& board)
+    {
+        size_t knights = 0;
+        size_t bishops = 0;
+        unsigned bishop_square_colors = 0;
+        for (uint8_t offset = 0; offset < Board::cell_count; offset++) {
+            Location location(offset);
+            auto piece = board.piece_at(location);
+            switch (piece.type) {
+            case Piece::Type::Pawn:
+            case Piece::Type::Rook:
+            case Piece::Type::Queen:
+                return false;
+            case Piece::Type::Knight:
+                knights++;
+                break;
+            case Piece::Type::Bishop:
+                bishops++;
+                bishop_square_colors |= 1u << ((location.rank() + location.file()) % 2);
+                break;
+            default:
+                break;
+            }
+        }
+
+        // A lone minor piece can't mate, and neither can any number of bishops that all run on the same color
+        return knights + bishops <= 1 || (knights == 0 && bishop_square_colors != 0b11);
+    }
+
+}
+
+std::vector<Opening> openings_from_book(size_t count, size_t plies, unsigned int seed)
+{
+    std::default_random_engine random_engine(seed);
+    Book::Selection selection {};
+
+    std::vector<Opening> openings;
+    for (size_t i = 0; i < count; i++) {
+        Opening opening { GameSnapshot::initial_position(), {} };
+        auto snapshot = opening.start;
+        for (size_t ply = 0; ply < plies; ply++) {
+            auto move = Book::default_instance.select(snapshot, selection, random_engine);
+            if (!move.has_value())
+                break;
+
+            snapshot = snapshot.by_performing_move(*move).value();
+            opening.moves.push_back(*move);
+        }
+
+        openings.push_back(std::move(opening));
+    }
+
+    return openings;
+}
+
+std::optional<std::vector<Opening>> openings_from_epd(const std::string& path, size_t count, unsigned int seed)
+{
+    epd::LoadError error;
+    auto records = epd::load(path, &error);
+    if (!records.has_value()) {
+        std::cerr << path << ":" << error.line << ":" << error.error.position + 1 << ": " << error.error.reason
+                  << std::endl;
+        return {};
+    }
+
+    if (records->empty()) {
+        std::cerr << "No positions in " << path << std::endl;
+        return {};
+    }
+
+    std::default_random_engine random_engine(seed);
+    std::shuffle(records->begin(), records->end(), random_engine);
+
+    std::vector<Opening> openings;
+    for (size_t i = 0; i < count; i++)
+        openings.push_back({ (*records)[i % records->size()].snapshot, {} });
+
+    return openings;
+}
+
+std::optional<GameRecord> play_game(const Pairing& pairing,
+    const Opening& opening,
+    const TimeControl& time_control,
+    const Adjudication& adjudication,
+    const threading::Token& token)
+{
+    GameRecord record {
+        .round = pairing.round,
+        .white = pairing.white_name,
+        .black = pairing.black_name,
+        .start = opening.start,
+        .san_moves = {},
+        .result = Result::Draw,
+        .termination = "normal",
+        .reason = {},
+    };
+
+    auto end_game = [&](Result result, std::string termination, std::string reason) {
+        record.result = result;
+        record.termination = std::move(termination);
+        record.reason = std::move(reason);
+        return record;
+    };
+
+    auto win_for = [](Color color) { return color == Color::White ? Result::WhiteWins : Result::BlackWins; };
+    auto name_of = [](Color color) { return std::string(color == Color::White ? "White" : "Black"); };
+
+    std::vector<Move> moves;
+    std::vector<zobrist::Hash> history;
+    auto snapshot = opening.start;
+    auto play_move = [&](const LegalMove& legal_move) {
+        GameState game_state(snapshot);
+        record.san_moves.push_back(game_state.san_notation(legal_move.move()));
+        moves.push_back(legal_move.move());
+        history.push_back(snapshot.zobrist_hash());
+        snapshot = legal_move.snapshot();
+    };
+
+    for (const auto& move : opening.moves) {
+        GameState game_state(snapshot);
+        play_move(*game_state.move_set().find(move));
+    }
+
+    pairing.white.new_game();
+    pairing.black.new_game();
+
+    Clock clock { { time_control.base, time_control.base }, time_control.increment };
+    ColorMap<size_t> winning_plies { 0, 0 };
+    size_t drawn_plies = 0;
+
+    while (true) {
+        GameState game_state(snapshot);
+        auto color = game_state.turn_to_move();
+
+        if (game_state.is_checkmate())
+            return end_game(win_for(invert_color(color)), "normal", name_of(invert_color(color)) + " mates");
+        if (game_state.is_stalemate())
+            return end_game(Result::Draw, "normal", "Stalemate");
+        if (game_state.halfmove_clock() >= 100)
+            return end_game(Result::Draw, "normal", "Draw by the fifty move rule");
+        if (std::count(history.begin(), history.end(), snapshot.zobrist_hash()) >= 2)
+            return end_game(Result::Draw, "normal", "Draw by threefold repetition");
+        if (is_insufficient_material(game_state.board()))
+            return end_game(Result::Draw, "normal", "Draw by insufficient material");
+        if (moves.size() >= adjudication.max_plies)
+            return end_game(Result::Draw, "adjudication", "Draw by adjudication, the game went on too long");
+
+        auto& player = color == Color::White ? pairing.white : pairing.black;
+        auto start_time = std::chrono::steady_clock::now();
+        auto reply = player.play(opening.start, moves, game_state, time_control, clock, token);
+        auto elapsed = std::chrono::duration_cast<Milliseconds>(std::chrono::steady_clock::now() - start_time);
+
+        if (token.invalidated())
+            return {};
+
+        if (!time_control.nodes.has_value()) {
+            if (elapsed > clock.remaining[color])
+                return end_game(win_for(invert_color(color)), "time forfeit", name_of(color) + " loses on time");
+
+            clock.remaining[color] = clock.remaining[color] - elapsed + clock.increment;
+        }
+
+        auto legal_move = reply.move.has_value() ? game_state.move_set().find(*reply.move) : std::nullopt;
+        if (!legal_move.has_value()) {
+            return end_game(
+                win_for(invert_color(color)), "rules infraction", name_of(color) + " makes an illegal move");
+        }
+
+        play_move(*legal_move);
+
+        if (!reply.evaluation.has_value()) {
+            winning_plies = { 0, 0 };
+            drawn_plies = 0;
+            continue;
+        }
+
+        // Scores from White's point of view, so the two players can be compared
+        auto score = color == Color::White ? reply.evaluation->score : -reply.evaluation->score;
+        winning_plies[Color::White] = score >= adjudication.resign_score ? winning_plies[Color::White] + 1 : 0;
+        winning_plies[Color::Black] = -score >= adjudication.resign_score ? winning_plies[Color::Black] + 1 : 0;
+        drawn_plies = std::abs(score) <= adjudication.draw_score
+                && game_state.fullmove_number() >= adjudication.draw_move_number
+            ? drawn_plies + 1
+            : 0;
+
+        for (auto winner : all_colors) {
+            if (winning_plies[winner] >= 2 * adjudication.resign_moves) {
+                return end_game(
+                    win_for(winner), "adjudication", name_of(invert_color(winner)) + " resigns by adjudication");
+            }
+        }
+
+        if (adjudication.draw_moves > 0 && drawn_plies >= 2 * adjudication.draw_moves)
+            return end_game(Result::Draw, "adjudication", "Draw by adjudication");
+    }
+}
+
+std::string result_string(Result result)
+{
+    switch (result) {
+    case Result::WhiteWins:
+        return "1-0";
+    case Result::BlackWins:
+        return "0-1";
+    default:
+        return "1/2-1/2";
+    }
+}
+
+void write_pgn(std::ostream& os, const GameRecord& record, const TimeControl& time_control, std::string_view date)
+{
+    auto result = result_string(record.result);
+    os << "[Event \"weechess-match\"]\n";
+    os << "[Site \"?\"]\n";
+    os << "[Date \"" << date << "\"]\n";
+    os << "[Round \"" << record.round << "\"]\n";
+    os << "[White \"" << record.white << "\"]\n";
+    os << "[Black \"" << record.black << "\"]\n";
+    os << "[Result \"" << result << "\"]\n";
+
+    auto fen = record.start.to_fen();
+    if (fen != GameSnapshot::initial_position().to_fen()) {
+        os << "[FEN \"" << fen << "\"]\n";
+        os << "[SetUp \"1\"]\n";
+    }
+
+    os << "[TimeControl \"" << time_control.to_pgn() << "\"]\n";
+    os << "[Termination \"" << record.termination << "\"]\n\n";
+
+    // Move text, wrapped so that no line is longer than 80 characters
+    std::vector<std::string> tokens;
+    auto fullmove_number = static_cast<size_t>(std::max<uint16_t>(record.start.fullmove_number, 1));
+    auto turn_to_move = record.start.turn_to_move;
+    for (size_t i = 0; i < record.san_moves.size(); i++) {
+        if (turn_to_move == Color::White) {
+            tokens.push_back(std::to_string(fullmove_number) + ". " + record.san_moves[i]);
+        } else if (i == 0) {
+            tokens.push_back(std::to_string(fullmove_number) + "... " + record.san_moves[i]);
+        } else {
+            tokens.push_back(record.san_moves[i]);
+        }
+
+        if (turn_to_move == Color::Black)
+            fullmove_number++;
+
+        turn_to_move = invert_color(turn_to_move);
+    }
+
+    tokens.push_back("{" + record.reason + "}");
+    tokens.push_back(result);
+
+    size_t line_length = 0;
+    for (const auto& token : tokens) {
+        if (line_length != 0 && line_length + 1 + token.size() > 80) {
+            os << '\n';
+            line_length = 0;
+        } else if (line_length != 0) {
+            os << ' ';
+            line_length++;
+        }
+
+        os << token;
+        line_length += token.size();
+    }
+
+    os << "\n\n";
+}
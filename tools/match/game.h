@@ -0,0 +1,68 @@
+#pragma once
+
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <weechess/game_state.h>
+#include <weechess/threading.h>
+
+#include "player.h"
+
+struct Opening {
+    weechess::GameSnapshot start;
+    std::vector<weechess::Move> moves;
+};
+
+// Lines picked at random from the book, weighted by how often they were played
+std::vector<Opening> openings_from_book(size_t count, size_t plies, unsigned int seed);
+
+// The positions of an EPD file in a random order, over and over again if there aren't enough of them
+std::optional<std::vector<Opening>> openings_from_epd(const std::string& path, size_t count, unsigned int seed);
+
+struct Adjudication {
+    size_t max_plies;
+
+    // A side resigns once both players agree that it's at least this far behind, for this many moves each
+    int resign_score;
+    size_t resign_moves;
+
+    // A game is drawn once both players agree that it's this close, for this many moves each, but
+    // not before the given move number
+    int draw_score;
+    size_t draw_moves;
+    size_t draw_move_number;
+};
+
+enum class Result { WhiteWins, BlackWins, Draw };
+
+struct GameRecord {
+    size_t round;
+    std::string white;
+    std::string black;
+    weechess::GameSnapshot start;
+    std::vector<std::string> san_moves;
+    Result result;
+
+    // As in the PGN tag, and as a comment after the moves
+    std::string termination;
+    std::string reason;
+};
+
+struct Pairing {
+    size_t round;
+    std::string white_name;
+    Player& white;
+    std::string black_name;
+    Player& black;
+};
+
+// Plays a game out, or gives up on it if the token is invalidated part way through
+std::optional<GameRecord> play_game(
+    const Pairing&, const Opening&, const TimeControl&, const Adjudication&, const weechess::threading::Token&);
+
+std::string result_string(Result);
+
+void write_pgn(std::ostream&, const GameRecord&, const TimeControl&, std::string_view date);
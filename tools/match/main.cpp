@@ -0,0 +1,363 @@
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <signal.h>
+
+#include <argparse/argparse.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+#include <weechess/threading.h>
+
+#include "game.h"
+#include "player.h"
+#include "sprt.h"
+
+using namespace weechess;
+
+using PlayerFactory = std::function<std::unique_ptr<Player>()>;
+
+struct Side {
+    std::string name;
+    PlayerFactory make_player;
+};
+
+// "weechess", optionally followed by search features to turn off, or the path to a UCI engine
+std::optional<Side> parse_side(const std::string& spec, size_t hash_size_in_bytes)
+{
+    if (spec == "weechess" || spec.starts_with("weechess:")) {
+        SearchFeatures features;
+        std::istringstream options(spec.size() > 8 ? spec.substr(9) : std::string());
+        std::string option;
+        while (std::getline(options, option, ',')) {
+            if (option == "no-check-extensions") {
+                features.check_extensions = false;
+            } else if (option == "no-singular-extensions") {
+                features.singular_extensions = false;
+            } else if (option == "no-iir") {
+                features.internal_iterative_reductions = false;
+            } else {
+                std::cerr << "Unknown engine option: " << option << std::endl;
+                return {};
+            }
+        }
+
+        return Side { spec, [=]() { return std::make_unique<EnginePlayer>(features, hash_size_in_bytes); } };
+    }
+
+    // Started once up front, so that a bad path fails the match before any games are played
+    if (!std::filesystem::is_regular_file(spec) || UCIPlayer::launch(spec) == nullptr) {
+        std::cerr << "Unable to start a UCI engine from " << spec << std::endl;
+        return {};
+    }
+
+    return Side { std::filesystem::path(spec).filename().string(), [=]() { return UCIPlayer::launch(spec); } };
+}
+
+void write_standing(std::ostream& os, const std::string& first, const std::string& second, const Score& score,
+    const SPRT& sprt)
+{
+    auto estimate = EloEstimate::from(score);
+    os << std::fixed << std::setprecision(3) << "Score of " << first << " vs " << second << ": " << score.wins
+       << " - " << score.losses << " - " << score.draws << " [" << score.ratio() << "] " << score.games()
+       << std::endl;
+    os << std::setprecision(1) << "Elo: " << estimate.elo << " +/- " << estimate.margin
+       << ", LOS: " << 100 * estimate.los << "%, LLR: " << std::setprecision(2) << sprt.llr(score) << " ("
+       << sprt.lower_bound() << ", " << sprt.upper_bound() << ")" << std::endl;
+}
+
+std::string today()
+{
+    auto now = std::time(nullptr);
+    std::tm local {};
+    localtime_r(&now, &local);
+
+    char buffer[16];
+    std::strftime(buffer, sizeof(buffer), "%Y.%m.%d", &local);
+    return buffer;
+}
+
+int main(int argc, const char* argv[])
+{
+    argparse::ArgumentParser parser("match", WEECHESS_PROJECT_VERSION, argparse::default_arguments::none);
+    parser.add_description("Play two engines against each other and test which is stronger. An engine is either "
+                           "weechess, optionally with search features turned off as in "
+                           "weechess:no-check-extensions,no-singular-extensions,no-iir, or the path to a UCI engine");
+    parser.add_argument("--help").default_value(false).implicit_value(true);
+    parser.add_argument("--games")
+        .help("Play at most this many games, each opening twice with the colors swapped")
+        .default_value(static_cast<size_t>(1000))
+        .scan<'u', size_t>();
+    parser.add_argument("--concurrency")
+        .help("Number of games to play at once")
+        .default_value(threading::ThreadPool::default_thread_count())
+        .scan<'u', size_t>();
+    parser.add_argument("--nodes").help("Search this many nodes for every move").scan<'u', size_t>();
+    parser.add_argument("--tc")
+        .help("A clock for each side, as seconds plus an increment in seconds per move")
+        .default_value(std::string("10+0.1"));
+    parser.add_argument("--hash")
+        .help("Transposition table size in MB for weechess")
+        .default_value(static_cast<size_t>(16))
+        .scan<'u', size_t>();
+    parser.add_argument("--openings").metavar("FILE").help("Start games from the positions of an EPD file");
+    parser.add_argument("--book-plies")
+        .help("Otherwise, start games with this many plies picked from the book")
+        .default_value(static_cast<size_t>(8))
+        .scan<'u', size_t>();
+    parser.add_argument("--seed")
+        .help("Seed for picking openings")
+        .default_value(static_cast<unsigned int>(std::random_device()()))
+        .scan<'u', unsigned int>();
+    parser.add_argument("--max-plies")
+        .help("Call a game drawn once it's this long")
+        .default_value(static_cast<size_t>(400))
+        .scan<'u', size_t>();
+    parser.add_argument("--resign-score")
+        .help("Resign for a side when both engines score it this many centipawns behind...")
+        .default_value(800)
+        .scan<'i', int>();
+    parser.add_argument("--resign-moves")
+        .help("...for this many moves each")
+        .default_value(static_cast<size_t>(4))
+        .scan<'u', size_t>();
+    parser.add_argument("--draw-score")
+        .help("Call a game drawn when both engines score it within this many centipawns...")
+        .default_value(10)
+        .scan<'i', int>();
+    parser.add_argument("--draw-moves")
+        .help("...for this many moves each, or 0 to never call draws")
+        .default_value(static_cast<size_t>(8))
+        .scan<'u', size_t>();
+    parser.add_argument("--draw-after")
+        .help("...from this move number on")
+        .default_value(static_cast<size_t>(40))
+        .scan<'u', size_t>();
+    parser.add_argument("--elo0").help("Elo difference for H0").default_value(0.0).scan<'g', double>();
+    parser.add_argument("--elo1").help("Elo difference for H1").default_value(5.0).scan<'g', double>();
+    parser.add_argument("--alpha").help("Chance of accepting H1 when H0 holds").default_value(0.05).scan<'g', double>();
+    parser.add_argument("--beta").help("Chance of accepting H0 when H1 holds").default_value(0.05).scan<'g', double>();
+    parser.add_argument("--pgn").metavar("FILE").help("Append every game to this file");
+    parser.add_argument("engines").remaining();
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::runtime_error& err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+
+    if (parser.get<bool>("--help")) {
+        std::cout << parser;
+        std::exit(0);
+    }
+
+    std::vector<std::string> specs;
+    try {
+        specs = parser.get<std::vector<std::string>>("engines");
+    } catch (std::logic_error& e) {
+    }
+
+    if (specs.size() != 2) {
+        std::cout << "Two engines are needed for a match." << std::endl;
+        std::cout << parser;
+        std::exit(1);
+    }
+
+    TimeControl time_control;
+    if (auto nodes = parser.present<size_t>("--nodes")) {
+        time_control.nodes = std::max<size_t>(*nodes, 1);
+    } else if (auto clock = TimeControl::from_string(parser.get<std::string>("--tc"))) {
+        time_control = *clock;
+    } else {
+        std::cerr << "Bad time control: " << parser.get<std::string>("--tc") << std::endl;
+        std::exit(1);
+    }
+
+    SPRT sprt {
+        .elo0 = parser.get<double>("--elo0"),
+        .elo1 = parser.get<double>("--elo1"),
+        .alpha = parser.get<double>("--alpha"),
+        .beta = parser.get<double>("--beta"),
+    };
+
+    if (!(sprt.alpha > 0 && sprt.alpha < 1 && sprt.beta > 0 && sprt.beta < 1) || sprt.elo1 <= sprt.elo0) {
+        std::cerr << "The SPRT needs alpha and beta between 0 and 1, and elo1 above elo0" << std::endl;
+        std::exit(1);
+    }
+
+    Adjudication adjudication {
+        .max_plies = parser.get<size_t>("--max-plies"),
+        .resign_score = parser.get<int>("--resign-score"),
+        .resign_moves = parser.get<size_t>("--resign-moves"),
+        .draw_score = parser.get<int>("--draw-score"),
+        .draw_moves = parser.get<size_t>("--draw-moves"),
+        .draw_move_number = parser.get<size_t>("--draw-after"),
+    };
+
+    // The library logs every iteration of the search, which would drown out the results. Engines that have
+    // gone away show up as failed writes rather than signals
+    auto lib_logger = spdlog::stderr_color_mt("weechess");
+    lib_logger->set_level(spdlog::level::warn);
+    signal(SIGPIPE, SIG_IGN);
+
+    auto hash_size_in_bytes = std::max<size_t>(parser.get<size_t>("--hash"), 1) * 1024 * 1024;
+    auto first = parse_side(specs[0], hash_size_in_bytes);
+    auto second = parse_side(specs[1], hash_size_in_bytes);
+    if (!first.has_value() || !second.has_value())
+        std::exit(1);
+
+    if (first->name == second->name) {
+        first->name += " (1)";
+        second->name += " (2)";
+    }
+
+    auto game_count = std::max<size_t>(parser.get<size_t>("--games"), 1);
+    auto seed = parser.get<unsigned int>("--seed");
+    auto opening_count = (game_count + 1) / 2;
+
+    std::vector<Opening> openings;
+    if (auto path = parser.present<std::string>("--openings")) {
+        auto epd_openings = openings_from_epd(*path, opening_count, seed);
+        if (!epd_openings.has_value())
+            std::exit(1);
+
+        openings = std::move(*epd_openings);
+    } else {
+        openings = openings_from_book(opening_count, parser.get<size_t>("--book-plies"), seed);
+    }
+
+    std::ofstream pgn;
+    if (auto path = parser.present<std::string>("--pgn")) {
+        pgn.open(*path, std::ios::app);
+        if (!pgn) {
+            std::cerr << "Unable to open PGN file: " << *path << std::endl;
+            std::exit(1);
+        }
+    }
+
+    auto date = today();
+    std::cerr << "Playing up to " << game_count << " games of " << first->name << " vs " << second->name
+              << ", seed " << seed << std::endl;
+
+    // Games are handed out in order, so both games of an opening are played close together
+    std::mutex mutex;
+    Score score;
+    auto decision = SPRT::Decision::Continue;
+    std::atomic<size_t> next_game { 0 };
+    threading::Token stop;
+
+    auto record_game = [&](size_t game, const GameRecord& record) {
+        std::lock_guard lock(mutex);
+        if (stop.invalidated())
+            return;
+
+        auto first_is_white = game % 2 == 0;
+        if (record.result == Result::Draw) {
+            score.draws++;
+        } else if ((record.result == Result::WhiteWins) == first_is_white) {
+            score.wins++;
+        } else {
+            score.losses++;
+        }
+
+        if (pgn.is_open())
+            write_pgn(pgn, record, time_control, date);
+
+        std::cerr << "Game " << game + 1 << " (" << record.white << " vs " << record.black
+                  << "): " << result_string(record.result) << " {" << record.reason << "}" << std::endl;
+        write_standing(std::cerr, first->name, second->name, score, sprt);
+
+        decision = sprt.decide(score);
+        if (decision != SPRT::Decision::Continue)
+            stop.invalidate();
+    };
+
+    // An engine that crashed or stopped answering would lose every game left to it, so it's replaced
+    // with a fresh one. The match can't go on fairly if that fails too
+    std::atomic<bool> restart_failed { false };
+    auto restart_if_unresponsive = [&](const Side& side, std::unique_ptr<Player>& player) {
+        if (player->is_responsive())
+            return true;
+
+        player = side.make_player();
+
+        std::lock_guard lock(mutex);
+        if (player == nullptr) {
+            std::cerr << "Unable to restart " << side.name << ", stopping the match" << std::endl;
+            restart_failed = true;
+            return false;
+        }
+
+        std::cerr << "Restarted " << side.name << " after it stopped responding" << std::endl;
+        return true;
+    };
+
+    {
+        auto concurrency = std::max<size_t>(parser.get<size_t>("--concurrency"), 1);
+        threading::ThreadPool pool(concurrency);
+        for (size_t i = 0; i < concurrency; i++) {
+            pool.submit([&]() {
+                auto first_player = first->make_player();
+                auto second_player = second->make_player();
+                if (first_player == nullptr || second_player == nullptr) {
+                    std::cerr << "Unable to start an engine" << std::endl;
+                    return;
+                }
+
+                for (auto game = next_game++; game < game_count && !stop.invalidated(); game = next_game++) {
+                    if (!restart_if_unresponsive(*first, first_player)
+                        || !restart_if_unresponsive(*second, second_player)) {
+                        stop.invalidate();
+                        break;
+                    }
+
+                    auto pairing = game % 2 == 0
+                        ? Pairing { game + 1, first->name, *first_player, second->name, *second_player }
+                        : Pairing { game + 1, second->name, *second_player, first->name, *first_player };
+
+                    auto record = play_game(pairing, openings[game / 2], time_control, adjudication, stop);
+
+                    if (record.has_value())
+                        record_game(game, *record);
+                }
+            });
+        }
+    }
+
+    std::cout << std::endl;
+    write_standing(std::cout, first->name, second->name, score, sprt);
+    std::cout << std::defaultfloat << "SPRT [" << sprt.elo0 << ", " << sprt.elo1 << "]: ";
+    switch (decision) {
+    case SPRT::Decision::AcceptH1:
+        std::cout << "H1 accepted, " << first->name << " is stronger" << std::endl;
+        break;
+    case SPRT::Decision::AcceptH0:
+        std::cout << "H0 accepted, " << first->name << " isn't stronger" << std::endl;
+        break;
+    case SPRT::Decision::Continue:
+        std::cout << "inconclusive after " << score.games() << " games" << std::endl;
+        break;
+    }
+
+    if (pgn.is_open() && !pgn) {
+        std::cerr << "Failed to write games to the PGN file" << std::endl;
+        std::exit(1);
+    }
+
+    if (restart_failed)
+        std::exit(1);
+}
@@ -0,0 +1,391 @@
+#include <cerrno>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "player.h"
+
+using namespace weechess;
+
+namespace {
+
+    // How long an engine gets to start up, and to answer a fixed node search
+    constexpr auto response_timeout = std::chrono::seconds(60);
+
+    // An engine on a clock gets this long past its flag falling before we stop waiting for it
+    constexpr auto clock_grace_period = std::chrono::seconds(1);
+
+    // How long an engine gets to answer stop once it's missed a deadline, before it's given up on
+    constexpr auto stop_timeout = std::chrono::seconds(5);
+
+    std::string uci_notation(const Move& move)
+    {
+        auto notation = move.to_string();
+        if (move.is_promotion()) {
+            switch (move.promoted_piece_type()) {
+            case Piece::Type::Queen:
+                notation += 'q';
+                break;
+            case Piece::Type::Rook:
+                notation += 'r';
+                break;
+            case Piece::Type::Bishop:
+                notation += 'b';
+                break;
+            case Piece::Type::Knight:
+                notation += 'n';
+                break;
+            default:
+                break;
+            }
+        }
+
+        return notation;
+    }
+
+}
+
+std::string TimeControl::to_pgn() const
+{
+    if (nodes.has_value())
+        return "-";
+
+    std::ostringstream os;
+    os << base.count() / 1000.0 << "+" << increment.count() / 1000.0;
+    return os.str();
+}
+
+std::optional<TimeControl> TimeControl::from_string(std::string_view text)
+{
+    auto plus = text.find('+');
+    try {
+        auto base = std::stod(std::string(text.substr(0, plus)));
+        auto increment = plus != std::string_view::npos ? std::stod(std::string(text.substr(plus + 1))) : 0.0;
+        if (base <= 0 || increment < 0)
+            return {};
+
+        TimeControl time_control;
+        time_control.base = Milliseconds(static_cast<size_t>(base * 1000));
+        time_control.increment = Milliseconds(static_cast<size_t>(increment * 1000));
+        return time_control;
+    } catch (const std::exception&) {
+        return {};
+    }
+}
+
+EnginePlayer::EnginePlayer(const SearchFeatures& features, size_t hash_size_in_bytes)
+    : m_features(features)
+{
+    // Games start from their opening, so the engine's own book would only get in the way
+    m_engine.settings().book_depth = 0;
+    m_engine.settings().perf_event_interval = std::chrono::hours(1);
+    m_engine.settings().transposition_table = std::make_shared<TranspositionTable>(hash_size_in_bytes);
+}
+
+void EnginePlayer::new_game() { m_engine.settings().transposition_table->clear(); }
+
+Reply EnginePlayer::play(const GameSnapshot&,
+    const std::vector<Move>&,
+    const GameState& game_state,
+    const TimeControl& time_control,
+    const Clock& clock,
+    const threading::Token& token)
+{
+    SearchParameters parameters;
+    parameters.features = m_features;
+    parameters.max_nodes = time_control.nodes;
+    parameters.max_search_time = {};
+    if (!time_control.nodes.has_value())
+        parameters.max_search_time = time_for_move(clock.remaining[game_state.turn_to_move()], clock.increment);
+
+    SearchDelegate delegate;
+    auto result = m_engine.calculate(game_state, parameters, token, delegate);
+    if (result.best_line.empty())
+        return {};
+
+    return { result.best_line[0], result.evaluation };
+}
+
+// A child process we talk to a line at a time over its standard input and output
+class Process {
+public:
+    static std::unique_ptr<Process> spawn(const std::string& path)
+    {
+        // Holding this until after the fork means an engine spawned on another thread can't inherit these
+        // pipes before they're marked close-on-exec
+        static std::mutex spawn_mutex;
+        std::lock_guard lock(spawn_mutex);
+
+        int to_child[2];
+        int from_child[2];
+        if (!open_pipe(to_child))
+            return nullptr;
+
+        if (!open_pipe(from_child)) {
+            close(to_child[0]);
+            close(to_child[1]);
+            return nullptr;
+        }
+
+        // Other games are running on other threads, so only async-signal-safe calls are allowed between
+        // fork and exec. Everything the child needs is set up beforehand
+        std::vector<char> path_buffer(path.begin(), path.end());
+        path_buffer.push_back('\0');
+        char* argv[] = { path_buffer.data(), nullptr };
+
+        auto pid = fork();
+        if (pid == 0) {
+            dup2(to_child[0], STDIN_FILENO);
+            dup2(from_child[1], STDOUT_FILENO);
+            execv(argv[0], argv);
+            _exit(127);
+        }
+
+        close(to_child[0]);
+        close(from_child[1]);
+        if (pid < 0) {
+            close(to_child[1]);
+            close(from_child[0]);
+            return nullptr;
+        }
+
+        return std::unique_ptr<Process>(new Process(pid, to_child[1], from_child[0]));
+    }
+
+    Process(const Process&) = delete;
+    Process& operator=(const Process&) = delete;
+
+    ~Process()
+    {
+        close(m_input);
+
+        // Closing its input is as good as quitting for most engines, but not all of them
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (waitpid(m_pid, nullptr, WNOHANG) == 0) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                kill(m_pid, SIGKILL);
+                waitpid(m_pid, nullptr, 0);
+                break;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+
+        close(m_output);
+    }
+
+    bool write_line(std::string_view line)
+    {
+        std::string text(line);
+        text += '\n';
+
+        size_t written = 0;
+        while (written < text.size()) {
+            auto result = write(m_input, text.data() + written, text.size() - written);
+            if (result < 0 && errno == EINTR)
+                continue;
+            if (result <= 0)
+                return false;
+
+            written += static_cast<size_t>(result);
+        }
+
+        return true;
+    }
+
+    // Nothing if the process didn't finish a line in time, or went away
+    std::optional<std::string> read_line(std::chrono::steady_clock::time_point deadline)
+    {
+        while (true) {
+            auto newline = m_buffer.find('\n');
+            if (newline != std::string::npos) {
+                auto line = m_buffer.substr(0, newline);
+                m_buffer.erase(0, newline + 1);
+                if (!line.empty() && line.back() == '\r')
+                    line.pop_back();
+
+                return line;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            if (now >= deadline)
+                return {};
+
+            pollfd descriptor { .fd = m_output, .events = POLLIN, .revents = 0 };
+            auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1;
+            auto ready = poll(&descriptor, 1, static_cast<int>(timeout));
+            if (ready < 0 && errno != EINTR)
+                return {};
+            if (ready <= 0)
+                continue;
+
+            char chunk[4096];
+            auto result = read(m_output, chunk, sizeof(chunk));
+            if (result < 0 && errno == EINTR)
+                continue;
+            if (result <= 0)
+                return {};
+
+            m_buffer.append(chunk, static_cast<size_t>(result));
+        }
+    }
+
+private:
+    // pipe2 would do this in one go, but it's not available everywhere
+    static bool open_pipe(int fds[2])
+    {
+        if (pipe(fds) != 0)
+            return false;
+
+        if (fcntl(fds[0], F_SETFD, FD_CLOEXEC) != 0 || fcntl(fds[1], F_SETFD, FD_CLOEXEC) != 0) {
+            close(fds[0]);
+            close(fds[1]);
+            return false;
+        }
+
+        return true;
+    }
+
+    Process(pid_t pid, int input, int output)
+        : m_pid(pid)
+        , m_input(input)
+        , m_output(output)
+    {
+    }
+
+    pid_t m_pid;
+    int m_input;
+    int m_output;
+    std::string m_buffer {};
+};
+
+std::unique_ptr<UCIPlayer> UCIPlayer::launch(const std::string& path)
+{
+    auto process = Process::spawn(path);
+    if (process == nullptr)
+        return nullptr;
+
+    auto player = std::unique_ptr<UCIPlayer>(new UCIPlayer(std::move(process)));
+    if (!player->m_process->write_line("uci") || !player->wait_for("uciok"))
+        return nullptr;
+
+    return player;
+}
+
+UCIPlayer::UCIPlayer(std::unique_ptr<Process> process)
+    : m_process(std::move(process))
+{
+}
+
+UCIPlayer::~UCIPlayer() { m_process->write_line("quit"); }
+
+void UCIPlayer::new_game()
+{
+    if (!m_process->write_line("ucinewgame") || !m_process->write_line("isready") || !wait_for("readyok"))
+        m_responsive = false;
+}
+
+bool UCIPlayer::is_responsive() const { return m_responsive; }
+
+Reply UCIPlayer::play(const GameSnapshot& start,
+    const std::vector<Move>& moves,
+    const GameState& game_state,
+    const TimeControl& time_control,
+    const Clock& clock,
+    const threading::Token&)
+{
+    std::ostringstream position;
+    position << "position fen " << start.to_fen();
+    if (!moves.empty()) {
+        position << " moves";
+        for (const auto& move : moves)
+            position << " " << uci_notation(move);
+    }
+
+    std::ostringstream go;
+    auto deadline = std::chrono::steady_clock::now();
+    if (time_control.nodes.has_value()) {
+        go << "go nodes " << *time_control.nodes;
+        deadline += response_timeout;
+    } else {
+        go << "go wtime " << clock.remaining[Color::White].count() << " btime "
+           << clock.remaining[Color::Black].count() << " winc " << clock.increment.count() << " binc "
+           << clock.increment.count();
+        deadline += clock.remaining[game_state.turn_to_move()] + clock_grace_period;
+    }
+
+    if (!m_process->write_line(position.str()) || !m_process->write_line(go.str())) {
+        m_responsive = false;
+        return {};
+    }
+
+    Reply reply;
+    while (auto line = m_process->read_line(deadline)) {
+        std::istringstream in(*line);
+        std::string token;
+        in >> token;
+
+        if (token == "info") {
+            while (in >> token) {
+                if (token != "score")
+                    continue;
+
+                std::string kind;
+                int value;
+                if (!(in >> kind >> value))
+                    break;
+
+                if (kind == "cp") {
+                    reply.evaluation = Evaluation { value };
+                } else if (kind == "mate") {
+                    reply.evaluation = value > 0 ? Evaluation::mate_in(static_cast<size_t>(2 * value - 1))
+                                                 : Evaluation::mated_in(static_cast<size_t>(-2 * value));
+                }
+            }
+        } else if (token == "bestmove") {
+            in >> token;
+            for (const auto& legal_move : game_state.move_set().legal_moves()) {
+                if (uci_notation(legal_move.move()) == token)
+                    reply.move = legal_move.move();
+            }
+
+            return reply;
+        }
+    }
+
+    stop_search();
+    return {};
+}
+
+bool UCIPlayer::wait_for(std::string_view response)
+{
+    auto deadline = std::chrono::steady_clock::now() + response_timeout;
+    while (auto line = m_process->read_line(deadline)) {
+        if (*line == response)
+            return true;
+    }
+
+    return false;
+}
+
+void UCIPlayer::stop_search()
+{
+    if (!m_process->write_line("stop")) {
+        m_responsive = false;
+        return;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + stop_timeout;
+    while (auto line = m_process->read_line(deadline)) {
+        if (line->starts_with("bestmove"))
+            return;
+    }
+
+    m_responsive = false;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <weechess/color_map.h>
+#include <weechess/engine.h>
+#include <weechess/game_state.h>
+#include <weechess/threading.h>
+
+using Milliseconds = std::chrono::duration<size_t, std::milli>;
+
+// Either a fixed number of nodes for every move, or a clock with an increment
+struct TimeControl {
+    std::optional<size_t> nodes;
+    Milliseconds base { 0 };
+    Milliseconds increment { 0 };
+
+    std::string to_pgn() const;
+
+    // Seconds, as in "10+0.1"
+    static std::optional<TimeControl> from_string(std::string_view);
+};
+
+struct Clock {
+    weechess::ColorMap<Milliseconds> remaining;
+    Milliseconds increment;
+};
+
+struct Reply {
+    std::optional<weechess::Move> move;
+
+    // From the point of view of the side that moved, when the player gave one
+    std::optional<weechess::Evaluation> evaluation;
+};
+
+// One side of a game. Players are only used by one game at a time, and are told about the whole game
+// so far on every move, so they don't need to keep track of it themselves
+class Player {
+public:
+    virtual ~Player() = default;
+
+    virtual void new_game() { }
+
+    // False once the player has stopped answering, and needs replacing before its next game
+    virtual bool is_responsive() const { return true; }
+
+    virtual Reply play(const weechess::GameSnapshot& start,
+        const std::vector<weechess::Move>& moves,
+        const weechess::GameState& game_state,
+        const TimeControl&,
+        const Clock&,
+        const weechess::threading::Token&)
+        = 0;
+};
+
+// The engine in this process, with some search features turned off to measure what they're worth
+class EnginePlayer : public Player {
+public:
+    EnginePlayer(const weechess::SearchFeatures&, size_t hash_size_in_bytes);
+
+    void new_game() override;
+    Reply play(const weechess::GameSnapshot& start,
+        const std::vector<weechess::Move>& moves,
+        const weechess::GameState& game_state,
+        const TimeControl&,
+        const Clock&,
+        const weechess::threading::Token&) override;
+
+private:
+    weechess::Engine m_engine;
+    weechess::SearchFeatures m_features;
+};
+
+class Process;
+
+// Any UCI engine, run as a child process
+class UCIPlayer : public Player {
+public:
+    // Nothing if the engine couldn't be started, or didn't answer the uci command
+    static std::unique_ptr<UCIPlayer> launch(const std::string& path);
+    ~UCIPlayer() override;
+
+    void new_game() override;
+    bool is_responsive() const override;
+    Reply play(const weechess::GameSnapshot& start,
+        const std::vector<weechess::Move>& moves,
+        const weechess::GameState& game_state,
+        const TimeControl&,
+        const Clock&,
+        const weechess::threading::Token&) override;
+
+private:
+    explicit UCIPlayer(std::unique_ptr<Process>);
+
+    bool wait_for(std::string_view response);
+
+    // Tells an engine that missed its deadline to stop, and reads up to the move it finally gives so
+    // that it isn't taken as the answer to the next position
+    void stop_search();
+
+    std::unique_ptr<Process> m_process;
+    bool m_responsive { true };
+};
@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <cmath>
+
+#include "sprt.h"
+
+namespace {
+
+    double elo_from_ratio(double ratio) { return 400 * std::log10(ratio / (1 - ratio)); }
+    double ratio_from_elo(double elo) { return 1 / (1 + std::pow(10, -elo / 400)); }
+
+}
+
+size_t Score::games() const { return wins + draws + losses; }
+
+double Score::ratio() const { return games() != 0 ? (wins + 0.5 * draws) / games() : 0.5; }
+
+double Score::variance() const
+{
+    if (games() == 0)
+        return 0;
+
+    auto mean = ratio();
+    auto n = static_cast<double>(games());
+    return (wins / n) * (1 - mean) * (1 - mean) + (draws / n) * (0.5 - mean) * (0.5 - mean)
+        + (losses / n) * mean * mean;
+}
+
+EloEstimate EloEstimate::from(const Score& score)
+{
+    EloEstimate estimate { 0, 0, 0.5 };
+    if (score.wins + score.losses != 0) {
+        auto difference = static_cast<double>(score.wins) - static_cast<double>(score.losses);
+        auto decisive = static_cast<double>(score.wins + score.losses);
+        estimate.los = 0.5 * (1 + std::erf(difference / std::sqrt(2 * decisive)));
+    }
+
+    auto ratio = score.ratio();
+    if (ratio <= 0 || ratio >= 1) {
+        estimate.elo = ratio <= 0 ? -INFINITY : INFINITY;
+        estimate.margin = INFINITY;
+        return estimate;
+    }
+
+    // From the normal approximation to the mean result
+    auto deviation = 1.959964 * std::sqrt(score.variance() / static_cast<double>(score.games()));
+    auto lower = std::clamp(ratio - deviation, 1e-9, 1 - 1e-9);
+    auto upper = std::clamp(ratio + deviation, 1e-9, 1 - 1e-9);
+
+    estimate.elo = elo_from_ratio(ratio);
+    estimate.margin = (elo_from_ratio(upper) - elo_from_ratio(lower)) / 2;
+    return estimate;
+}
+
+double SPRT::lower_bound() const { return std::log(beta / (1 - alpha)); }
+
+double SPRT::upper_bound() const { return std::log((1 - beta) / alpha); }
+
+double SPRT::llr(const Score& score) const
+{
+    auto variance = score.variance();
+    if (variance <= 0)
+        return 0;
+
+    auto s0 = ratio_from_elo(elo0);
+    auto s1 = ratio_from_elo(elo1);
+    auto n = static_cast<double>(score.games());
+    return (s1 - s0) * (2 * score.ratio() - s0 - s1) / (2 * variance / n);
+}
+
+SPRT::Decision SPRT::decide(const Score& score) const
+{
+    auto value = llr(score);
+    if (value >= upper_bound())
+        return Decision::AcceptH1;
+    if (value <= lower_bound())
+        return Decision::AcceptH0;
+
+    return Decision::Continue;
+}
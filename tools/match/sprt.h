@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+
+// Wins, draws and losses for the first engine in a match
+struct Score {
+    size_t wins { 0 };
+    size_t draws { 0 };
+    size_t losses { 0 };
+
+    size_t games() const;
+    double ratio() const;
+
+    // The variance of a single game's result
+    double variance() const;
+};
+
+struct EloEstimate {
+    double elo;
+
+    // Half the width of the 95% confidence interval
+    double margin;
+
+    // The likelihood of superiority, the chance that the first engine is the stronger one
+    double los;
+
+    static EloEstimate from(const Score&);
+};
+
+// A sequential probability ratio test between the first engine being elo0 stronger (H0) and elo1
+// stronger (H1). This uses the normal approximation to the generalized SPRT over wins, draws and
+// losses, which is what engine testing frameworks use for logistic Elo bounds
+struct SPRT {
+    double elo0;
+    double elo1;
+    double alpha;
+    double beta;
+
+    enum class Decision { Continue, AcceptH0, AcceptH1 };
+
+    double lower_bound() const;
+    double upper_bound() const;
+
+    // The log likelihood ratio of H1 against H0
+    double llr(const Score&) const;
+    Decision decide(const Score&) const;
+};
@@ -0,0 +1,77 @@
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+#include <argparse/argparse.h>
+
+#include "slider_attacks.h"
+
+using namespace weechess;
+using slider_attacks::SliderBackend;
+using slider_attacks::SliderTable;
+
+void write_table(std::ostream& os, std::string_view name, SliderBackend backend)
+{
+    // The table is too large to comfortably live on the stack
+    auto table = std::make_unique<SliderTable>();
+    slider_attacks::fill_slider_table(*table, backend);
+
+    os << "constinit const slider_attacks::SliderTable " << name << " = { {" << std::endl;
+    for (size_t i = 0; i < table->size(); i++) {
+        os << (i % 4 == 0 ? "    " : " ");
+        os << "0x" << std::hex << std::setw(16) << std::setfill('0') << (*table)[i].data() << std::dec << "ULL,";
+        if (i % 4 == 3 || i + 1 == table->size())
+            os << std::endl;
+    }
+    os << "} };" << std::endl;
+}
+
+int main(int argc, const char* argv[])
+{
+    argparse::ArgumentParser parser("slidergen", WEECHESS_PROJECT_VERSION, argparse::default_arguments::none);
+    parser.add_description("Generate the rook and bishop attack tables that are compiled into the weechess library");
+    parser.add_argument("--help").default_value(false).implicit_value(true);
+    parser.add_argument("output").help("Path of the source file to write");
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::runtime_error& err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+
+    if (parser.get<bool>("--help")) {
+        std::cout << parser;
+        std::exit(0);
+    }
+
+    auto path = parser.get<std::string>("output");
+    std::ofstream os(path);
+    if (!os) {
+        std::cerr << "Unable to open output file: " << path << std::endl;
+        std::exit(1);
+    }
+
+    os << "// Generated by weechess-slidergen, do not edit" << std::endl;
+    os << std::endl;
+    os << "#include \"generated/slider_tables.h\"" << std::endl;
+    os << std::endl;
+    os << "namespace weechess::generated {" << std::endl;
+    os << std::endl;
+    os << "// clang-format off" << std::endl;
+    write_table(os, "magic_slider_table", SliderBackend::Magic);
+    os << std::endl;
+    os << "#ifdef WEECHESS_HAS_PEXT" << std::endl;
+    write_table(os, "pext_slider_table", SliderBackend::Pext);
+    os << "#endif" << std::endl;
+    os << "// clang-format on" << std::endl;
+    os << std::endl;
+    os << "}" << std::endl;
+
+    if (!os) {
+        std::cerr << "Failed to write output file: " << path << std::endl;
+        std::exit(1);
+    }
+}
@@ -0,0 +1,430 @@
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <argparse/argparse.h>
+#include <weechess/evaluator.h>
+#include <weechess/game_state.h>
+#include <weechess/move_query.h>
+#include <weechess/pgn.h>
+#include <weechess/threading.h>
+
+using namespace weechess;
+
+struct Game {
+    std::vector<std::string> moves;
+    double result;
+};
+
+// Positions are stored separately from their results so the evaluator
+// can run over the whole set as one contiguous batch
+struct TrainingSet {
+    std::vector<GameSnapshot> positions;
+    std::vector<double> results;
+
+    void append(const TrainingSet& other)
+    {
+        positions.insert(positions.end(), other.positions.begin(), other.positions.end());
+        results.insert(results.end(), other.results.begin(), other.results.end());
+    }
+};
+
+struct Options {
+    size_t skip_plies;
+    size_t threads;
+};
+
+std::optional<double> parse_result(std::string_view token)
+{
+    if (token == "1-0") {
+        return 1.0;
+    } else if (token == "0-1") {
+        return 0.0;
+    } else if (token == "1/2-1/2") {
+        return 0.5;
+    }
+
+    return {};
+}
+
+void read_games(const std::string& filename, std::vector<Game>& games)
+{
+    auto archive = pgn::Archive::open(filename);
+    if (!archive.has_value()) {
+        std::cerr << "Could not open file: " << filename << std::endl;
+        std::exit(1);
+    }
+
+    auto reader = archive->reader();
+    while (auto game = reader.next()) {
+        auto result = parse_result(game->tag("Result").value_or(game->result));
+        if (!result.has_value() || game->moves.empty())
+            continue;
+
+        games.push_back({ std::vector<std::string>(game->moves.begin(), game->moves.end()), *result });
+    }
+}
+
+// A quiet position is one where the static evaluation can be trusted: the side to
+// move isn't in check, and there's no capture that obviously wins material
+bool is_quiet(const GameState& game_state, const Move& next_move)
+{
+    if (next_move.is_capture() || next_move.is_promotion())
+        return false;
+
+    if (game_state.is_check())
+        return false;
+
+    for (const auto& legal_move : game_state.move_set().legal_moves()) {
+        const auto& move = legal_move.move();
+        if (!move.is_capture())
+            continue;
+
+        if (Evaluation::piece_worth(move.captured_piece_type()) > Evaluation::piece_worth(move.moving_piece().type))
+            return false;
+
+        const auto& snapshot = legal_move.snapshot();
+        if (!snapshot.board.attacks(snapshot.turn_to_move)[move.end_location()])
+            return false;
+    }
+
+    return true;
+}
+
+void extract_positions(std::span<const Game> games, const Options& options, TrainingSet& training_set)
+{
+    for (const auto& game : games) {
+        auto game_state = GameState::new_game();
+        for (size_t ply = 0; ply < game.moves.size(); ply++) {
+            auto query = PGNMoveQuery::from(game.moves[ply]);
+            if (!query.has_value())
+                break;
+
+            auto possible_moves = game_state.move_set().find(*query);
+            if (possible_moves.size() != 1)
+                break;
+
+            const auto& legal_move = possible_moves[0];
+            if (ply >= options.skip_plies && is_quiet(game_state, legal_move.move())) {
+                training_set.positions.push_back(game_state.snapshot());
+                training_set.results.push_back(game.result);
+            }
+
+            game_state = GameState(legal_move.snapshot());
+        }
+    }
+}
+
+TrainingSet build_training_set(std::span<const Game> games, const Options& options, threading::ThreadPool& pool)
+{
+    std::vector<TrainingSet> partial_sets(pool.size());
+    std::vector<std::future<void>> tasks;
+
+    auto chunk_size = (games.size() + pool.size() - 1) / pool.size();
+    for (size_t i = 0; i < pool.size(); i++) {
+        auto begin = std::min(games.size(), i * chunk_size);
+        auto end = std::min(games.size(), begin + chunk_size);
+        tasks.push_back(pool.submit([&, i, begin, end]() {
+            extract_positions(games.subspan(begin, end - begin), options, partial_sets[i]);
+        }));
+    }
+
+    TrainingSet training_set;
+    for (size_t i = 0; i < pool.size(); i++) {
+        tasks[i].get();
+        training_set.append(partial_sets[i]);
+    }
+
+    return training_set;
+}
+
+// Mean squared error between the game results and the evaluator's predicted
+// results, where the prediction maps a centipawn score onto [0, 1]
+class LossFunction {
+public:
+    LossFunction(const TrainingSet& training_set, threading::ThreadPool& pool)
+        : m_training_set(training_set)
+        , m_evaluations(training_set.positions.size())
+        , m_pool(pool)
+    {
+    }
+
+    // Called thousands of times while tuning, so the chunks run on the same pool of
+    // workers every time rather than on freshly created threads
+    double operator()(const EvaluatorWeights& weights, double k)
+    {
+        Evaluator evaluator(weights);
+        std::vector<std::future<double>> partial_losses;
+
+        auto size = m_training_set.positions.size();
+        auto chunk_size = (size + m_pool.size() - 1) / m_pool.size();
+        for (size_t i = 0; i < m_pool.size(); i++) {
+            auto begin = std::min(size, i * chunk_size);
+            auto end = std::min(size, begin + chunk_size);
+            partial_losses.push_back(m_pool.submit([&, begin, end]() { return loss(evaluator, k, begin, end); }));
+        }
+
+        double total = 0.0;
+        for (auto& partial_loss : partial_losses)
+            total += partial_loss.get();
+
+        return total / static_cast<double>(size);
+    }
+
+private:
+    const TrainingSet& m_training_set;
+    std::vector<Evaluation> m_evaluations;
+    threading::ThreadPool& m_pool;
+
+    double loss(const Evaluator& evaluator, double k, size_t begin, size_t end)
+    {
+        auto positions = std::span(m_training_set.positions).subspan(begin, end - begin);
+        auto evaluations = std::span(m_evaluations).subspan(begin, end - begin);
+        evaluator.evaluate(positions, evaluations);
+
+        double total = 0.0;
+        for (size_t i = begin; i < end; i++) {
+            auto score = static_cast<double>(m_evaluations[i].score);
+            if (m_training_set.positions[i].turn_to_move == Color::Black)
+                score = -score;
+
+            auto prediction = 1.0 / (1.0 + std::pow(10.0, -k * score / 400.0));
+            auto error = m_training_set.results[i] - prediction;
+            total += error * error;
+        }
+
+        return total;
+    }
+};
+
+// Golden-section search for the scaling constant that best fits the current weights
+double optimize_scaling_constant(LossFunction& loss, const EvaluatorWeights& weights)
+{
+    const double ratio = (std::sqrt(5.0) - 1.0) / 2.0;
+    double a = 0.1;
+    double b = 4.0;
+    while (b - a > 0.001) {
+        auto c = b - ratio * (b - a);
+        auto d = a + ratio * (b - a);
+        if (loss(weights, c) < loss(weights, d)) {
+            b = d;
+        } else {
+            a = c;
+        }
+    }
+
+    return (a + b) / 2.0;
+}
+
+std::vector<int*> tunable_parameters(EvaluatorWeights& weights)
+{
+    std::vector<int*> parameters;
+
+    for (auto type : Piece::types) {
+        if (type != Piece::Type::King)
+            parameters.push_back(&weights.material[static_cast<int>(type)]);
+    }
+
+    for (auto type : Piece::types) {
+        for (size_t i = 0; i < 64; i++) {
+            // Pawns never stand on the first or last rank
+            if (type == Piece::Type::Pawn && (i < 8 || i >= 56))
+                continue;
+
+            parameters.push_back(&weights.piece_squares[static_cast<int>(type)][i]);
+        }
+    }
+
+    for (size_t i = 0; i < 64; i++) {
+        parameters.push_back(&weights.king_end_game_squares[i]);
+    }
+
+    return parameters;
+}
+
+// Texel's local search: nudge each weight in either direction and keep the change
+// whenever it lowers the error, until a full pass makes no improvement
+EvaluatorWeights optimize_weights(
+    LossFunction& loss, EvaluatorWeights weights, double k, size_t max_iterations, int step)
+{
+    auto parameters = tunable_parameters(weights);
+    auto best_loss = loss(weights, k);
+
+    for (size_t iteration = 0; iteration < max_iterations; iteration++) {
+        size_t improvements = 0;
+        for (auto parameter : parameters) {
+            *parameter += step;
+            if (auto new_loss = loss(weights, k); new_loss < best_loss) {
+                best_loss = new_loss;
+                improvements++;
+                continue;
+            }
+
+            *parameter -= 2 * step;
+            if (auto new_loss = loss(weights, k); new_loss < best_loss) {
+                best_loss = new_loss;
+                improvements++;
+                continue;
+            }
+
+            *parameter += step;
+        }
+
+        std::cerr << "Iteration " << (iteration + 1) << ": error = " << std::setprecision(8) << best_loss << " ("
+                  << improvements << " weights changed)" << std::endl;
+
+        if (improvements == 0)
+            break;
+    }
+
+    return weights;
+}
+
+void write_squares(std::ostream& os, const std::array<int, 64>& squares, std::string_view indent)
+{
+    for (size_t rank = 0; rank < 8; rank++) {
+        os << indent;
+        for (size_t file = 0; file < 8; file++) {
+            os << std::setw(4) << squares[rank * 8 + file] << ",";
+        }
+
+        os << std::endl;
+    }
+}
+
+void write_header(std::ostream& os, const EvaluatorWeights& weights)
+{
+    constexpr std::array<std::string_view, 7> type_names = {
+        "None", "Pawn", "Knight", "Bishop", "Rook", "Queen", "King (middle game)",
+    };
+
+    os << "#pragma once" << std::endl;
+    os << std::endl;
+    os << "#include <weechess/evaluator.h>" << std::endl;
+    os << std::endl;
+    os << "namespace weechess::generated {" << std::endl;
+    os << std::endl;
+    os << "// clang-format off" << std::endl;
+    os << "constexpr EvaluatorWeights evaluator_weights = {" << std::endl;
+
+    os << "    .material = {";
+    for (size_t i = 0; i < weights.material.size(); i++) {
+        os << (i == 0 ? " " : ", ") << weights.material[i];
+    }
+    os << " }," << std::endl;
+
+    os << "    .piece_squares = { {" << std::endl;
+    for (size_t i = 0; i < weights.piece_squares.size(); i++) {
+        os << "        // " << type_names[i] << std::endl;
+        os << "        {" << std::endl;
+        write_squares(os, weights.piece_squares[i], "            ");
+        os << "        }," << std::endl;
+    }
+    os << "    } }," << std::endl;
+
+    os << "    .king_end_game_squares = {" << std::endl;
+    write_squares(os, weights.king_end_game_squares, "        ");
+    os << "    }," << std::endl;
+
+    os << "};" << std::endl;
+    os << "// clang-format on" << std::endl;
+    os << std::endl;
+    os << "}" << std::endl;
+}
+
+int main(int argc, const char* argv[])
+{
+    argparse::ArgumentParser parser("tune", WEECHESS_PROJECT_VERSION, argparse::default_arguments::none);
+    parser.add_description("Tune the weechess evaluator weights against the results of PGN archives");
+    parser.add_argument("--help").default_value(false).implicit_value(true);
+    parser.add_argument("--threads")
+        .help("Number of worker threads")
+        .default_value(threading::ThreadPool::default_thread_count())
+        .scan<'u', size_t>();
+    parser.add_argument("--iterations")
+        .help("Maximum number of local search passes over the weights")
+        .default_value(static_cast<size_t>(100))
+        .scan<'u', size_t>();
+    parser.add_argument("--max-positions")
+        .help("Limit the training set to a random sample of this many positions")
+        .default_value(static_cast<size_t>(0))
+        .scan<'u', size_t>();
+    parser.add_argument("--skip-plies")
+        .help("Ignore positions from the opening phase of each game")
+        .default_value(static_cast<size_t>(16))
+        .scan<'u', size_t>();
+    parser.add_argument("archives").remaining();
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::runtime_error& err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+
+    if (parser.get<bool>("--help")) {
+        std::cout << parser;
+        std::exit(0);
+    }
+
+    std::vector<std::string> input_files;
+    try {
+        input_files = parser.get<std::vector<std::string>>("archives");
+    } catch (std::logic_error& e) {
+        std::cout << "No archive files provided." << std::endl;
+        std::cout << parser;
+        std::exit(1);
+    }
+
+    Options options {
+        .skip_plies = parser.get<size_t>("--skip-plies"),
+        .threads = std::max(static_cast<size_t>(1), parser.get<size_t>("--threads")),
+    };
+
+    std::vector<Game> games;
+    for (const auto& filename : input_files) {
+        std::cerr << "Processing file: " << filename << std::endl;
+        read_games(filename, games);
+    }
+
+    threading::ThreadPool pool(options.threads);
+    auto training_set = build_training_set(games, options, pool);
+    if (training_set.positions.empty()) {
+        std::cerr << "No quiet positions found in the provided archives" << std::endl;
+        std::exit(1);
+    }
+
+    if (auto max_positions = parser.get<size_t>("--max-positions");
+        max_positions > 0 && max_positions < training_set.positions.size()) {
+        std::vector<size_t> indexes(training_set.positions.size());
+        std::iota(indexes.begin(), indexes.end(), 0);
+        std::shuffle(indexes.begin(), indexes.end(), std::default_random_engine(0));
+
+        TrainingSet sample;
+        for (size_t i = 0; i < max_positions; i++) {
+            sample.positions.push_back(training_set.positions[indexes[i]]);
+            sample.results.push_back(training_set.results[indexes[i]]);
+        }
+
+        training_set = std::move(sample);
+    }
+
+    std::cerr << "Tuning with " << training_set.positions.size() << " positions from " << games.size() << " games"
+              << std::endl;
+
+    LossFunction loss(training_set, pool);
+    auto initial_weights = Evaluator::default_instance.weights();
+    auto k = optimize_scaling_constant(loss, initial_weights);
+    std::cerr << "Scaling constant: " << k << ", initial error = " << std::setprecision(8)
+              << loss(initial_weights, k) << std::endl;
+
+    auto weights = optimize_weights(loss, initial_weights, k, parser.get<size_t>("--iterations"), 1);
+    write_header(std::cout, weights);
+}